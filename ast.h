@@ -2,25 +2,45 @@
 #define DECAFPARSER_AST_H
 
 #include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <sstream>
 #include <stack>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "diagnostics.h"
+#include "flat_ast.h"
+#include "stack_guard.h"
 #include "symbol_table.h"
 #include "tac.h"
 
 /////////////////////////////////////////////////////////////////////////////////
 
+// The values that the int variable 'var' takes in the body of a for loop, from
+// 'low' to 'high'.
+struct LoopRange {
+  std::string var;
+  int64_t low;
+  int64_t high;
+};
+
 struct Data {
   Data(SymbolTable& st)
       : sym_table(st),
+        error_count(0),
         variable_no(0),
         label_no(0),
         expr_return_type(ValueType::VoidVal) {}
 
   SymbolTable& sym_table;  // Reference to the symbol-table; do not delete.
 
+  int error_count;  // Errors reported; the code is unusable if any.
+
   int variable_no;  // Counters for increasing the numbers of
   int label_no;     // variables and labels.
 
@@ -31,21 +51,65 @@ struct Data {
   std::string expr_return_var;  // Variable used to store expr value.
   ValueType expr_return_type;   // Type of expression evaluated.
 
+  Diagnostics diagnostics;  // The warnings and errors, until flushed.
+  SourceLocation location;  // Of the statement or declaration being generated.
+
+  std::vector<LoopRange> loop_ranges;  // Of the enclosing for loops whose
+                                       // variable's range is known.
+
+  // The entries that resolve_names() bound the variable uses and method calls
+  // to, by node. They are kept here rather than on the nodes, so that code
+  // generation only reads the AST.
+  std::unordered_map<const void*, const SymbolTable::Entry*> symbols;
+
+  // The entry bound to 'node', or nullptr if its name is undeclared.
+  const SymbolTable::Entry* symbol(const void* node) const {
+    auto it = symbols.find(node);
+    return it == symbols.end() ? nullptr : it->second;
+  }
+
   // You may add/remove data members to this structure as you see fit.
 };
 
-inline void warning_msg(std::string message) {
-  std::cout << "WARNING: " << message << std::endl;
+// Diagnostics are collected in data.diagnostics, to be written out at the end.
+inline void warning_msg(Data& data, DiagId id, std::string message,
+                        SourceLocation location = SourceLocation()) {
+  data.diagnostics.report(Severity::Warning, id, std::move(message),
+                          location.line != 0 ? location : data.location);
+}
+
+// Report an error and carry on, so that all errors are reported in one run.
+inline void error_msg(Data& data, DiagId id, std::string message,
+                      SourceLocation location = SourceLocation()) {
+  data.diagnostics.report(Severity::Error, id, std::move(message),
+                          location.line != 0 ? location : data.location);
+  ++data.error_count;
 }
 
-inline void error_msg(std::string message) {
-  std::cout << "ERROR: " << message << std::endl;
-  throw;
+// In typed code, convert 'var', of type 'from', to type 'to' in a new
+// temporary, which is returned. Otherwise, or if the types are the same or
+// one of them is void, 'var' is returned as it is.
+inline std::string convert(Data& data, TAC& tac, const std::string& var,
+                           ValueType from, ValueType to) {
+  if (!tac.typed() || from == to || from == ValueType::VoidVal ||
+      to == ValueType::VoidVal) {
+    return var;
+  }
+  std::string result = tac.tmp_variable_name(data.variable_no++);
+  tac.append(TAC::InstrType::VAR, result);
+  tac.append(to == ValueType::RealVal ? TAC::InstrType::ITOF
+                                      : TAC::InstrType::FTOI,
+             var, result);
+  return result;
 }
 
-inline void add_to_symbol_table(SymbolTable& st, EntryType entry_type,
-                                std::string scope, std::string name,
-                                ValueType value_type, std::string signature) {
+// Returns the new entry, or nullptr if 'name' was declared in 'scope' already.
+inline SymbolTable::Entry* add_to_symbol_table(
+    Data& data, EntryType entry_type, const std::string& scope,
+    const std::string& name, ValueType value_type,
+    const Signature& signature = Signature(),
+    SourceLocation location = SourceLocation()) {
+  SymbolTable& st = data.sym_table;
   SymbolTable::Entry* entry = st.lookup(scope, name);
   if (entry == nullptr) {
     SymbolTable::Entry entry;
@@ -54,58 +118,475 @@ inline void add_to_symbol_table(SymbolTable& st, EntryType entry_type,
     entry.entry_type = entry_type;
     entry.value_type = value_type;
     entry.signature = signature;
-    st.add(entry);
+    return st.add(entry);
+  }
+  error_msg(data, DiagId::Redeclared,
+            "Identifier '" + name + "' already declared in scope.", location);
+  return nullptr;
+}
+
+// Declare the global constant 'name' of 'type' as the number 'literal'. Its
+// uses are replaced by the literal, converted to the type of the constant if
+// need be; no code is generated for the declaration itself.
+inline void declare_constant(Data& data, const std::string& name,
+                             ValueType type, const std::string& literal,
+                             const Constant& constant,
+                             SourceLocation location = SourceLocation()) {
+  // A literal out of range has been reported by the parser that read it, and
+  // is taken as it is.
+  std::string value = literal;
+  if (constant.in_range && type == ValueType::RealVal &&
+      constant.type == ValueType::IntVal) {
+    value += ".0";
+  } else if (constant.in_range && type == ValueType::IntVal &&
+             constant.type == ValueType::RealVal) {
+    warning_msg(data, DiagId::AssignType,
+                "Type mismatch in assigning to constant '" + name + "'.",
+                location);
+    if (constant.real_value > -9.2e18 && constant.real_value < 9.2e18) {
+      value = std::to_string(static_cast<int64_t>(constant.real_value));
+    } else {
+      error_msg(data, DiagId::NumberRange,
+                "Number '" + literal + "' is out of range.", location);
+    }
+  }
+  SymbolTable::Entry* entry = add_to_symbol_table(
+      data, EntryType::Constant, "", name, type, Signature(), location);
+  if (entry != nullptr) {
+    entry->value = value;
+  }
+}
+
+// The value of 'literal' if it is an int number literal.
+inline bool int_literal(const std::string& literal, int64_t& value) {
+  Constant constant;
+  if (literal.empty() || !isdigit(static_cast<unsigned char>(literal[0])) ||
+      !parse_literal(literal, constant) ||
+      constant.type != ValueType::IntVal) {
+    return false;
+  }
+  value = constant.int_value;
+  return true;
+}
+
+// The literal that 'operand', a number literal or the name of a constant,
+// stands for; empty if it is neither.
+inline std::string constant_literal(Data& data, const std::string& operand) {
+  if (!operand.empty() && isdigit(static_cast<unsigned char>(operand[0]))) {
+    return operand;
+  }
+  const SymbolTable::Entry* entry =
+      data.sym_table.resolve(data.method_name, operand);
+  if (entry == nullptr || entry->entry_type != EntryType::Constant) {
+    return "";
+  }
+  return entry->value;
+}
+
+// Declare the array 'name' of 'type' in the current scope, with as many
+// elements as 'size', a number literal or the name of a constant, says.
+inline void declare_array(Data& data, TAC& tac, const std::string& name,
+                          ValueType type, const std::string& size,
+                          SourceLocation location = SourceLocation()) {
+  int64_t elements = 0;
+  if (!int_literal(constant_literal(data, size), elements) || elements == 0) {
+    error_msg(data, DiagId::ArraySize,
+              "Size of array '" + name + "' is not a positive int constant.",
+              location);
+    elements = 1;
+  }
+  SymbolTable::Entry* entry =
+      add_to_symbol_table(data, EntryType::Variable, data.method_name, name,
+                          type, Signature(), location);
+  if (entry != nullptr) {
+    entry->array_size = elements;
+  }
+  tac.append(TAC::InstrType::ARRAY, std::to_string(elements), name);
+}
+
+// The range of 'var' in the body of a for loop that sets it to 'init' and
+// runs while "var 'op' bound", stepping up if 'incr' and down otherwise, with
+// 'init' and 'bound' number literals or names of constants. Returns false if
+// the range is not known that way, or 'var' is not a local int variable. The
+// caller checks that the body does not assign 'var'.
+inline bool loop_range(Data& data, const std::string& var,
+                       const std::string& init, TAC::InstrType op,
+                       const std::string& bound, bool incr,
+                       LoopRange& range) {
+  const SymbolTable::Entry* entry =
+      data.sym_table.lookup(data.method_name, var);
+  int64_t from, to;
+  if (entry == nullptr || entry->entry_type != EntryType::Variable ||
+      entry->value_type != ValueType::IntVal || entry->array_size != 0 ||
+      !int_literal(constant_literal(data, init), from) ||
+      !int_literal(constant_literal(data, bound), to)) {
+    return false;
+  }
+  range.var = var;
+  if (incr && (op == TAC::InstrType::LT || op == TAC::InstrType::LE)) {
+    range.low = from;
+    range.high = (op == TAC::InstrType::LT ? to - 1 : to);
+  } else if (!incr && (op == TAC::InstrType::GT || op == TAC::InstrType::GE)) {
+    range.low = (op == TAC::InstrType::GT ? to + (to < INT64_MAX) : to);
+    range.high = from;
   } else {
-    error_msg("Identifier '" + name + "' already declared in scope.");
+    return false;
+  }
+  return true;
+}
+
+// Report an error and return false unless 'entry', that 'name' refers to, is
+// an array.
+inline bool check_array(Data& data, const SymbolTable::Entry* entry,
+                        const std::string& name,
+                        SourceLocation location = SourceLocation()) {
+  if (entry == nullptr) {
+    error_msg(data, DiagId::UndeclaredVariable,
+              "Undeclared identifier '" + name + "'.", location);
+    return false;
+  }
+  if (entry->array_size == 0) {
+    error_msg(data, DiagId::ArrayUse, "'" + name + "' is not an array.",
+              location);
+    return false;
+  }
+  return true;
+}
+
+// The int operand for 'index', of 'index_type', into 'array', after the check
+// that it is in bounds. The check is left out for a constant index, which is
+// checked here instead, and for the variable of an enclosing loop whose range
+// is inside the array.
+inline std::string array_index(Data& data, TAC& tac,
+                               const SymbolTable::Entry* array,
+                               const std::string& index, ValueType index_type,
+                               SourceLocation location = SourceLocation()) {
+  if (index_type != ValueType::IntVal) {
+    warning_msg(data, DiagId::IndexType, "Array index is not an integer.",
+                location);
+  }
+  std::string var = convert(data, tac, index, index_type, ValueType::IntVal);
+  int64_t value;
+  if (int_literal(var, value)) {
+    if (value >= array->array_size) {
+      error_msg(data, DiagId::IndexRange,
+                "Index " + var + " is out of bounds of array '" +
+                array->name + "'.", location);
+    }
+    return var;
+  }
+  for (const LoopRange& range : data.loop_ranges) {
+    if (range.var == var && range.low >= 0 &&
+        range.high < array->array_size) {
+      return var;
+    }
+  }
+  tac.append(TAC::InstrType::BOUNDS, var, std::to_string(array->array_size),
+             "");
+  return var;
+}
+
+// t = array[index], for the array 'name' refers to, as 'entry'.
+inline void load_element(Data& data, TAC& tac, const SymbolTable::Entry* entry,
+                         const std::string& name, const std::string& index,
+                         ValueType index_type,
+                         SourceLocation location = SourceLocation()) {
+  if (!check_array(data, entry, name, location)) {
+    data.expr_return_var = name;
+    data.expr_return_type = ValueType::VoidVal;
+    return;
+  }
+  std::string var = array_index(data, tac, entry, index, index_type, location);
+  std::string result = tac.tmp_variable_name(data.variable_no++);
+  tac.append(TAC::InstrType::VAR, result);
+  tac.append(TAC::InstrType::LOAD, name, var, result);
+  data.expr_return_var = result;
+  data.expr_return_type = entry->value_type;
+}
+
+// array[index] = value, for the array 'name' refers to, as 'entry'.
+inline void store_element(Data& data, TAC& tac,
+                          const SymbolTable::Entry* entry,
+                          const std::string& name, const std::string& index,
+                          ValueType index_type, const std::string& value,
+                          ValueType value_type,
+                          SourceLocation location = SourceLocation()) {
+  if (!check_array(data, entry, name, location)) {
+    return;
+  }
+  std::string var = array_index(data, tac, entry, index, index_type, location);
+  tac.append(TAC::InstrType::STORE,
+             convert(data, tac, value, value_type, entry->value_type), var,
+             name);
+  if ((entry->value_type == ValueType::IntVal &&
+       value_type == ValueType::RealVal) ||
+      (entry->value_type == ValueType::RealVal &&
+       value_type == ValueType::IntVal)) {
+    warning_msg(data, DiagId::AssignType,
+                "Type mismatch in assigning to array '" + name + "'.",
+                location);
+  }
+}
+
+// result = lhs 'instr_type' rhs, for a binary bitwise operation, on the
+// operands as ints.
+inline void bitwise(Data& data, TAC& tac, TAC::InstrType instr_type,
+                    std::string lhs, ValueType lhs_type, std::string rhs,
+                    ValueType rhs_type,
+                    SourceLocation location = SourceLocation()) {
+  if (lhs_type == ValueType::RealVal || rhs_type == ValueType::RealVal) {
+    warning_msg(data, DiagId::BitwiseType,
+                "Type mismatch in bitwise operation " + tac.IName[instr_type] +
+                " (operands are not integer values).", location);
+  }
+  lhs = convert(data, tac, lhs, lhs_type, ValueType::IntVal);
+  rhs = convert(data, tac, rhs, rhs_type, ValueType::IntVal);
+  std::string result = tac.tmp_variable_name(data.variable_no++);
+  tac.append(TAC::InstrType::VAR, result);
+  tac.append(instr_type, lhs, rhs, result);
+  data.expr_return_var = result;
+  data.expr_return_type = ValueType::IntVal;
+}
+
+// result = ~operand, on the operand as an int.
+inline void complement(Data& data, TAC& tac, std::string operand,
+                       ValueType type,
+                       SourceLocation location = SourceLocation()) {
+  if (type == ValueType::RealVal) {
+    warning_msg(data, DiagId::BitwiseType,
+                "Type mismatch in bitwise operation BITNOT (operand is not an "
+                "integer value).", location);
+  }
+  operand = convert(data, tac, operand, type, ValueType::IntVal);
+  std::string result = tac.tmp_variable_name(data.variable_no++);
+  tac.append(TAC::InstrType::VAR, result);
+  tac.append(TAC::InstrType::BITNOT, operand, result);
+  data.expr_return_var = result;
+  data.expr_return_type = ValueType::IntVal;
+}
+
+// Report an error if 'entry', the variable assigned to, is a constant.
+inline void check_assignable(Data& data, const SymbolTable::Entry* entry,
+                             SourceLocation location = SourceLocation()) {
+  if (entry != nullptr && entry->entry_type == EntryType::Constant) {
+    error_msg(data, DiagId::ConstantAssign,
+              "Constant '" + entry->name + "' cannot be assigned to.",
+              location);
   }
 }
 
 /////////////////////////////////////////////////////////////////////////////////
 
+class AstPrinter;
+
 class Node {
  public:
-  virtual const std::string str() const = 0;
+  NodeKind kind() const { return kind_; }
+
+  // Write the node and its children, in the same parenthesized form as str().
+  virtual void print(AstPrinter& out) const = 0;
+
+  const std::string str() const;
 
   virtual void icg(Data& data, TAC& tac) const = 0;
 
+  // Where the node starts in the source, set by the parsers for statements,
+  // declarations and methods; line 0 for other nodes.
+  const SourceLocation& location() const { return location_; }
+  void set_location(SourceLocation location) { location_ = location; }
+
   virtual ~Node() = default;
+
+ protected:
+  explicit Node(NodeKind kind) : kind_(kind) {}
+
+ private:
+  const NodeKind kind_;
+  SourceLocation location_;
 };
 
+// LLVM-style checked casts on the node kind: isa<T>(node) is whether 'node'
+// is a T, cast<T>(node) is 'node' as a T, which it must be, and
+// dyn_cast<T>(node) is 'node' as a T, or nullptr if it is not one. A method
+// call has an ExprNode and a StmNode part, so it is cast from either of
+// those rather than from Node.
+template <typename T, typename From>
+bool isa(const From* node) {
+  return T::classof(node);
+}
+
+template <typename T, typename From>
+const T* cast(const From* node) {
+  assert(isa<T>(node));
+  return static_cast<const T*>(node);
+}
+
+template <typename T, typename From>
+T* cast(From* node) {
+  assert(isa<T>(node));
+  return static_cast<T*>(node);
+}
+
+template <typename T, typename From>
+const T* dyn_cast(const From* node) {
+  return isa<T>(node) ? static_cast<const T*>(node) : nullptr;
+}
+
+template <typename T, typename From>
+T* dyn_cast(From* node) {
+  return isa<T>(node) ? static_cast<T*>(node) : nullptr;
+}
+
+// Writes an AST to a stream in one pass over the tree, through a buffer of its
+// own, without building the string of a subtree first. If 'indented', each
+// '(' starts a new line indented by IndentLevel per enclosing '(', as -a
+// prints it. The buffer is written out when full and when the printer goes.
+class AstPrinter {
+ public:
+  static const int IndentLevel = 3;
+
+  AstPrinter(std::ostream& os, bool indented)
+      : os_(os), indented_(indented), indent_(0) {
+    buffer_.reserve(BufferSize);
+  }
+
+  AstPrinter(const AstPrinter&) = delete;
+  AstPrinter& operator=(const AstPrinter&) = delete;
+
+  ~AstPrinter() { flush(); }
+
+  AstPrinter& operator<<(char c) {
+    if (indented_) {
+      if (c == '(') {
+        buffer_ += '\n';
+        buffer_.append(std::max(indent_, 0), ' ');
+        indent_ += IndentLevel;
+      } else if (c == ')') {
+        indent_ -= IndentLevel;
+      }
+    }
+    buffer_ += c;
+    if (buffer_.size() >= BufferSize) {
+      flush();
+    }
+    return *this;
+  }
+
+  AstPrinter& operator<<(const char* s) {
+    while (*s != '\0') {
+      *this << *s++;
+    }
+    return *this;
+  }
+
+  AstPrinter& operator<<(const std::string& s) {
+    for (char c : s) {
+      *this << c;
+    }
+    return *this;
+  }
+
+  // Children are printed through here, which switches to a new stack segment
+  // when the tree is nested too deeply for the current one.
+  AstPrinter& operator<<(const Node* node) {
+    if (node == nullptr) {
+      return *this << "(null)";
+    }
+    ensure_stack([&]() { node->print(*this); });
+    return *this;
+  }
+
+  void flush() {
+    os_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+
+ private:
+  static const size_t BufferSize = 64 * 1024;
+
+  std::ostream& os_;
+  bool indented_;
+  int indent_;
+  std::string buffer_;
+};
+
+inline const std::string Node::str() const {
+  std::ostringstream os;
+  {
+    AstPrinter printer(os, false);
+    print(printer);
+  }
+  return os.str();
+}
+
 inline std::string tostr(const Node* node) {
-  return (node == nullptr ? "(null)" : node->str());
+  return node == nullptr ? "(null)" : node->str();
+}
+
+// Children are generated through this, which switches to a new stack segment
+// when the tree is nested too deeply for the current one. What is reported
+// while a located child is generated is reported at its location.
+inline void child_icg(const Node* node, Data& data, TAC& tac) {
+  SourceLocation outer = data.location;
+  if (node->location().line != 0) {
+    data.location = node->location();
+  }
+  ensure_stack([&]() { node->icg(data, tac); });
+  data.location = outer;
 }
 
 /////////////////////////////////////////////////////////////////////////////////
 
-class ExprNode : public Node {};
+class ExprNode : public Node {
+ public:
+  static bool classof(const Node* node) { return is_expr(node->kind()); }
+
+ protected:
+  explicit ExprNode(NodeKind kind) : Node(kind) {}
+};
 
 class NumberExprNode : public ExprNode {
  public:
-  explicit NumberExprNode(const std::string value) : value_(value) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Number;
+  }
 
-  virtual const std::string str() const override {
-    return std::string("(NUM ") + value_ + ')';
+  // The literal is parsed here, once, rather than at each use.
+  explicit NumberExprNode(const std::string value)
+      : ExprNode(NodeKind::Number), value_(value) {
+    parse_literal(value_, constant_);
   }
 
-  virtual void icg(Data& data, TAC&) const override {
+  virtual void print(AstPrinter& out) const override {
+    out << "(NUM " << value_ << ')';
+  }
+
+  virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
+    tac.constants().add(value_, constant_);
     data.expr_return_var = value_;
-    data.expr_return_type =
-        (std::all_of(value_.begin(), value_.end(), ::isdigit)
-             ? ValueType::IntVal
-             : ValueType::RealVal);
+    data.expr_return_type = constant_.type;
   }
 
+  const std::string& get_value() const { return value_; }
+  const Constant& get_constant() const { return constant_; }
+
  protected:
   std::string value_;
+  Constant constant_;
 };
 
 class AndExprNode : public ExprNode {
  public:
-  AndExprNode(ExprNode* lhs, ExprNode* rhs) : lhs_(lhs), rhs_(rhs) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::And;
+  }
+
+  AndExprNode(ExprNode* lhs, ExprNode* rhs)
+      : ExprNode(NodeKind::And), lhs_(lhs), rhs_(rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(&& ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(&& " << lhs_ << ' ' << rhs_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
@@ -116,17 +597,20 @@ class AndExprNode : public ExprNode {
 
     tac.append(TAC::InstrType::VAR, result_var);
 
-    lhs_->icg(data, tac);
+    child_icg(lhs_, data, tac);
     auto lhs_type = data.expr_return_type;
-    tac.append(TAC::InstrType::EQ, data.expr_return_var, "0", lab_and_false);
+    tac.append(TAC::InstrType::EQ, data.expr_return_type, data.expr_return_var,
+               tac.zero(data.expr_return_type), lab_and_false);
 
-    rhs_->icg(data, tac);
-    tac.append(TAC::InstrType::EQ, data.expr_return_var, "0", lab_and_false);
+    child_icg(rhs_, data, tac);
+    tac.append(TAC::InstrType::EQ, data.expr_return_type, data.expr_return_var,
+               tac.zero(data.expr_return_type), lab_and_false);
 
     if (lhs_type != ValueType::IntVal ||
         data.expr_return_type != ValueType::IntVal) {
-      warning_msg(
-          "Type mismatch in logical && (operands are not integer values).");
+      warning_msg(data, DiagId::LogicalType,
+                  "Type mismatch in logical && (operands are not integer "
+                  "values).");
     }
 
     tac.append(TAC::InstrType::ASSIGN, "1", result_var);
@@ -141,16 +625,24 @@ class AndExprNode : public ExprNode {
     data.expr_return_type = ValueType::IntVal;
   }
 
+  const ExprNode* get_lhs() const { return lhs_; }
+  const ExprNode* get_rhs() const { return rhs_; }
+
  protected:
   ExprNode *lhs_, *rhs_;
 };
 
 class OrExprNode : public ExprNode {
  public:
-  OrExprNode(ExprNode* lhs, ExprNode* rhs) : lhs_(lhs), rhs_(rhs) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Or;
+  }
+
+  OrExprNode(ExprNode* lhs, ExprNode* rhs)
+      : ExprNode(NodeKind::Or), lhs_(lhs), rhs_(rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(|| ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(|| " << lhs_ << ' ' << rhs_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
@@ -161,17 +653,20 @@ class OrExprNode : public ExprNode {
 
     tac.append(TAC::InstrType::VAR, result_var);
 
-    lhs_->icg(data, tac);
-    tac.append(TAC::InstrType::NE, data.expr_return_var, "0", lab_or_true);
+    child_icg(lhs_, data, tac);
+    tac.append(TAC::InstrType::NE, data.expr_return_type, data.expr_return_var,
+               tac.zero(data.expr_return_type), lab_or_true);
     auto lhs_type = data.expr_return_type;
 
-    rhs_->icg(data, tac);
-    tac.append(TAC::InstrType::NE, data.expr_return_var, "0", lab_or_true);
+    child_icg(rhs_, data, tac);
+    tac.append(TAC::InstrType::NE, data.expr_return_type, data.expr_return_var,
+               tac.zero(data.expr_return_type), lab_or_true);
 
     if (lhs_type != ValueType::IntVal ||
         data.expr_return_type != ValueType::IntVal) {
-      warning_msg(
-          "Type mismatch in logical || (operands are not integer values).");
+      warning_msg(data, DiagId::LogicalType,
+                  "Type mismatch in logical || (operands are not integer "
+                  "values).");
     }
 
     tac.append(TAC::InstrType::ASSIGN, "0", result_var);
@@ -186,16 +681,23 @@ class OrExprNode : public ExprNode {
     data.expr_return_type = ValueType::IntVal;
   }
 
+  const ExprNode* get_lhs() const { return lhs_; }
+  const ExprNode* get_rhs() const { return rhs_; }
+
  protected:
   ExprNode *lhs_, *rhs_;
 };
 
 class NotExprNode : public ExprNode {
  public:
-  NotExprNode(ExprNode* rhs) : rhs_(rhs) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Not;
+  }
+
+  NotExprNode(ExprNode* rhs) : ExprNode(NodeKind::Not), rhs_(rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(! ") + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(! " << rhs_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
@@ -206,9 +708,10 @@ class NotExprNode : public ExprNode {
     data.label_no++;
 
     tac.append(TAC::InstrType::VAR, var);
-    rhs_->icg(data, tac);
+    child_icg(rhs_, data, tac);
     ValueType type_rhs = data.expr_return_type;
-    tac.append(TAC::InstrType::NE, data.expr_return_var, "0", lab_not_true);
+    tac.append(TAC::InstrType::NE, type_rhs, data.expr_return_var,
+               tac.zero(type_rhs), lab_not_true);
     tac.append(TAC::InstrType::ASSIGN, "1", var);
     tac.append(TAC::InstrType::GOTO, lab_not_end);
     tac.label_next_instr(lab_not_true);
@@ -219,38 +722,50 @@ class NotExprNode : public ExprNode {
     data.expr_return_type = ValueType::IntVal;
 
     if (type_rhs == ValueType::RealVal) {
-      warning_msg(
-          "Type mismatch in logical ! operation (operand is not an integer "
-          "value).");
+      warning_msg(data, DiagId::LogicalType,
+                  "Type mismatch in logical ! operation (operand is not an "
+                  "integer value).");
     }
   }
 
+  const ExprNode* get_rhs() const { return rhs_; }
+
  protected:
   ExprNode* rhs_;
 };
 
 class RelationalExprNode : public ExprNode {
  public:
-  RelationalExprNode(TAC::InstrType instr_type, ExprNode* lhs, ExprNode* rhs)
-      : instr_type_(instr_type), lhs_(lhs), rhs_(rhs) {}
+  static bool classof(const Node* node) {
+    return node->kind() >= NodeKind::Eq && node->kind() <= NodeKind::Gte;
+  }
+
+  RelationalExprNode(NodeKind kind, TAC::InstrType instr_type, ExprNode* lhs,
+                     ExprNode* rhs)
+      : ExprNode(kind), instr_type_(instr_type), lhs_(lhs), rhs_(rhs) {}
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
-    lhs_->icg(data, tac);
+    child_icg(lhs_, data, tac);
     std::string var_lhs = data.expr_return_var;
     ValueType type_lhs = data.expr_return_type;
 
-    rhs_->icg(data, tac);
+    child_icg(rhs_, data, tac);
     std::string var_rhs = data.expr_return_var;
     ValueType type_rhs = data.expr_return_type;
 
+    // Mixed operands are compared as reals.
+    ValueType type = (type_lhs == ValueType::RealVal ? type_lhs : type_rhs);
+    var_lhs = convert(data, tac, var_lhs, type_lhs, type);
+    var_rhs = convert(data, tac, var_rhs, type_rhs, type);
+
     std::string lab_rel_true = tac.label_name("rel_true", data.label_no);
     std::string lab_rel_end = tac.label_name("rel_end", data.label_no);
     data.label_no++;
     std::string var = tac.tmp_variable_name(data.variable_no++);
 
     tac.append(TAC::InstrType::VAR, var);
-    tac.append(instr_type_, var_lhs, var_rhs, lab_rel_true);
+    tac.append(instr_type_, type, var_lhs, var_rhs, lab_rel_true);
     tac.append(TAC::InstrType::ASSIGN, "0", var);
     tac.append(TAC::InstrType::GOTO, lab_rel_end);
     tac.label_next_instr(lab_rel_true);
@@ -262,10 +777,15 @@ class RelationalExprNode : public ExprNode {
 
     if ((type_lhs == ValueType::IntVal && type_rhs == ValueType::RealVal) ||
         (type_lhs == ValueType::RealVal && type_rhs == ValueType::IntVal)) {
-      warning_msg("Type mismatch in operation " + tac.IName[instr_type_] + ".");
+      warning_msg(data, DiagId::CompareType,
+                  "Type mismatch in operation " + tac.IName[instr_type_] + ".");
     }
   }
 
+  TAC::InstrType get_instr_type() const { return instr_type_; }
+  const ExprNode* get_lhs() const { return lhs_; }
+  const ExprNode* get_rhs() const { return rhs_; }
+
  protected:
   TAC::InstrType instr_type_;
   ExprNode *lhs_, *rhs_;
@@ -273,89 +793,133 @@ class RelationalExprNode : public ExprNode {
 
 class EqExprNode : public RelationalExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Eq;
+  }
+
   EqExprNode(ExprNode* lhs, ExprNode* rhs)
-      : RelationalExprNode(TAC::InstrType::EQ, lhs, rhs) {}
+      : RelationalExprNode(NodeKind::Eq, TAC::InstrType::EQ, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(== ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(== " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class NeqExprNode : public RelationalExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Neq;
+  }
+
   NeqExprNode(ExprNode* lhs, ExprNode* rhs)
-      : RelationalExprNode(TAC::InstrType::NE, lhs, rhs) {}
+      : RelationalExprNode(NodeKind::Neq, TAC::InstrType::NE, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(!= ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(!= " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class LtExprNode : public RelationalExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Lt;
+  }
+
   LtExprNode(ExprNode* lhs, ExprNode* rhs)
-      : RelationalExprNode(TAC::InstrType::LT, lhs, rhs) {}
+      : RelationalExprNode(NodeKind::Lt, TAC::InstrType::LT, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(< ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(< " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class LteExprNode : public RelationalExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Lte;
+  }
+
   LteExprNode(ExprNode* lhs, ExprNode* rhs)
-      : RelationalExprNode(TAC::InstrType::LE, lhs, rhs) {}
+      : RelationalExprNode(NodeKind::Lte, TAC::InstrType::LE, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(<= ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(<= " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class GtExprNode : public RelationalExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Gt;
+  }
+
   GtExprNode(ExprNode* lhs, ExprNode* rhs)
-      : RelationalExprNode(TAC::InstrType::GT, lhs, rhs) {}
+      : RelationalExprNode(NodeKind::Gt, TAC::InstrType::GT, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(> ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(> " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class GteExprNode : public RelationalExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Gte;
+  }
+
   GteExprNode(ExprNode* lhs, ExprNode* rhs)
-      : RelationalExprNode(TAC::InstrType::GE, lhs, rhs) {}
+      : RelationalExprNode(NodeKind::Gte, TAC::InstrType::GE, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(>= ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(>= " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class ArithmeticExprNode : public ExprNode {
  public:
-  ArithmeticExprNode(TAC::InstrType instr_type, ExprNode* lhs, ExprNode* rhs)
-      : instr_type_(instr_type), lhs_(lhs), rhs_(rhs) {}
+  static bool classof(const Node* node) {
+    return node->kind() >= NodeKind::Multiply &&
+           node->kind() <= NodeKind::Minus;
+  }
+
+  ArithmeticExprNode(NodeKind kind, TAC::InstrType instr_type, ExprNode* lhs,
+                     ExprNode* rhs)
+      : ExprNode(kind), instr_type_(instr_type), lhs_(lhs), rhs_(rhs) {}
 
   virtual void icg(Data& data, TAC& tac) const override {
-    lhs_->icg(data, tac);
+    child_icg(lhs_, data, tac);
     std::string lhs_var = data.expr_return_var;
     auto lhs_type = data.expr_return_type;
-    rhs_->icg(data, tac);
+    child_icg(rhs_, data, tac);
     std::string rhs_var = data.expr_return_var;
 
     if (lhs_type != data.expr_return_type) {
-      warning_msg("Mixing int and real types in operation " +
+      warning_msg(data, DiagId::ArithmeticType,
+                  "Mixing int and real types in operation " +
                   tac.IName[instr_type_] + ".");
     }
+    // The operation is of the type of its left operand.
+    rhs_var = convert(data, tac, rhs_var, data.expr_return_type, lhs_type);
 
     std::string result_var = tac.tmp_variable_name(data.variable_no++);
     tac.append(TAC::InstrType::VAR, result_var);
 
-    tac.append(instr_type_, lhs_var, rhs_var, result_var);
+    tac.append(instr_type_, lhs_type, lhs_var, rhs_var, result_var);
     data.expr_return_var = result_var;
     data.expr_return_type = lhs_type;
   }
 
+  TAC::InstrType get_instr_type() const { return instr_type_; }
+  // nullptr for unary + and -.
+  const ExprNode* get_lhs() const { return lhs_; }
+  const ExprNode* get_rhs() const { return rhs_; }
+
  protected:
   TAC::InstrType instr_type_;
   ExprNode *lhs_, *rhs_;
@@ -363,55 +927,75 @@ class ArithmeticExprNode : public ExprNode {
 
 class MultiplyExprNode : public ArithmeticExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Multiply;
+  }
+
   MultiplyExprNode(ExprNode* lhs, ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::MULT, lhs, rhs) {}
+      : ArithmeticExprNode(NodeKind::Multiply, TAC::InstrType::MULT,
+                           lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(* ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(* " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class DivideExprNode : public ArithmeticExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Divide;
+  }
+
   DivideExprNode(ExprNode* lhs, ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::DIVIDE, lhs, rhs) {}
+      : ArithmeticExprNode(NodeKind::Divide, TAC::InstrType::DIVIDE,
+                           lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(/ ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(/ " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class ModulusExprNode : public ArithmeticExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Modulus;
+  }
+
   ModulusExprNode(ExprNode* lhs, ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::MOD, lhs, rhs) {}
+      : ArithmeticExprNode(NodeKind::Modulus, TAC::InstrType::MOD, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    return std::string("(% ") + tostr(lhs_) + ' ' + tostr(rhs_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(% " << lhs_ << ' ' << rhs_ << ')';
   }
+
 };
 
 class PlusExprNode : public ArithmeticExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Plus;
+  }
+
   PlusExprNode(ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::ADD, nullptr, rhs) {}
+      : ArithmeticExprNode(NodeKind::Plus, TAC::InstrType::ADD, nullptr, rhs) {}
 
   PlusExprNode(ExprNode* lhs, ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::ADD, lhs, rhs) {}
+      : ArithmeticExprNode(NodeKind::Plus, TAC::InstrType::ADD, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    std::string s = std::string("(+ ");
+  virtual void print(AstPrinter& out) const override {
+    out << "(+ ";
     if (lhs_ != nullptr) {
-      s += tostr(lhs_) + ' ';
+      out << lhs_ << ' ';
     }
-    s += tostr(rhs_) + ')';
-    return s;
+    out << rhs_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     if (lhs_ == nullptr) {
-      rhs_->icg(data, tac);
+      child_icg(rhs_, data, tac);
     } else {
       ArithmeticExprNode::icg(data, tac);
     }
@@ -420,27 +1004,32 @@ class PlusExprNode : public ArithmeticExprNode {
 
 class MinusExprNode : public ArithmeticExprNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Minus;
+  }
+
   MinusExprNode(ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::SUB, nullptr, rhs) {}
+      : ArithmeticExprNode(NodeKind::Minus, TAC::InstrType::SUB,
+                           nullptr, rhs) {}
   MinusExprNode(ExprNode* lhs, ExprNode* rhs)
-      : ArithmeticExprNode(TAC::InstrType::SUB, lhs, rhs) {}
+      : ArithmeticExprNode(NodeKind::Minus, TAC::InstrType::SUB, lhs, rhs) {}
 
-  virtual const std::string str() const override {
-    std::string s = std::string("(- ");
+  virtual void print(AstPrinter& out) const override {
+    out << "(- ";
     if (lhs_ != nullptr) {
-      s += tostr(lhs_) + ' ';
+      out << lhs_ << ' ';
     }
-    s += tostr(rhs_) + ')';
-    return s;
+    out << rhs_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     if (lhs_ == nullptr) {
-      rhs_->icg(data, tac);
+      child_icg(rhs_, data, tac);
       std::string var = tac.tmp_variable_name(data.variable_no++);
       tac.append(TAC::InstrType::VAR, var);
-      tac.append(TAC::InstrType::UMINUS, data.expr_return_var, var);
+      tac.append(TAC::InstrType::UMINUS, data.expr_return_type,
+                 data.expr_return_var, var);
       data.expr_return_var = var;
     } else {
       ArithmeticExprNode::icg(data, tac);
@@ -448,59 +1037,230 @@ class MinusExprNode : public ArithmeticExprNode {
   }
 };
 
+class BitwiseExprNode : public ExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() >= NodeKind::BitAnd &&
+           node->kind() <= NodeKind::ShiftRight;
+  }
+
+  BitwiseExprNode(NodeKind kind, TAC::InstrType instr_type, ExprNode* lhs,
+                  ExprNode* rhs)
+      : ExprNode(kind), instr_type_(instr_type), lhs_(lhs), rhs_(rhs) {}
+
+  virtual void icg(Data& data, TAC& tac) const override {
+    child_icg(lhs_, data, tac);
+    std::string lhs_var = data.expr_return_var;
+    auto lhs_type = data.expr_return_type;
+    child_icg(rhs_, data, tac);
+    bitwise(data, tac, instr_type_, lhs_var, lhs_type, data.expr_return_var,
+            data.expr_return_type);
+  }
+
+  TAC::InstrType get_instr_type() const { return instr_type_; }
+  const ExprNode* get_lhs() const { return lhs_; }
+  const ExprNode* get_rhs() const { return rhs_; }
+
+ protected:
+  TAC::InstrType instr_type_;
+  ExprNode *lhs_, *rhs_;
+};
+
+class BitAndExprNode : public BitwiseExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::BitAnd;
+  }
+
+  BitAndExprNode(ExprNode* lhs, ExprNode* rhs)
+      : BitwiseExprNode(NodeKind::BitAnd, TAC::InstrType::BITAND, lhs, rhs) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(& " << lhs_ << ' ' << rhs_ << ')';
+  }
+};
+
+class BitOrExprNode : public BitwiseExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::BitOr;
+  }
+
+  BitOrExprNode(ExprNode* lhs, ExprNode* rhs)
+      : BitwiseExprNode(NodeKind::BitOr, TAC::InstrType::BITOR, lhs, rhs) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(| " << lhs_ << ' ' << rhs_ << ')';
+  }
+};
+
+class BitXorExprNode : public BitwiseExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::BitXor;
+  }
+
+  BitXorExprNode(ExprNode* lhs, ExprNode* rhs)
+      : BitwiseExprNode(NodeKind::BitXor, TAC::InstrType::BITXOR, lhs, rhs) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(^ " << lhs_ << ' ' << rhs_ << ')';
+  }
+};
+
+class ShiftLeftExprNode : public BitwiseExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::ShiftLeft;
+  }
+
+  ShiftLeftExprNode(ExprNode* lhs, ExprNode* rhs)
+      : BitwiseExprNode(NodeKind::ShiftLeft, TAC::InstrType::SHL, lhs, rhs) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(<< " << lhs_ << ' ' << rhs_ << ')';
+  }
+};
+
+class ShiftRightExprNode : public BitwiseExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::ShiftRight;
+  }
+
+  ShiftRightExprNode(ExprNode* lhs, ExprNode* rhs)
+      : BitwiseExprNode(NodeKind::ShiftRight, TAC::InstrType::SHR, lhs, rhs) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(>> " << lhs_ << ' ' << rhs_ << ')';
+  }
+};
+
+class ComplementExprNode : public ExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Complement;
+  }
+
+  ComplementExprNode(ExprNode* rhs)
+      : ExprNode(NodeKind::Complement), rhs_(rhs) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(~ " << rhs_ << ')';
+  }
+
+  virtual void icg(Data& data, TAC& tac) const override {
+    child_icg(rhs_, data, tac);
+    complement(data, tac, data.expr_return_var, data.expr_return_type);
+  }
+
+  const ExprNode* get_rhs() const { return rhs_; }
+
+ protected:
+  ExprNode* rhs_;
+};
+
 class VariableExprNode : public ExprNode {
  public:
-  explicit VariableExprNode(const std::string& id) : id_(id) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Variable;
+  }
 
-  virtual const std::string str() const override {
-    return std::string("(VAR ") + id_ + ')';
+  explicit VariableExprNode(const std::string& id)
+      : ExprNode(NodeKind::Variable), id_(id) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(VAR " << id_ << ')';
   }
 
-  virtual void icg(Data& data, TAC&) const override {
+  virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     data.expr_return_var = id_;
     data.expr_return_type = ValueType::VoidVal;
 
-    SymbolTable::Entry* entry = data.sym_table.lookup(data.method_name, id_);
-    if (entry == nullptr &&
-        !data.method_name.empty()) {  // also look in global scope.
-      entry = data.sym_table.lookup("", id_);
-    }
-    if (entry == nullptr) {
-      error_msg("Undeclared identifier '" + id_ + "'.");
+    const SymbolTable::Entry* symbol = get_symbol(data);
+    if (symbol == nullptr) {
+      error_msg(data, DiagId::UndeclaredVariable,
+                "Undeclared identifier '" + id_ + "'.");
     } else {
-      data.expr_return_type = entry->value_type;
+      data.expr_return_type = symbol->value_type;
+      if (symbol->entry_type == EntryType::Constant) {
+        tac.constants().add(symbol->value);
+        data.expr_return_var = symbol->value;
+      } else if (symbol->array_size != 0) {
+        error_msg(data, DiagId::ArrayUse,
+                  "Array '" + id_ + "' is used without an index.");
+      }
     }
   }
 
   std::string get_id() const { return id_; }
 
+  // The entry of the variable, as bound by resolve_names() in 'data', or
+  // nullptr if it is undeclared.
+  const SymbolTable::Entry* get_symbol(const Data& data) const {
+    return data.symbol(this);
+  }
+
  protected:
   std::string id_;
 };
 
+// An element of an array, array[index].
+class IndexExprNode : public ExprNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Index;
+  }
+
+  IndexExprNode(VariableExprNode* array, ExprNode* index)
+      : ExprNode(NodeKind::Index), array_(array), index_(index) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(INDEX " << array_ << ' ' << index_ << ')';
+  }
+
+  virtual void icg(Data& data, TAC& tac) const override {
+    child_icg(index_, data, tac);
+    load_element(data, tac, array_->get_symbol(data), array_->get_id(),
+                 data.expr_return_var, data.expr_return_type);
+  }
+
+  const VariableExprNode* get_array() const { return array_; }
+  const ExprNode* get_index() const { return index_; }
+
+ protected:
+  VariableExprNode* array_;
+  ExprNode* index_;
+};
+
 /////////////////////////////////////////////////////////////////////////////////
 
 class VariableDeclarationNode : public Node {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::VariableDeclaration ||
+           node->kind() == NodeKind::ConstantDeclaration ||
+           node->kind() == NodeKind::ArrayDeclaration;
+  }
+
   VariableDeclarationNode(ValueType type, std::list<VariableExprNode*>* vars)
-      : type_(type), vars_(vars) {}
+      : Node(NodeKind::VariableDeclaration), type_(type), vars_(vars) {}
 
-  virtual const std::string str() const override {
-    std::string s = std::string("(DECLARE ") + tostr(type_);
+  virtual void print(AstPrinter& out) const override {
+    out << "(DECLARE " << tostr(type_);
     for (auto node : *vars_) {
-      s += ' ' + tostr(node);
+      out << ' ' << node;
     }
-    s += ')';
-    return s;
+    out << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     for (auto e : *vars_) {
       // e->icg( data, tac );
-      add_to_symbol_table(data.sym_table, EntryType::Variable, data.method_name,
-                          e->get_id(), type_, "");
+      add_to_symbol_table(data, EntryType::Variable, data.method_name,
+                          e->get_id(), type_);
       tac.append(TAC::InstrType::VAR, e->get_id());
     }
   }
@@ -510,24 +1270,103 @@ class VariableDeclarationNode : public Node {
   const std::list<VariableExprNode*>* get_vars() const { return vars_; }
 
  protected:
+  VariableDeclarationNode(NodeKind kind, ValueType type,
+                          std::list<VariableExprNode*>* vars)
+      : Node(kind), type_(type), vars_(vars) {}
+
   ValueType type_;
   const std::list<VariableExprNode*>* vars_;
 };
 
+// static final type var = number; among the variables of the class, as one
+// variable declaration with a value.
+class ConstantDeclarationNode : public VariableDeclarationNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::ConstantDeclaration;
+  }
+
+  ConstantDeclarationNode(ValueType type, VariableExprNode* var,
+                          NumberExprNode* value)
+      : VariableDeclarationNode(NodeKind::ConstantDeclaration, type,
+                                new std::list<VariableExprNode*>(1, var)),
+        var_(var),
+        value_(value) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(CONSTANT " << tostr(type_) << ' ' << var_ << ' ' << value_
+        << ')';
+  }
+
+  virtual void icg(Data& data, TAC&) const override {
+    declare_constant(data, var_->get_id(), type_, value_->get_value(),
+                     value_->get_constant());
+  }
+
+  std::string get_id() const { return var_->get_id(); }
+
+  const VariableExprNode* get_var() const { return var_; }
+  const NumberExprNode* get_value() const { return value_; }
+
+ protected:
+  VariableExprNode* var_;
+  NumberExprNode* value_;
+};
+
+// type var[size]; with the size a number or a constant.
+class ArrayDeclarationNode : public VariableDeclarationNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::ArrayDeclaration;
+  }
+
+  ArrayDeclarationNode(ValueType type, VariableExprNode* var, ExprNode* size)
+      : VariableDeclarationNode(NodeKind::ArrayDeclaration, type,
+                                new std::list<VariableExprNode*>(1, var)),
+        var_(var),
+        size_(size) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(ARRAY " << tostr(type_) << ' ' << var_ << ' ' << size_ << ')';
+  }
+
+  virtual void icg(Data& data, TAC& tac) const override {
+    auto number = dyn_cast<NumberExprNode>(size_);
+    declare_array(data, tac, var_->get_id(), type_,
+                  number != nullptr
+                      ? number->get_value()
+                      : static_cast<const VariableExprNode*>(size_)->get_id());
+  }
+
+  std::string get_id() const { return var_->get_id(); }
+
+  const VariableExprNode* get_var() const { return var_; }
+  // A NumberExprNode or a VariableExprNode, naming a constant.
+  const ExprNode* get_size() const { return size_; }
+
+ protected:
+  VariableExprNode* var_;
+  ExprNode* size_;
+};
+
 class ParameterNode : public Node {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Parameter;
+  }
+
   ParameterNode(ValueType type, VariableExprNode* var)
-      : type_(type), var_(var) {}
+      : Node(NodeKind::Parameter), type_(type), var_(var) {}
 
-  virtual const std::string str() const override {
-    return std::string("(PARAM ") + tostr(type_) + tostr(var_) + ")";
+  virtual void print(AstPrinter& out) const override {
+    out << "(PARAM " << tostr(type_) << var_ << ")";
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     // var_->icg( data, tac );
-    add_to_symbol_table(data.sym_table, EntryType::Variable, data.method_name,
-                        var_->get_id(), type_, "");
+    add_to_symbol_table(data, EntryType::Variable, data.method_name,
+                        var_->get_id(), type_);
     tac.append(TAC::InstrType::FPARAM, var_->get_id());
   }
 
@@ -535,6 +1374,8 @@ class ParameterNode : public Node {
 
   std::string get_id() const { return var_->get_id(); }
 
+  const VariableExprNode* get_var() const { return var_; }
+
  protected:
   ValueType type_;
   VariableExprNode* var_;
@@ -542,63 +1383,64 @@ class ParameterNode : public Node {
 
 /////////////////////////////////////////////////////////////////////////////////
 
-class StmNode : public Node {};
+class StmNode : public Node {
+ public:
+  static bool classof(const Node* node) { return is_stm(node->kind()); }
+
+ protected:
+  explicit StmNode(NodeKind kind) : Node(kind) {}
+};
 
 class MethodCallExprStmNode : public ExprNode, public StmNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::MethodCall;
+  }
+
   MethodCallExprStmNode(std::string id, std::list<ExprNode*>* expr_list)
-      : id_(id), expr_list_(expr_list) {}
+      : ExprNode(NodeKind::MethodCall),
+        StmNode(NodeKind::MethodCall),
+        id_(id),
+        expr_list_(expr_list) {}
 
-  virtual const std::string str() const override {
-    std::string s("(CALL " + id_);
+  virtual void print(AstPrinter& out) const override {
+    out << "(CALL " << id_;
     for (auto e : *expr_list_) {
-      s += " " + tostr(e);
+      out << " " << e;
     }
-    s += ')';
-    return s;
+    out << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
-    // Find symbol table entry for this method
-    SymbolTable::Entry* entry = data.sym_table.lookup("", id_);
+    // Symbol table entry for this method, bound by resolve_names().
+    const SymbolTable::Entry* entry = get_symbol(data);
 
     if (entry == nullptr) {
       // No entry in symbol table for this method
       if (id_ != "writeln" && id_ != "write") {
         // Undeclared method
-        error_msg("Method '" + id_ + "' undeclared.");
+        error_msg(data, DiagId::UndeclaredMethod,
+                  "Method '" + id_ + "' undeclared.");
       } else {
         // write / writeln
         if (expr_list_->size() != 1) {
-          warning_msg("Method '" + id_ + "' accepts 1 argument but " +
+          warning_msg(data, DiagId::WriteArguments,
+                      "Method '" + id_ + "' accepts 1 argument but " +
                       std::to_string(expr_list_->size()) + " given.");
         }
 
         // In the case of more than one argument, add only the first one to TAC
         // code
-        expr_list_->front()->icg(data, tac);
-        tac.append(TAC::InstrType::APARAM, data.expr_return_var);
+        if (!expr_list_->empty()) {
+          child_icg(expr_list_->front(), data, tac);
+          tac.append(TAC::InstrType::APARAM, data.expr_return_var);
+        }
         tac.append(TAC::InstrType::CALL, id_);
         data.expr_return_var = id_;
       }
     } else {
-      // Get the list of types of formal parameters
-      std::vector<std::string> formal_parameters = std::vector<std::string>();
-      std::stringstream ss(entry->signature);
-      std::string token;
-      std::string expectedParams = "";
-      while (std::getline(ss, token, ':')) {
-        if (token.empty()) {
-          // Skip empty strings because of delimiter ::
-          continue;
-        }
-        if (!expectedParams.empty()) {
-          expectedParams += ", ";
-        }
-        expectedParams += token;
-        formal_parameters.push_back(token);
-      }
-
+      // The types of the formal parameters.
+      const Signature& formal_parameters = entry->signature;
       bool wrongParameters = formal_parameters.size() != expr_list_->size();
 
       auto iterFormal = formal_parameters.begin();
@@ -608,11 +1450,16 @@ class MethodCallExprStmNode : public ExprNode, public StmNode {
 
       // Get the list of actual parameters
       for (auto expr : *expr_list_) {
-        expr->icg(data, tac);
+        child_icg(expr, data, tac);
+        std::string arg_var = data.expr_return_var;
+        if (iterFormal != formal_parameters.end()) {
+          arg_var = convert(data, tac, arg_var, data.expr_return_type,
+                            *iterFormal);
+        }
         // save result into new variable
         std::string param_var = tac.tmp_variable_name(data.variable_no++);
         tac.append(TAC::InstrType::VAR, param_var);
-        tac.append(TAC::InstrType::ASSIGN, data.expr_return_var, param_var);
+        tac.append(TAC::InstrType::ASSIGN, arg_var, param_var);
         expr_var_names.push_back(param_var);
 
         if (!givenParams.empty()) {
@@ -620,7 +1467,8 @@ class MethodCallExprStmNode : public ExprNode, public StmNode {
         }
         givenParams += tostr(data.expr_return_type);
 
-        if (tostr(data.expr_return_type) != *iterFormal) {
+        if (iterFormal == formal_parameters.end() ||
+            data.expr_return_type != *iterFormal) {
           // Type of actual parameter does not match the type of formal
           // parameter
           wrongParameters = true;
@@ -636,15 +1484,31 @@ class MethodCallExprStmNode : public ExprNode, public StmNode {
       }
 
       if (wrongParameters) {
-        warning_msg("Parameters mismatch for method call '" + id_ +
-                    "': expected " + expectedParams + "; given " + givenParams);
+        warning_msg(data, DiagId::ParameterType,
+                    "Parameters mismatch for method call '" + id_ +
+                    "': expected " + tostr(formal_parameters, ", ") +
+                    "; given " + givenParams);
       }
 
       tac.append(TAC::InstrType::CALL, id_);
       data.expr_return_var = id_;
+      if (tac.typed()) {
+        // Typed code needs the type of the result. Untyped code leaves the
+        // type as it was, so that its warnings stay as they have been.
+        data.expr_return_type = entry->value_type;
+      }
     }
   }
 
+  const std::string& get_id() const { return id_; }
+  const std::list<ExprNode*>* get_args() const { return expr_list_; }
+
+  // The entry of the method called, as bound by resolve_names() in 'data',
+  // or nullptr if it is undeclared (or write/writeln).
+  const SymbolTable::Entry* get_symbol(const Data& data) const {
+    return data.symbol(this);
+  }
+
  protected:
   std::string id_;
   std::list<ExprNode*>* expr_list_;
@@ -652,129 +1516,213 @@ class MethodCallExprStmNode : public ExprNode, public StmNode {
 
 class AssignStmNode : public StmNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Assign;
+  }
+
   AssignStmNode(VariableExprNode* lvar, ExprNode* expr)
-      : lvar_(lvar), expr_(expr) {}
+      : StmNode(NodeKind::Assign), lvar_(lvar), expr_(expr) {}
 
-  virtual const std::string str() const override {
-    return std::string("(= ") + tostr(lvar_) + ' ' + tostr(expr_) + ')';
+  virtual void print(AstPrinter& out) const override {
+    out << "(= " << lvar_ << ' ' << expr_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     lvar_->icg(data, tac);
+    check_assignable(data, lvar_->get_symbol(data));
     std::string var = data.expr_return_var;
     ValueType var_type = data.expr_return_type;
 
-    expr_->icg(data, tac);
+    child_icg(expr_, data, tac);
     std::string exp_var = data.expr_return_var;
     ValueType exp_type = data.expr_return_type;
 
-    tac.append(TAC::InstrType::ASSIGN, exp_var, var);
+    tac.append(TAC::InstrType::ASSIGN,
+               convert(data, tac, exp_var, exp_type, var_type), var);
 
     if ((var_type == ValueType::IntVal && exp_type == ValueType::RealVal) ||
         (var_type == ValueType::RealVal && exp_type == ValueType::IntVal)) {
-      warning_msg("Type mismatch in assigning to variable '" + var + "'.");
+      warning_msg(data, DiagId::AssignType,
+                  "Type mismatch in assigning to variable '" + var + "'.");
     }
   }
 
+  const VariableExprNode* get_var() const { return lvar_; }
+  const ExprNode* get_expr() const { return expr_; }
+
  protected:
   VariableExprNode* lvar_;
   ExprNode* expr_;
 };
 
-class IncrDecrStmNode : public StmNode {};
+// array[index] = expr;
+class IndexAssignStmNode : public StmNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::IndexAssign;
+  }
+
+  IndexAssignStmNode(IndexExprNode* element, ExprNode* expr)
+      : StmNode(NodeKind::IndexAssign), element_(element), expr_(expr) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(= " << element_ << ' ' << expr_ << ')';
+  }
+
+  virtual void icg(Data& data, TAC& tac) const override {
+    child_icg(element_->get_index(), data, tac);
+    std::string index = data.expr_return_var;
+    ValueType index_type = data.expr_return_type;
+
+    child_icg(expr_, data, tac);
+    const VariableExprNode* array = element_->get_array();
+    store_element(data, tac, array->get_symbol(data), array->get_id(), index,
+                  index_type, data.expr_return_var, data.expr_return_type);
+  }
+
+  const IndexExprNode* get_element() const { return element_; }
+  const ExprNode* get_expr() const { return expr_; }
+
+ protected:
+  IndexExprNode* element_;
+  ExprNode* expr_;
+};
+
+class IncrDecrStmNode : public StmNode {
+ public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Incr || node->kind() == NodeKind::Decr;
+  }
+
+ protected:
+  explicit IncrDecrStmNode(NodeKind kind) : StmNode(kind) {}
+};
 
 class IncrStmNode : public IncrDecrStmNode {
  public:
-  IncrStmNode(VariableExprNode* var) : var_(var) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Incr;
+  }
 
-  virtual const std::string str() const override {
-    return std::string("(++ ") + tostr(var_) + ')';
+  IncrStmNode(VariableExprNode* var)
+      : IncrDecrStmNode(NodeKind::Incr), var_(var) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(++ " << var_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     var_->icg(data, tac);
+    check_assignable(data, var_->get_symbol(data));
     if (data.expr_return_type == ValueType::RealVal) {
-      tac.append(TAC::InstrType::ADD, data.expr_return_var, "1.0",
-                 data.expr_return_var);
+      tac.append(TAC::InstrType::ADD, data.expr_return_type,
+                 data.expr_return_var, "1.0", data.expr_return_var);
     } else {
-      tac.append(TAC::InstrType::ADD, data.expr_return_var, "1",
-                 data.expr_return_var);
+      tac.append(TAC::InstrType::ADD, data.expr_return_type,
+                 data.expr_return_var, "1", data.expr_return_var);
     }
   }
 
+  const VariableExprNode* get_var() const { return var_; }
+
  protected:
   VariableExprNode* var_;
 };
 
 class DecrStmNode : public IncrDecrStmNode {
  public:
-  DecrStmNode(VariableExprNode* var) : var_(var) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Decr;
+  }
 
-  virtual const std::string str() const override {
-    return std::string("(-- ") + tostr(var_) + ')';
+  DecrStmNode(VariableExprNode* var)
+      : IncrDecrStmNode(NodeKind::Decr), var_(var) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(-- " << var_ << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     var_->icg(data, tac);
-    tac.append(TAC::InstrType::SUB, data.expr_return_var,
+    check_assignable(data, var_->get_symbol(data));
+    tac.append(TAC::InstrType::SUB, data.expr_return_type,
+               data.expr_return_var,
                data.expr_return_type == ValueType::RealVal ? "1.0" : "1",
                data.expr_return_var);
   }
 
+  const VariableExprNode* get_var() const { return var_; }
+
  protected:
   VariableExprNode* var_;
 };
 
 class ReturnStmNode : public StmNode {
  public:
-  ReturnStmNode() : expr_(nullptr) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Return;
+  }
 
-  ReturnStmNode(ExprNode* expr) : expr_(expr) {}
+  ReturnStmNode() : StmNode(NodeKind::Return), expr_(nullptr) {}
 
-  virtual const std::string str() const override {
-    std::string s("(RET ");
+  ReturnStmNode(ExprNode* expr) : StmNode(NodeKind::Return), expr_(expr) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(RET ";
     if (expr_ != nullptr) {
-      s += tostr(expr_);
+      out << expr_;
     }
-    s += ')';
-    return s;
+    out << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
+    SymbolTable::Entry* entry = data.sym_table.lookup("", data.method_name);
     if (expr_ != nullptr) {
-      expr_->icg(data, tac);
-      tac.append(TAC::InstrType::ASSIGN, data.expr_return_var,
+      child_icg(expr_, data, tac);
+      tac.append(TAC::InstrType::ASSIGN,
+                 convert(data, tac, data.expr_return_var,
+                         data.expr_return_type,
+                         entry != nullptr ? entry->value_type
+                                          : ValueType::VoidVal),
                  data.method_name);
     }
     tac.append(TAC::InstrType::RETURN);
 
-    SymbolTable::Entry* entry = data.sym_table.lookup("", data.method_name);
     if (entry != nullptr) {
       if ((expr_ != nullptr && entry->value_type == ValueType::VoidVal) ||
           (expr_ == nullptr && entry->value_type != ValueType::VoidVal)) {
-        error_msg("Return statement in '" + data.method_name +
+        error_msg(data, DiagId::ReturnValue,
+                  "Return statement in '" + data.method_name +
                   "' does not match return value.");
       }
       if (expr_ != nullptr && data.expr_return_type != entry->value_type) {
-        warning_msg("Returned value in '" + data.method_name +
+        warning_msg(data, DiagId::ReturnType,
+                    "Returned value in '" + data.method_name +
                     "' does not match return type.");
       }
     }
   }
 
+  // nullptr in a method returning void.
+  const ExprNode* get_expr() const { return expr_; }
+
  protected:
   ExprNode* expr_;
 };
 
 class BreakStmNode : public StmNode {
  public:
-  BreakStmNode() {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Break;
+  }
+
+  BreakStmNode() : StmNode(NodeKind::Break) {}
 
-  virtual const std::string str() const override {
-    return std::string("(BREAK)");
+  virtual void print(AstPrinter& out) const override {
+    out << "(BREAK)";
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
@@ -782,17 +1730,22 @@ class BreakStmNode : public StmNode {
       std::string label = tac.label_name("for_end", data.for_label_no.top());
       tac.append(TAC::InstrType::GOTO, label);
     } else {
-      error_msg("Break statement used outside a loop.");
+      error_msg(data, DiagId::BreakOutsideLoop,
+                "Break statement used outside a loop.");
     }
   }
 };
 
 class ContinueStmNode : public StmNode {
  public:
-  ContinueStmNode() {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Continue;
+  }
+
+  ContinueStmNode() : StmNode(NodeKind::Continue) {}
 
-  virtual const std::string str() const override {
-    return std::string("(CONTINUE)");
+  virtual void print(AstPrinter& out) const override {
+    out << "(CONTINUE)";
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
@@ -800,73 +1753,92 @@ class ContinueStmNode : public StmNode {
       std::string label = tac.label_name("for_incr", data.for_label_no.top());
       tac.append(TAC::InstrType::GOTO, label);
     } else {
-      error_msg("Continue statement used outside a loop.");
+      error_msg(data, DiagId::ContinueOutsideLoop,
+                "Continue statement used outside a loop.");
     }
   }
 };
 
 class BlockStmNode : public StmNode {
  public:
-  BlockStmNode(std::list<StmNode*>* stms) : stms_(stms) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Block;
+  }
 
-  virtual const std::string str() const override {
-    std::string s("(BLOCK");
+  BlockStmNode(std::list<StmNode*>* stms)
+      : StmNode(NodeKind::Block), stms_(stms) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(BLOCK";
     for (auto stm : *stms_) {
-      s += " " + tostr(stm);
+      out << " " << stm;
     }
-    s += ")";
-    return s;
-  };
+    out << ")";
+  }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     for (auto stm : *stms_) {
-      stm->icg(data, tac);
+      child_icg(stm, data, tac);
     }
   }
 
+  const std::list<StmNode*>* get_stms() const { return stms_; }
+
  protected:
   std::list<StmNode*>* stms_;
 };
 
 class IfStmNode : public StmNode {
  public:
-  IfStmNode(ExprNode* expr, BlockStmNode* stm_if, BlockStmNode* stm_else)
-      : expr_(expr), stm_if_(stm_if), stm_else_(stm_else) {}
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::If;
+  }
 
-  virtual const std::string str() const override {
-    std::string s("(IF ");
-    s += tostr(expr_) + tostr(stm_if_);
+  IfStmNode(ExprNode* expr, BlockStmNode* stm_if, BlockStmNode* stm_else)
+      : StmNode(NodeKind::If),
+        expr_(expr),
+        stm_if_(stm_if),
+        stm_else_(stm_else) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(IF ";
+    out << expr_ << stm_if_;
     if (stm_else_ != nullptr) {
-      s += tostr(stm_else_);
+      out << stm_else_;
     }
-    s += ')';
-    return s;
-  };
+    out << ')';
+  }
 
   virtual void icg(Data& data, TAC& tac) const override {
     std::string lab_true_block = tac.label_name("true_block", data.label_no);
     std::string lab_if_end = tac.label_name("if_end", data.label_no);
     data.label_no++;
 
-    expr_->icg(data, tac);
+    child_icg(expr_, data, tac);
     if (data.expr_return_type != ValueType::IntVal) {
-      warning_msg(
-          "Type mismatch in if statement (conditional statement is not an "
-          "integer value).");
+      warning_msg(data, DiagId::ConditionType,
+                  "Type mismatch in if statement (conditional statement is not "
+                  "an integer value).");
     }
-    tac.append(TAC::InstrType::NE, data.expr_return_var, "0", lab_true_block);
+    tac.append(TAC::InstrType::NE, data.expr_return_type, data.expr_return_var,
+               tac.zero(data.expr_return_type), lab_true_block);
     if (stm_else_ != nullptr) {
-      stm_else_->icg(data, tac);
+      child_icg(stm_else_, data, tac);
     }
     tac.append(TAC::InstrType::GOTO, lab_if_end);
 
     tac.label_next_instr(lab_true_block);
-    stm_if_->icg(data, tac);
+    child_icg(stm_if_, data, tac);
 
     tac.label_next_instr(lab_if_end);
   }
 
+  const ExprNode* get_expr() const { return expr_; }
+  const BlockStmNode* get_if() const { return stm_if_; }
+  // nullptr if there is no else block.
+  const BlockStmNode* get_else() const { return stm_else_; }
+
  protected:
   ExprNode* expr_;
   BlockStmNode *stm_if_, *stm_else_;
@@ -874,14 +1846,21 @@ class IfStmNode : public StmNode {
 
 class ForStmNode : public StmNode {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::For;
+  }
+
   ForStmNode(AssignStmNode* assign, ExprNode* expr, IncrDecrStmNode* inc_dec,
              BlockStmNode* stms_)
-      : assign_(assign), expr_(expr), inc_dec_(inc_dec), stms_(stms_) {}
-
-  virtual const std::string str() const override {
-    return "(FOR " + tostr(assign_) + tostr(expr_) + tostr(inc_dec_) +
-           tostr(stms_) + ')';
-  };
+      : StmNode(NodeKind::For),
+        assign_(assign),
+        expr_(expr),
+        inc_dec_(inc_dec),
+        stms_(stms_) {}
+
+  virtual void print(AstPrinter& out) const override {
+    out << "(FOR " << assign_ << expr_ << inc_dec_ << stms_ << ')';
+  }
 
   virtual void icg(Data& data, TAC& tac) const override {
     std::string lab_for_expr = tac.label_name("for_expr", data.label_no);
@@ -891,28 +1870,125 @@ class ForStmNode : public StmNode {
 
     data.label_no++;
 
-    assign_->icg(data, tac);
+    child_icg(assign_, data, tac);
 
     tac.label_next_instr(lab_for_expr);
-    expr_->icg(data, tac);
+    child_icg(expr_, data, tac);
     if (data.expr_return_type != ValueType::IntVal) {
-      warning_msg(
-          "Type mismatch in for statement (conditional statement is not an "
-          "integer value).");
+      warning_msg(data, DiagId::ConditionType,
+                  "Type mismatch in for statement (conditional statement is "
+                  "not an integer value).");
     }
 
-    tac.append(TAC::InstrType::EQ, data.expr_return_var, "0", lab_for_end);
-    stms_->icg(data, tac);
+    tac.append(TAC::InstrType::EQ, data.expr_return_type, data.expr_return_var,
+               tac.zero(data.expr_return_type), lab_for_end);
+    LoopRange range;
+    bool ranged = loop_range(data, range);
+    if (ranged) {
+      data.loop_ranges.push_back(range);
+    }
+    child_icg(stms_, data, tac);
+    if (ranged) {
+      data.loop_ranges.pop_back();
+    }
 
     tac.label_next_instr(lab_for_incr);
-    inc_dec_->icg(data, tac);
+    child_icg(inc_dec_, data, tac);
     tac.append(TAC::InstrType::GOTO, lab_for_expr);
 
     tac.label_next_instr(lab_for_end);
     data.for_label_no.pop();
   }
 
+  const AssignStmNode* get_assign() const { return assign_; }
+  const ExprNode* get_expr() const { return expr_; }
+  const IncrDecrStmNode* get_incr_decr() const { return inc_dec_; }
+  const BlockStmNode* get_block() const { return stms_; }
+
  protected:
+  // The range of the loop variable in the body, if known (see ::loop_range).
+  bool loop_range(Data& data, LoopRange& range) const {
+    const std::string& var = assign_->get_var()->get_id();
+    auto relational = dyn_cast<RelationalExprNode>(expr_);
+    if (relational == nullptr || stepped(inc_dec_) != var) {
+      return false;
+    }
+    auto lhs = dyn_cast<VariableExprNode>(relational->get_lhs());
+    if (lhs == nullptr || lhs->get_id() != var) {
+      return false;
+    }
+    TAC::InstrType op;
+    switch (expr_->kind()) {
+      case NodeKind::Lt:
+        op = TAC::InstrType::LT;
+        break;
+      case NodeKind::Lte:
+        op = TAC::InstrType::LE;
+        break;
+      case NodeKind::Gt:
+        op = TAC::InstrType::GT;
+        break;
+      case NodeKind::Gte:
+        op = TAC::InstrType::GE;
+        break;
+      default:
+        return false;
+    }
+    if (!::loop_range(data, var, spelling(assign_->get_expr()), op,
+                      spelling(relational->get_rhs()),
+                      isa<IncrStmNode>(inc_dec_), range)) {
+      return false;
+    }
+
+    // The body must not assign the variable, at any depth.
+    std::vector<const StmNode*> stms(1, stms_);
+    while (!stms.empty()) {
+      const StmNode* stm = stms.back();
+      stms.pop_back();
+      if (auto block = dyn_cast<BlockStmNode>(stm)) {
+        stms.insert(stms.end(), block->get_stms()->begin(),
+                    block->get_stms()->end());
+      } else if (auto if_stm = dyn_cast<IfStmNode>(stm)) {
+        stms.push_back(if_stm->get_if());
+        if (if_stm->get_else() != nullptr) {
+          stms.push_back(if_stm->get_else());
+        }
+      } else if (auto for_stm = dyn_cast<ForStmNode>(stm)) {
+        stms.push_back(for_stm->get_assign());
+        stms.push_back(for_stm->get_incr_decr());
+        stms.push_back(for_stm->get_block());
+      } else if (auto assign = dyn_cast<AssignStmNode>(stm)) {
+        if (assign->get_var()->get_id() == var) {
+          return false;
+        }
+      } else if (auto incr_decr = dyn_cast<IncrDecrStmNode>(stm)) {
+        if (stepped(incr_decr) == var) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // The variable that a ++ or -- steps.
+  static std::string stepped(const IncrDecrStmNode* incr_decr) {
+    if (auto incr = dyn_cast<IncrStmNode>(incr_decr)) {
+      return incr->get_var()->get_id();
+    }
+    return static_cast<const DecrStmNode*>(incr_decr)->get_var()->get_id();
+  }
+
+  // The literal of a number, or the name of a variable; empty otherwise.
+  static std::string spelling(const ExprNode* expr) {
+    if (auto number = dyn_cast<NumberExprNode>(expr)) {
+      return number->get_value();
+    }
+    if (auto variable = dyn_cast<VariableExprNode>(expr)) {
+      return variable->get_id();
+    }
+    return "";
+  }
+
   AssignStmNode* assign_;
   ExprNode* expr_;
   IncrDecrStmNode* inc_dec_;
@@ -921,57 +1997,83 @@ class ForStmNode : public StmNode {
 
 /////////////////////////////////////////////////////////////////////////////////
 
+class MethodNode;
+
+// Name resolution (name_resolution.cpp): bind each variable use and method
+// call in the statements of 'method' to its entry in data.sym_table, or to
+// nullptr if the name is undeclared, in data.symbols, so that icg reads the
+// entry from there instead of looking the name up at each use.
+// MethodNode::icg runs it once the method's parameters and variables are in
+// the table, as a name refers to what is declared up to the method it is in.
+void resolve_names(const MethodNode* method, Data& data);
+
 class MethodNode : public Node {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Method;
+  }
+
   MethodNode(ValueType return_type, std::string id,
              std::list<ParameterNode*>* params,
              std::list<VariableDeclarationNode*>* var_decls,
              std::list<StmNode*>* stms)
-      : return_type_(return_type),
+      : Node(NodeKind::Method),
+        return_type_(return_type),
         id_(id),
         params_(params),
         var_decls_(var_decls),
         stms_(stms) {}
 
-  virtual const std::string str() const override {
-    std::string s = "(METHOD " + tostr(return_type_) + ' ' + id_ + ' ';
+  virtual void print(AstPrinter& out) const override {
+    out << "(METHOD " << tostr(return_type_) << ' ' << id_ << ' ';
     for (auto p : *params_) {
-      s += tostr(p);
+      out << p;
     }
     for (auto vds : *var_decls_) {
-      s += tostr(vds);
+      out << vds;
     }
     for (auto stm : *stms_) {
-      s += tostr(stm);
+      out << stm;
     }
-    s += ')';
-    return s;
+    out << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
-    std::string signature;
+    declare(data, tac);
+    // All of the method's names are declared by now, and the methods before
+    // it, but not those after it.
+    resolve_names(this, data);
+    define(data, tac);
+  }
+
+  // The first part of icg: enter the method, its parameters and variables
+  // into the symbol table, and generate their code.
+  void declare(Data& data, TAC& tac) const {
+    Signature signature;
     data.method_name = id_;
     tac.label_next_instr(data.method_name);
     for (auto pd : *params_) {
       pd->icg(data, tac);
-      if (!signature.empty()) {
-        signature += "::";
-      }
-      signature += tostr(pd->get_type());
+      signature.push_back(pd->get_type());
     }
-    add_to_symbol_table(data.sym_table, EntryType::Method, "", id_,
+    add_to_symbol_table(data, EntryType::Method, "", id_,
                         return_type_, signature);
     // Prevent someone from using a variable with the same name as the enclosing
     // method.
-    add_to_symbol_table(data.sym_table, EntryType::Method, id_, id_,
+    add_to_symbol_table(data, EntryType::Method, id_, id_,
                         return_type_, signature);
 
     for (auto vd : *var_decls_) {
-      vd->icg(data, tac);
+      child_icg(vd, data, tac);
     }
+  }
+
+  // The rest of icg, after declare() and resolve_names(): generate the code
+  // of the statements. The symbol table is only read from here on.
+  void define(Data& data, TAC& tac) const {
     for (auto stm : *stms_) {
-      stm->icg(data, tac);
+      child_icg(stm, data, tac);
     }
     if (tac.last_instr_type() != TAC::InstrType::RETURN) {
       tac.append(TAC::InstrType::RETURN);
@@ -979,6 +2081,14 @@ class MethodNode : public Node {
     data.method_name = "";
   }
 
+  ValueType get_return_type() const { return return_type_; }
+  const std::string& get_id() const { return id_; }
+  const std::list<ParameterNode*>* get_params() const { return params_; }
+  const std::list<VariableDeclarationNode*>* get_var_decls() const {
+    return var_decls_;
+  }
+  const std::list<StmNode*>* get_stms() const { return stms_; }
+
  protected:
   ValueType return_type_;
   std::string id_;
@@ -989,46 +2099,69 @@ class MethodNode : public Node {
 
 class ProgramNode : public Node {
  public:
+  static bool classof(const Node* node) {
+    return node->kind() == NodeKind::Program;
+  }
+
   ProgramNode(std::string id, std::list<VariableDeclarationNode*>* var_decls,
               std::list<MethodNode*>* method_decls)
-      : id_(id), var_decls_(var_decls), method_decls_(method_decls) {}
+      : Node(NodeKind::Program),
+        id_(id),
+        var_decls_(var_decls),
+        method_decls_(method_decls) {}
 
-  virtual const std::string str() const override {
-    std::string s = "(CLASS " + id_;
+  virtual void print(AstPrinter& out) const override {
+    out << "(CLASS " << id_;
     if (var_decls_ != nullptr) {
       for (auto v : *var_decls_) {
-        s += " " + tostr(v);
+        out << " " << v;
       }
     }
     if (method_decls_ != nullptr) {
       for (auto m : *method_decls_) {
-        s += " " + tostr(m);
+        out << " " << m;
       }
     }
-    s += ')';
-    return s;
+    out << ')';
   }
 
   virtual void icg(Data& data, TAC& tac) const override {
     // Provided.
     for (auto vd : *var_decls_) {
-      vd->icg(data, tac);
+      child_icg(vd, data, tac);
     }
     tac.append(TAC::InstrType::GOTO, "main");
     for (auto md : *method_decls_) {
-      md->icg(data, tac);
+      child_icg(md, data, tac);
     }
 
     SymbolTable::Entry* entry = data.sym_table.lookup("", "main");
     if (entry == nullptr) {
-      error_msg("Main method is missing.");
+      error_msg(data, DiagId::MissingMain, "Main method is missing.");
     }
   }
 
+  const std::string& get_id() const { return id_; }
+  // nullptr if there are none.
+  const std::list<VariableDeclarationNode*>* get_var_decls() const {
+    return var_decls_;
+  }
+  std::list<MethodNode*>* get_method_decls() const { return method_decls_; }
+
  protected:
   std::string id_;
   std::list<VariableDeclarationNode*>* var_decls_;
   std::list<MethodNode*>* method_decls_;
 };
 
+// Parallel code generation (parallel_icg.cpp): generate the code of 'program'
+// as icg does, but that of the method bodies on up to 'workers' threads. The
+// methods are declared, and their names resolved, in order before any body is
+// generated, so that, as with icg, a call to a method declared after the
+// caller is an error. Each method has its own temporaries, numbered from 0, and labels named after
+// it ("lab_<method>_<substr>_<no>"), and its code and diagnostics are put
+// together in source order, so the output does not depend on the threads.
+void parallel_icg(const ProgramNode* program, Data& data, TAC& tac,
+                  unsigned workers);
+
 #endif  // DECAFPARSER_AST_H
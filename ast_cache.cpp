@@ -0,0 +1,196 @@
+#include "ast_cache.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+static const char Magic[4] = {'D', 'A', 'S', 'T'};
+static const uint32_t Version = 7;
+
+uint64_t source_hash(const string& src) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : src) {
+    hash = (hash ^ c) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static size_t aligned(size_t size) { return (size + 3) & ~size_t(3); }
+
+template <typename T>
+static void append(string& out, const T* data, size_t count) {
+  out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+  out.resize(aligned(out.size()), '\0');
+}
+
+string serialize_ast(const FlatAst& ast, uint64_t hash, size_t source_size) {
+  vector<uint32_t> offsets;
+  offsets.reserve(ast.strings.size() + 1);
+  string bytes;
+  for (const string& s : ast.strings) {
+    offsets.push_back(static_cast<uint32_t>(bytes.size()));
+    bytes += s;
+  }
+  offsets.push_back(static_cast<uint32_t>(bytes.size()));
+
+  AstFileHeader header;
+  memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.source_hash = hash;
+  header.root = ast.root;
+  header.node_count = ast.size();
+  header.child_count = static_cast<uint32_t>(ast.children.size());
+  header.string_count = static_cast<uint32_t>(ast.strings.size());
+  header.string_bytes = static_cast<uint32_t>(bytes.size());
+  header.source_size = static_cast<uint32_t>(source_size);
+
+  string out;
+  append(out, &header, 1);
+  append(out, ast.kinds.data(), ast.kinds.size());
+  append(out, ast.types.data(), ast.types.size());
+  append(out, ast.values.data(), ast.values.size());
+  append(out, ast.locations.data(), ast.locations.size());
+  append(out, ast.child_begins.data(), ast.child_begins.size());
+  append(out, ast.children.data(), ast.children.size());
+  append(out, offsets.data(), offsets.size());
+  append(out, bytes.data(), bytes.size());
+  return out;
+}
+
+namespace {
+
+// Takes the sections of a serialized AST in turn.
+class SectionReader {
+ public:
+  SectionReader(const char* bytes, size_t size)
+      : pos_(bytes), end_(bytes + size) {}
+
+  // Copy the next section, of 'count' values, into 'values'. Returns false
+  // if the bytes run out.
+  template <typename T>
+  bool read(size_t count, vector<T>& values) {
+    const T* begin = reinterpret_cast<const T*>(pos_);
+    if (!skip(count * sizeof(T))) {
+      return false;
+    }
+    values.assign(begin, begin + count);
+    return true;
+  }
+
+  const char* pos() const { return pos_; }
+
+  bool skip(size_t size) {
+    if (static_cast<size_t>(end_ - pos_) < aligned(size)) {
+      return false;
+    }
+    pos_ += aligned(size);
+    return true;
+  }
+
+  bool at_end() const { return pos_ == end_; }
+
+ private:
+  const char* pos_;
+  const char* end_;
+};
+
+}  // namespace
+
+bool deserialize_ast(const char* bytes, size_t size, uint64_t hash,
+                     size_t source_size, FlatAst& ast) {
+  if (size < sizeof(AstFileHeader) ||
+      reinterpret_cast<uintptr_t>(bytes) % alignof(AstFileHeader) != 0) {
+    return false;
+  }
+  const AstFileHeader& header = *reinterpret_cast<const AstFileHeader*>(bytes);
+  if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version || header.source_hash != hash ||
+      header.source_size != static_cast<uint32_t>(source_size)) {
+    return false;
+  }
+  SectionReader in(bytes, size);
+  in.skip(sizeof(AstFileHeader));
+  vector<uint32_t> offsets;
+  if (!in.read(header.node_count, ast.kinds) ||
+      !in.read(header.node_count, ast.types) ||
+      !in.read(header.node_count, ast.values) ||
+      !in.read(header.node_count, ast.locations) ||
+      !in.read(size_t(header.node_count) + 1, ast.child_begins) ||
+      !in.read(header.child_count, ast.children) ||
+      !in.read(size_t(header.string_count) + 1, offsets)) {
+    return false;
+  }
+  const char* string_bytes = in.pos();
+  if (!in.skip(header.string_bytes) || !in.at_end() ||
+      offsets.back() != header.string_bytes) {
+    return false;
+  }
+  ast.strings.clear();
+  ast.strings.reserve(header.string_count);
+  for (uint32_t i = 0; i < header.string_count; ++i) {
+    if (offsets[i] > offsets[i + 1]) {
+      return false;
+    }
+    ast.strings.emplace_back(string_bytes + offsets[i],
+                             offsets[i + 1] - offsets[i]);
+  }
+  ast.root = header.root;
+  return ast.check();
+}
+
+string AstCache::path(uint64_t hash) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.ast",
+           static_cast<unsigned long long>(hash));
+  return dir_ + '/' + name;
+}
+
+bool AstCache::load(const string& src, FlatAst& ast) const {
+  uint64_t hash = source_hash(src);
+  int fd = open(path(hash).c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    size_t size = static_cast<size_t>(st.st_size);
+    void* bytes = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (bytes != MAP_FAILED) {
+      ok = deserialize_ast(static_cast<const char*>(bytes), size, hash,
+                           src.size(), ast);
+      munmap(bytes, size);
+    }
+  }
+  close(fd);
+  return ok;
+}
+
+bool AstCache::store(const string& src, const FlatAst& ast) const {
+  if (mkdir(dir_.c_str(), 0777) != 0 && errno != EEXIST) {
+    return false;
+  }
+  uint64_t hash = source_hash(src);
+  string bytes = serialize_ast(ast, hash, src.size());
+
+  // Written under a name of its own and renamed into place, so that other
+  // compilers sharing the cache never see part of a file.
+  string file = path(hash);
+  string tmp = file + '.' + to_string(getpid());
+  FILE* out = fopen(tmp.c_str(), "wb");
+  if (out == nullptr) {
+    return false;
+  }
+  bool ok = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+  ok = (fclose(out) == 0) && ok;
+  if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+    remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,59 @@
+#ifndef DECAFPARSER_AST_CACHE_H
+#define DECAFPARSER_AST_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include "flat_ast.h"
+
+// A serialized AST is a header followed by the arrays of its FlatAst in
+// order, with the strings as a table of offsets and then their bytes, each
+// section 4-byte aligned. It is in the byte order of the machine that wrote
+// it; the cache is meant for rebuilds on one machine.
+struct AstFileHeader {
+  char magic[4];  // "DAST"
+  uint32_t version;
+  uint64_t source_hash;  // Of the source the AST was parsed from.
+  uint32_t root;
+  uint32_t node_count;
+  uint32_t child_count;
+  uint32_t string_count;
+  uint32_t string_bytes;
+  uint32_t source_size;  // In bytes, modulo 2^32; checked along with the hash.
+};
+
+// 64-bit FNV-1a hash of a program's source.
+uint64_t source_hash(const std::string& src);
+
+std::string serialize_ast(const FlatAst& ast, uint64_t hash,
+                          size_t source_size);
+
+// Read an AST from 'size' bytes at 'bytes' into 'ast'. Returns false unless
+// they are a well-formed AST serialized from a source with the given hash and
+// size.
+bool deserialize_ast(const char* bytes, size_t size, uint64_t hash,
+                     size_t source_size, FlatAst& ast);
+
+// A directory of serialized ASTs, one file per source hash, which lets an
+// unchanged program skip lexing and parsing: load() maps the file in and
+// copies the arrays out of it.
+class AstCache {
+ public:
+  // The directory is created on the first store() if it does not exist.
+  explicit AstCache(const std::string& dir) : dir_(dir) {}
+
+  // Read the AST of 'src' into 'ast'. Returns false if it is not in the
+  // cache.
+  bool load(const std::string& src, FlatAst& ast) const;
+
+  // Add the AST of 'src' to the cache. Returns false if it could not be
+  // written, which leaves the cache as it was.
+  bool store(const std::string& src, const FlatAst& ast) const;
+
+  // The file holding the AST of a source with the given hash.
+  std::string path(uint64_t hash) const;
+
+ private:
+  std::string dir_;
+};
+
+#endif  // DECAFPARSER_AST_CACHE_H
@@ -0,0 +1,283 @@
+#ifndef DECAFPARSER_AST_VISITOR_H
+#define DECAFPARSER_AST_VISITOR_H
+
+#include "ast.h"
+
+// A pass over the AST without a virtual method per node class: visit()
+// switches on the node kind and calls Derived's visit_<kind> for it
+// statically, so that the compiler can inline the pass into the traversal.
+//
+//   class Counter : public AstVisitor<Counter, int> {
+//    public:
+//     int visit_number(const NumberExprNode*) { return 1; }
+//     int visit_expr(const ExprNode*) { return 0; }
+//     ...
+//   };
+//
+// A visit_<kind> that Derived does not define falls back to the visit_ of
+// the node's group (visit_relational, visit_arithmetic, visit_bitwise,
+// visit_expr, visit_stm, and visit_variable_declaration for a constant or
+// array) and from there to
+// visit_node, which returns Result(). Derived visits the children itself, as
+// it needs, through visit(). A method call is visited through its ExprNode or
+// StmNode part, never as a plain Node.
+template <typename Derived, typename Result = void>
+class AstVisitor {
+ public:
+  Result visit(const Node* node) {
+    switch (node->kind()) {
+      case NodeKind::VariableDeclaration:
+        return derived().visit_variable_declaration(
+            static_cast<const VariableDeclarationNode*>(node));
+      case NodeKind::ConstantDeclaration:
+        return derived().visit_constant_declaration(
+            static_cast<const ConstantDeclarationNode*>(node));
+      case NodeKind::ArrayDeclaration:
+        return derived().visit_array_declaration(
+            static_cast<const ArrayDeclarationNode*>(node));
+      case NodeKind::Parameter:
+        return derived().visit_parameter(
+            static_cast<const ParameterNode*>(node));
+      case NodeKind::Method:
+        return derived().visit_method(static_cast<const MethodNode*>(node));
+      case NodeKind::Program:
+        return derived().visit_program(static_cast<const ProgramNode*>(node));
+      default:
+        assert(node->kind() != NodeKind::MethodCall);
+        if (is_expr(node->kind())) {
+          return visit(static_cast<const ExprNode*>(node));
+        }
+        return visit(static_cast<const StmNode*>(node));
+    }
+  }
+
+  Result visit(const ExprNode* node) {
+    switch (node->kind()) {
+      case NodeKind::Number:
+        return derived().visit_number(static_cast<const NumberExprNode*>(node));
+      case NodeKind::And:
+        return derived().visit_and(static_cast<const AndExprNode*>(node));
+      case NodeKind::Or:
+        return derived().visit_or(static_cast<const OrExprNode*>(node));
+      case NodeKind::Not:
+        return derived().visit_not(static_cast<const NotExprNode*>(node));
+      case NodeKind::Eq:
+        return derived().visit_eq(static_cast<const EqExprNode*>(node));
+      case NodeKind::Neq:
+        return derived().visit_neq(static_cast<const NeqExprNode*>(node));
+      case NodeKind::Lt:
+        return derived().visit_lt(static_cast<const LtExprNode*>(node));
+      case NodeKind::Lte:
+        return derived().visit_lte(static_cast<const LteExprNode*>(node));
+      case NodeKind::Gt:
+        return derived().visit_gt(static_cast<const GtExprNode*>(node));
+      case NodeKind::Gte:
+        return derived().visit_gte(static_cast<const GteExprNode*>(node));
+      case NodeKind::Multiply:
+        return derived().visit_multiply(
+            static_cast<const MultiplyExprNode*>(node));
+      case NodeKind::Divide:
+        return derived().visit_divide(static_cast<const DivideExprNode*>(node));
+      case NodeKind::Modulus:
+        return derived().visit_modulus(
+            static_cast<const ModulusExprNode*>(node));
+      case NodeKind::Plus:
+        return derived().visit_plus(static_cast<const PlusExprNode*>(node));
+      case NodeKind::Minus:
+        return derived().visit_minus(static_cast<const MinusExprNode*>(node));
+      case NodeKind::BitAnd:
+        return derived().visit_bit_and(
+            static_cast<const BitAndExprNode*>(node));
+      case NodeKind::BitOr:
+        return derived().visit_bit_or(static_cast<const BitOrExprNode*>(node));
+      case NodeKind::BitXor:
+        return derived().visit_bit_xor(
+            static_cast<const BitXorExprNode*>(node));
+      case NodeKind::ShiftLeft:
+        return derived().visit_shift_left(
+            static_cast<const ShiftLeftExprNode*>(node));
+      case NodeKind::ShiftRight:
+        return derived().visit_shift_right(
+            static_cast<const ShiftRightExprNode*>(node));
+      case NodeKind::Complement:
+        return derived().visit_complement(
+            static_cast<const ComplementExprNode*>(node));
+      case NodeKind::Variable:
+        return derived().visit_variable(
+            static_cast<const VariableExprNode*>(node));
+      case NodeKind::Index:
+        return derived().visit_index(static_cast<const IndexExprNode*>(node));
+      default:
+        assert(node->kind() == NodeKind::MethodCall);
+        return derived().visit_method_call(
+            static_cast<const MethodCallExprStmNode*>(node));
+    }
+  }
+
+  Result visit(const StmNode* node) {
+    switch (node->kind()) {
+      case NodeKind::MethodCall:
+        return derived().visit_method_call(
+            static_cast<const MethodCallExprStmNode*>(node));
+      case NodeKind::Assign:
+        return derived().visit_assign(static_cast<const AssignStmNode*>(node));
+      case NodeKind::IndexAssign:
+        return derived().visit_index_assign(
+            static_cast<const IndexAssignStmNode*>(node));
+      case NodeKind::Incr:
+        return derived().visit_incr(static_cast<const IncrStmNode*>(node));
+      case NodeKind::Decr:
+        return derived().visit_decr(static_cast<const DecrStmNode*>(node));
+      case NodeKind::Return:
+        return derived().visit_return(static_cast<const ReturnStmNode*>(node));
+      case NodeKind::Break:
+        return derived().visit_break(static_cast<const BreakStmNode*>(node));
+      case NodeKind::Continue:
+        return derived().visit_continue(
+            static_cast<const ContinueStmNode*>(node));
+      case NodeKind::Block:
+        return derived().visit_block(static_cast<const BlockStmNode*>(node));
+      case NodeKind::If:
+        return derived().visit_if(static_cast<const IfStmNode*>(node));
+      default:
+        assert(node->kind() == NodeKind::For);
+        return derived().visit_for(static_cast<const ForStmNode*>(node));
+    }
+  }
+
+  // The fallbacks.
+  Result visit_node(const Node*) { return Result(); }
+  Result visit_expr(const ExprNode* node) { return derived().visit_node(node); }
+  Result visit_stm(const StmNode* node) { return derived().visit_node(node); }
+  Result visit_relational(const RelationalExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_arithmetic(const ArithmeticExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_bitwise(const BitwiseExprNode* node) {
+    return derived().visit_expr(node);
+  }
+
+  Result visit_number(const NumberExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_and(const AndExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_or(const OrExprNode* node) { return derived().visit_expr(node); }
+  Result visit_not(const NotExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_eq(const EqExprNode* node) {
+    return derived().visit_relational(node);
+  }
+  Result visit_neq(const NeqExprNode* node) {
+    return derived().visit_relational(node);
+  }
+  Result visit_lt(const LtExprNode* node) {
+    return derived().visit_relational(node);
+  }
+  Result visit_lte(const LteExprNode* node) {
+    return derived().visit_relational(node);
+  }
+  Result visit_gt(const GtExprNode* node) {
+    return derived().visit_relational(node);
+  }
+  Result visit_gte(const GteExprNode* node) {
+    return derived().visit_relational(node);
+  }
+  Result visit_multiply(const MultiplyExprNode* node) {
+    return derived().visit_arithmetic(node);
+  }
+  Result visit_divide(const DivideExprNode* node) {
+    return derived().visit_arithmetic(node);
+  }
+  Result visit_modulus(const ModulusExprNode* node) {
+    return derived().visit_arithmetic(node);
+  }
+  Result visit_plus(const PlusExprNode* node) {
+    return derived().visit_arithmetic(node);
+  }
+  Result visit_minus(const MinusExprNode* node) {
+    return derived().visit_arithmetic(node);
+  }
+  Result visit_bit_and(const BitAndExprNode* node) {
+    return derived().visit_bitwise(node);
+  }
+  Result visit_bit_or(const BitOrExprNode* node) {
+    return derived().visit_bitwise(node);
+  }
+  Result visit_bit_xor(const BitXorExprNode* node) {
+    return derived().visit_bitwise(node);
+  }
+  Result visit_shift_left(const ShiftLeftExprNode* node) {
+    return derived().visit_bitwise(node);
+  }
+  Result visit_shift_right(const ShiftRightExprNode* node) {
+    return derived().visit_bitwise(node);
+  }
+  Result visit_complement(const ComplementExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_variable(const VariableExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_index(const IndexExprNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_variable_declaration(const VariableDeclarationNode* node) {
+    return derived().visit_node(node);
+  }
+  Result visit_constant_declaration(const ConstantDeclarationNode* node) {
+    return derived().visit_variable_declaration(node);
+  }
+  Result visit_array_declaration(const ArrayDeclarationNode* node) {
+    return derived().visit_variable_declaration(node);
+  }
+  Result visit_parameter(const ParameterNode* node) {
+    return derived().visit_node(node);
+  }
+  Result visit_method_call(const MethodCallExprStmNode* node) {
+    return derived().visit_expr(node);
+  }
+  Result visit_assign(const AssignStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_index_assign(const IndexAssignStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_incr(const IncrStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_decr(const DecrStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_return(const ReturnStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_break(const BreakStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_continue(const ContinueStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_block(const BlockStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_if(const IfStmNode* node) { return derived().visit_stm(node); }
+  Result visit_for(const ForStmNode* node) {
+    return derived().visit_stm(node);
+  }
+  Result visit_method(const MethodNode* node) {
+    return derived().visit_node(node);
+  }
+  Result visit_program(const ProgramNode* node) {
+    return derived().visit_node(node);
+  }
+
+ private:
+  Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+#endif  // DECAFPARSER_AST_VISITOR_H
@@ -0,0 +1,82 @@
+// Compares code generation over the AST of node objects (Node::icg) with
+// code generation over the same AST in a FlatAst (flat_icg), on generated
+// programs of increasing size, and times converting between the two. Each
+// time is the best of a few runs.
+//
+// Usage: bench_flat [ max_methods ]
+// Output: CSV, one line per corpus size.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "corpus.h"
+#include "flat_ast.h"
+#include "hparser.h"
+#include "measure.h"
+
+using namespace std;
+
+template <typename Work>
+static double best_of(Work work) {
+  const int Runs = 3;
+  double best = 0.0;
+  for (int run = 0; run < Runs; ++run) {
+    auto start = chrono::steady_clock::now();
+    work();
+    double seconds = seconds_since(start);
+    best = (run == 0 ? seconds : min(best, seconds));
+  }
+  return best;
+}
+
+static void generate(const Node* ast) {
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  ast->icg(data, tac);
+}
+
+static void generate(const FlatAst& ast) {
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  flat_icg(ast, data, tac);
+}
+
+int main(int argc, char* argv[]) {
+  int max_methods = (argc >= 2 ? atoi(argv[1]) : 16000);
+
+  cout << "methods,nodes,flat_bytes,flatten_seconds,unflatten_seconds,"
+          "icg_seconds,flat_icg_seconds,speedup"
+       << endl;
+  for (int methods = 250; methods <= max_methods; methods *= 4) {
+    string src = generate_corpus(methods);
+    FILE* file = corpus_file(src);
+    HParser parser(file, false, false);
+    parser.parse();
+    fclose(file);
+    auto program = static_cast<const ProgramNode*>(parser.get_AST());
+
+    FlatAst flat;
+    double flatten_seconds = best_of([&]() {
+      flat = FlatAst();
+      flatten(program, flat);
+    });
+    double unflatten_seconds = best_of([&]() { unflatten(flat); });
+    size_t flat_bytes = flat.kinds.size() + flat.types.size() +
+                        4 * (flat.values.size() + flat.child_begins.size() +
+                             flat.children.size());
+    for (const string& s : flat.strings) {
+      flat_bytes += s.size();
+    }
+
+    double icg_seconds = best_of([&]() { generate(program); });
+    double flat_icg_seconds = best_of([&]() { generate(flat); });
+    cout << methods << ',' << flat.size() << ',' << flat_bytes << ','
+         << flatten_seconds << ',' << unflatten_seconds << ',' << icg_seconds
+         << ',' << flat_icg_seconds << ',' << icg_seconds / flat_icg_seconds
+         << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,112 @@
+// Compares BParser and HParser end to end on generated programs of increasing
+// size. For each parser and size it reports the time spent lexing alone, the
+// rest of the parse time (the whole parse less the lexing), throughput in
+// lines and AST nodes per second, heap allocations made while parsing and the
+// peak RSS of the run.
+//
+// Usage: bench_parser [ max_methods ]
+// Output: CSV, one line per parser and corpus size.
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include "bparser.h"
+#include "corpus.h"
+#include "hparser.h"
+#include "measure.h"
+
+using namespace std;
+
+// Every heap allocation of the program goes through here.
+static long allocations = 0;
+
+void* operator new(size_t size) {
+  ++allocations;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+struct Result {
+  double lex_seconds;    // Scanning the input alone.
+  double total_seconds;  // Scanning and parsing it into an AST.
+  long tokens;
+  long nodes;
+  long allocations;  // Made while parsing.
+};
+
+static void measure(const string& name, const string& src, Result& result) {
+  FILE* file = corpus_file(src);
+  yy::location loc;
+  yyscan_t scanner = scanner_create(file, &loc, false);
+  auto start = chrono::steady_clock::now();
+  while (yylex(scanner).token() != decaf::token_type::EOI) {
+    ++result.tokens;
+  }
+  result.lex_seconds = seconds_since(start);
+  scanner_destroy(scanner);
+  fclose(file);
+
+  file = corpus_file(src);
+  Parser* parser;
+  if (name == "bison") {
+    parser = new BParser(file, false, false);
+  } else {
+    parser = new HParser(file, false, false);
+  }
+  long allocations_before = allocations;
+  start = chrono::steady_clock::now();
+  parser->parse();
+  result.total_seconds = seconds_since(start);
+  result.allocations = allocations - allocations_before;
+
+  // Every node prints as one parenthesized term.
+  string ast = parser->get_AST()->str();
+  for (char c : ast) {
+    result.nodes += (c == '(');
+  }
+  delete parser;
+  fclose(file);
+}
+
+int main(int argc, char* argv[]) {
+  int max_methods = (argc >= 2 ? atoi(argv[1]) : 8000);
+
+  cout << "parser,methods,lines,bytes,tokens,nodes,lex_seconds,parse_seconds,"
+          "total_seconds,lines_per_second,nodes_per_second,allocations,"
+          "peak_rss_kb"
+       << endl;
+  for (int methods = 250; methods <= max_methods; methods *= 2) {
+    string src = generate_corpus(methods);
+    size_t lines = 0;
+    for (char c : src) {
+      lines += (c == '\n');
+    }
+    for (string name : {"bison", "handmade"}) {
+      Result result;
+      long peak_rss_kb = 0;
+      bool ok = run_isolated(
+          [&](Result& child_result) { measure(name, src, child_result); },
+          result, peak_rss_kb);
+      if (!ok) {
+        cerr << "bench_parser: " << name << " failed on " << methods
+             << " methods." << endl;
+        return 1;
+      }
+      cout << name << ',' << methods << ',' << lines << ',' << src.size()
+           << ',' << result.tokens << ',' << result.nodes << ','
+           << result.lex_seconds << ','
+           << result.total_seconds - result.lex_seconds << ','
+           << result.total_seconds << ','
+           << static_cast<long>(lines / result.total_seconds) << ','
+           << static_cast<long>(result.nodes / result.total_seconds) << ','
+           << result.allocations << ',' << peak_rss_kb << endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+// Compares HParser scanning and parsing on one thread with the pipelined
+// HParser, where the scanner runs on a thread of its own, on generated
+// programs of increasing size. Each time is the best of a few runs.
+//
+// Usage: bench_pipeline [ max_methods ]
+// Output: CSV, one line per front end and corpus size.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "corpus.h"
+#include "hparser.h"
+#include "measure.h"
+
+using namespace std;
+
+static double time_parse(const string& src, bool pipelined) {
+  const int Runs = 3;
+  double best = 0.0;
+  for (int run = 0; run < Runs; ++run) {
+    FILE* file = corpus_file(src);
+    auto start = chrono::steady_clock::now();
+    {
+      HParser parser(file, false, false, pipelined);
+      parser.parse();
+    }
+    double seconds = seconds_since(start);
+    best = (run == 0 ? seconds : min(best, seconds));
+    fclose(file);
+  }
+  return best;
+}
+
+int main(int argc, char* argv[]) {
+  int max_methods = (argc >= 2 ? atoi(argv[1]) : 64000);
+
+  cout << "front_end,methods,lines,seconds,lines_per_second,speedup" << endl;
+  for (int methods = 250; methods <= max_methods; methods *= 4) {
+    string src = generate_corpus(methods);
+    size_t lines = count(src.begin(), src.end(), '\n');
+    double sequential = time_parse(src, false);
+    double pipelined = time_parse(src, true);
+    cout << "sequential," << methods << ',' << lines << ',' << sequential
+         << ',' << static_cast<long>(lines / sequential) << ",1" << endl;
+    cout << "pipelined," << methods << ',' << lines << ',' << pipelined << ','
+         << static_cast<long>(lines / pipelined) << ','
+         << sequential / pipelined << endl;
+  }
+  return 0;
+}
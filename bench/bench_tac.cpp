@@ -0,0 +1,78 @@
+// Compares generating TAC through the AST (BParser or HParser, then icg, or
+// BParser then parallel_icg) with generating it directly while parsing
+// (DParser). Each run is done in a child process so that its peak memory is
+// measured on its own.
+//
+// Usage: bench_tac [ max_methods ]
+// Output: CSV, one line per mode and corpus size.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "bparser.h"
+#include "corpus.h"
+#include "dparser.h"
+#include "hparser.h"
+#include "measure.h"
+
+using namespace std;
+
+static void generate(const string& mode, FILE* file) {
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  if (mode == "direct") {
+    DParser parser(file, data, tac, false, false);
+    parser.parse();
+    return;
+  }
+  Parser* parser;
+  if (mode == "bison" || mode == "parallel") {
+    parser = new BParser(file, false, false);
+  } else {
+    parser = new HParser(file, false, false);
+  }
+  parser->parse();
+  if (mode == "parallel") {
+    parallel_icg(static_cast<ProgramNode*>(parser->get_AST()), data, tac,
+                 thread::hardware_concurrency());
+  } else {
+    parser->get_AST()->icg(data, tac);
+  }
+  delete parser;
+}
+
+int main(int argc, char* argv[]) {
+  int max_methods = (argc >= 2 ? atoi(argv[1]) : 8000);
+
+  cout << "mode,methods,lines,seconds,lines_per_second,peak_rss_kb" << endl;
+  for (int methods = 250; methods <= max_methods; methods *= 2) {
+    string src = generate_corpus(methods);
+    size_t lines = 0;
+    for (char c : src) {
+      lines += (c == '\n');
+    }
+    for (string mode : {"bison", "handmade", "parallel", "direct"}) {
+      double seconds = 0.0;
+      long peak_rss_kb = 0;
+      bool ok = run_isolated(
+          [&](double& elapsed) {
+            FILE* file = corpus_file(src);
+            auto start = chrono::steady_clock::now();
+            generate(mode, file);
+            elapsed = seconds_since(start);
+          },
+          seconds, peak_rss_kb);
+      if (!ok) {
+        cerr << "bench_tac: " << mode << " failed on " << methods
+             << " methods." << endl;
+        return 1;
+      }
+      cout << mode << ',' << methods << ',' << lines << ',' << seconds << ','
+           << static_cast<long>(lines / seconds) << ',' << peak_rss_kb
+           << endl;
+    }
+  }
+  return 0;
+}
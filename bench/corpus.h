@@ -0,0 +1,56 @@
+#ifndef DECAFPARSER_CORPUS_H
+#define DECAFPARSER_CORPUS_H
+
+#include <cstdio>
+#include <string>
+
+// Generates a valid Decaf program of 'methods' methods plus main, each with a
+// mix of declarations, loops, conditionals, calls and nested expressions.
+inline std::string generate_corpus(int methods) {
+  std::string src = "class Bench {\n  int g, h;\n  real r;\n";
+  for (int m = 0; m < methods; ++m) {
+    std::string name = "f" + std::to_string(m);
+    src += "  static int " + name + "(int a, int b) {\n";
+    src += "    int i, s;\n";
+    src += "    real x;\n";
+    src += "    s = 0;\n";
+    src += "    x = 1.5 * 2.0;\n";
+    src += "    for (i = 0; i < a && i < 100; i++) {\n";
+    src += "      if (i % 2 == 0 || !(b > i)) {\n";
+    src += "        s = s + i * b - (a / 2);\n";
+    src += "      }\n";
+    src += "      else {\n";
+    src += "        s = s - 1;\n";
+    src += "        if (s < -1000) { break; }\n";
+    src += "      }\n";
+    src += "    }\n";
+    if (m > 0) {
+      src += "    s = s + f" + std::to_string(m - 1) + "(a - 1, b);\n";
+    }
+    src += "    g = g + s;\n";
+    src += "    return s;\n";
+    src += "  }\n";
+  }
+  src += "  static void main() {\n";
+  src += "    g = 0;\n";
+  if (methods > 0) {
+    src += "    writeln(f" + std::to_string(methods - 1) + "(10, 3));\n";
+  }
+  src += "    writeln(g);\n";
+  src += "  }\n";
+  src += "}\n";
+  return src;
+}
+
+// Write 'src' to an anonymous temporary file and rewind it. The scanner reads
+// through the file descriptor, so an in-memory stream will not do.
+inline FILE* corpus_file(const std::string& src) {
+  FILE* file = tmpfile();
+  if (file != nullptr) {
+    fwrite(src.data(), 1, src.size(), file);
+    rewind(file);
+  }
+  return file;
+}
+
+#endif  // DECAFPARSER_CORPUS_H
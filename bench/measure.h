@@ -0,0 +1,51 @@
+#ifndef DECAFPARSER_MEASURE_H
+#define DECAFPARSER_MEASURE_H
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+
+// Seconds elapsed since 'start'.
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Run 'work' in a child process, so that its peak memory is measured on its
+// own, and pass back the plain-data 'result' it fills in. Standard output is
+// discarded in the child. Returns false if the child failed.
+template <typename Result, typename Work>
+bool run_isolated(Work work, Result& result, long& peak_rss_kb) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    if (freopen("/dev/null", "w", stdout) == nullptr) {
+      _exit(1);
+    }
+    Result child_result = Result();
+    work(child_result);
+    ssize_t written = write(fds[1], &child_result, sizeof(child_result));
+    _exit(written == sizeof(child_result) ? 0 : 1);
+  }
+  close(fds[1]);
+  ssize_t got = (pid < 0 ? 0 : read(fds[0], &result, sizeof(result)));
+  close(fds[0]);
+  int status;
+  struct rusage usage;
+  if (pid < 0 || wait4(pid, &status, 0, &usage) != pid) {
+    return false;
+  }
+  peak_rss_kb = usage.ru_maxrss;
+  return got == sizeof(result) && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+#endif  // DECAFPARSER_MEASURE_H
@@ -9,18 +9,17 @@
 class BParser : public Parser {
  public:
   BParser(FILE* file, bool debug_lexer, bool debug_parser)
-      : Parser(file, debug_lexer, debug_parser) {
-    extern FILE* yyin;
-    yyin = file_;
-  }
+      : Parser(file, debug_lexer, debug_parser) {}
+
+  BParser(const char* bytes, size_t len, int line, int col, bool debug_lexer,
+          bool debug_parser)
+      : Parser(bytes, len, line, col, debug_lexer, debug_parser) {}
 
   virtual int parse() override {
-    extern bool yy_flex_debug;
-    yy::parser_decaf parser(*this);
-    yy_flex_debug = debug_lexer_;
+    yy::parser_decaf parser(*this, scanner_);
     parser.set_debug_level(debug_parser_);
     int res = parser.parse();
-    return res;
+    return (res == 0 && errors_ == 0) ? 0 : 1;
   }
 
   virtual std::string get_name() const override { return "Bison"; }
@@ -0,0 +1,156 @@
+#ifndef DECAFPARSER_CONSTANT_POOL_H
+#define DECAFPARSER_CONSTANT_POOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include "symbol_table.h"
+
+// The value of a number literal: an int, if it is all digits, or else a real.
+// A literal that does not fit in its type is not in range; its value is then
+// the largest int, infinity, or 0 for a real too small to be told from it.
+struct Constant {
+  Constant()
+      : type(ValueType::IntVal),
+        in_range(true),
+        int_value(0),
+        real_value(0.0) {}
+
+  ValueType type;
+  bool in_range;
+  int64_t int_value;  // If an int.
+  double real_value;  // If a real.
+};
+
+// Parse a number literal, digits ["." digits] ["E" ["+" | "-"] digits] as
+// the scanner makes them, into 'constant'. Reals with at most 15 significant
+// digits and a power of ten of at most 22 either way are exact as one
+// multiplication or division of doubles (Clinger's fast path); the others go
+// to strtod. Returns constant.in_range.
+inline bool parse_literal(const std::string& literal, Constant& constant) {
+  constant = Constant();
+  const char* p = literal.c_str();
+  uint64_t mantissa = 0;
+  int digits = 0;    // Significant digits in 'mantissa'.
+  int exponent = 0;  // Of ten, by which 'mantissa' is to be scaled.
+  bool exact = true;
+  for (; *p >= '0' && *p <= '9'; ++p) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits += (mantissa != 0);
+    } else {
+      ++exponent;
+      exact = false;
+    }
+  }
+  if (*p == '\0') {
+    const uint64_t Max = static_cast<uint64_t>(INT64_MAX);
+    constant.in_range = exact && mantissa <= Max;
+    constant.int_value =
+        (constant.in_range ? static_cast<int64_t>(mantissa) : INT64_MAX);
+    return constant.in_range;
+  }
+
+  constant.type = ValueType::RealVal;
+  if (*p == '.') {
+    for (++p; *p >= '0' && *p <= '9'; ++p) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += (mantissa != 0);
+        --exponent;
+      } else {
+        exact = false;
+      }
+    }
+  }
+  if (*p == 'E') {
+    ++p;
+    bool negative = (*p == '-');
+    if (*p == '+' || *p == '-') {
+      ++p;
+    }
+    int e = 0;
+    for (; *p >= '0' && *p <= '9'; ++p) {
+      e = (e < 100000 ? e * 10 + (*p - '0') : e);  // Far out of range anyway.
+    }
+    exponent += (negative ? -e : e);
+  }
+
+  static const double PowersOfTen[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  if (exact && digits <= 15 && exponent >= -22 && exponent <= 22) {
+    double value = static_cast<double>(mantissa);
+    constant.real_value = (exponent < 0 ? value / PowersOfTen[-exponent]
+                                        : value * PowersOfTen[exponent]);
+    return true;
+  }
+  errno = 0;
+  constant.real_value = strtod(literal.c_str(), nullptr);
+  constant.in_range = (errno != ERANGE);
+  return constant.in_range;
+}
+
+// The number literals of a program, each once, with their values. A literal
+// is parsed when it is added for the first time; after that it is found by its
+// spelling, so that the code can refer to it by index.
+class ConstantPool {
+ public:
+  static const uint32_t NoConstant = 0xffffffff;
+
+  // The index of 'literal', added if it is new.
+  uint32_t add(const std::string& literal) {
+    auto inserted = indices_.insert(
+        std::make_pair(literal, static_cast<uint32_t>(literals_.size())));
+    if (inserted.second) {
+      literals_.push_back(literal);
+      constants_.push_back(Constant());
+      parse_literal(literal, constants_.back());
+    }
+    return inserted.first->second;
+  }
+
+  // The same, for a literal parsed already into 'constant'.
+  uint32_t add(const std::string& literal, const Constant& constant) {
+    auto inserted = indices_.insert(
+        std::make_pair(literal, static_cast<uint32_t>(literals_.size())));
+    if (inserted.second) {
+      literals_.push_back(literal);
+      constants_.push_back(constant);
+    }
+    return inserted.first->second;
+  }
+
+  // The index of 'literal', or NoConstant if it has not been added.
+  uint32_t find(const std::string& literal) const {
+    auto found = indices_.find(literal);
+    if (found == indices_.end()) {
+      return NoConstant;
+    }
+    return found->second;
+  }
+
+  const Constant& operator[](uint32_t index) const {
+    return constants_[index];
+  }
+
+  const std::string& literal(uint32_t index) const { return literals_[index]; }
+
+  uint32_t size() const { return static_cast<uint32_t>(constants_.size()); }
+
+  void clear() {
+    indices_.clear();
+    literals_.clear();
+    constants_.clear();
+  }
+
+ private:
+  std::unordered_map<std::string, uint32_t> indices_;
+  std::deque<std::string> literals_;
+  std::deque<Constant> constants_;
+};
+
+#endif  // DECAFPARSER_CONSTANT_POOL_H
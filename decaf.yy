@@ -17,13 +17,26 @@
 #include <string>
 #include "ast.h"
 class Parser;
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
 }
 
-%parse-param { Parser& driver }
+%parse-param { Parser& driver } { yyscan_t scanner }
+%lex-param { yyscan_t scanner }
 %locations
 %code
 {
 #include "parser.h"
+
+// Give a statement, declaration or method the location of its first token.
+template <typename T>
+static T* located( T* node, const yy::location& loc )
+{
+    node->set_location( SourceLocation( loc.begin.line, loc.begin.column ) );
+    return node;
+}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -32,6 +45,7 @@ class Parser;
 
 %token kwClass
 %token kwStatic
+%token kwFinal
 %token kwVoid
 %token kwInt
 %token kwReal
@@ -44,6 +58,8 @@ class Parser;
 
 %token ptLBrace
 %token ptRBrace
+%token ptLBracket
+%token ptRBracket
 %token ptComma
 %token ptSemicolon
 %token ptLParen
@@ -66,6 +82,12 @@ class Parser;
 %token OpLogAnd
 %token OpLogOr
 %token OpLogNot
+%token OpBitAnd
+%token OpBitOr
+%token OpBitXor
+%token OpBitNot
+%token OpShiftLeft
+%token OpShiftRight
 
 %token <std::string> Identifier
 %token <std::string> Number
@@ -73,13 +95,20 @@ class Parser;
 
 %left OpLogOr
 %left OpLogAnd
+%left OpBitOr
+%left OpBitXor
+%left OpBitAnd
 %nonassoc OpRelEQ OpRelNEQ
 %nonassoc OpRelLT OpRelLTE OpRelGT OpRelGTE
+%left OpShiftLeft OpShiftRight
 %left OpArtPlus OpArtMinus
 %left OpArtMult OpArtDiv OpArtModulus
-%left OpLogNot
+%left OpLogNot OpBitNot
 
+%type <std::list<VariableDeclarationNode*>*> field_declarations
 %type <std::list<VariableDeclarationNode*>*> variable_declarations
+%type <VariableDeclarationNode*> variable_declaration
+%type <ExprNode*> array_size
 %type <ValueType> type
 %type <std::list<VariableExprNode*>*> variable_list
 %type <VariableExprNode*> variable
@@ -93,6 +122,7 @@ class Parser;
 %type <ExprNode*> optional_expr
 %type <BlockStmNode*> statement_block
 %type <IncrDecrStmNode*> incr_decr_var
+%type <IndexExprNode*> element
 %type <BlockStmNode*> optional_else
 %type <std::list<ExprNode*>*> expr_list
 %type <std::list<ExprNode*>*> more_expr
@@ -105,15 +135,29 @@ class Parser;
 ////////////////////////////////////////////////////////////////////////////////////
 
 program: kwClass Identifier ptLBrace
-             variable_declarations
+             field_declarations
              method_declarations
          ptRBrace
          { driver.set_AST( new ProgramNode( $2, $4, $5 ) ); }
 
-variable_declarations: variable_declarations type variable_list ptSemicolon
-                      { $$ = $1; $$->push_back( new VariableDeclarationNode($2,$3) ); }
+field_declarations: field_declarations variable_declaration
+                   { $$ = $1; $$->push_back( located( $2, @2 ) ); }
+                 | field_declarations kwStatic kwFinal type variable OpAssign Number ptSemicolon
+                   { $$ = $1; $$->push_back( located( new ConstantDeclarationNode($4,$5,driver.number($7, @7)), @2 ) ); }
+                 | { $$ = new std::list<VariableDeclarationNode*>(); }
+
+variable_declarations: variable_declarations variable_declaration
+                      { $$ = $1; $$->push_back( located( $2, @2 ) ); }
                     | { $$ = new std::list<VariableDeclarationNode*>(); }
 
+variable_declaration: type variable_list ptSemicolon
+                      { $$ = new VariableDeclarationNode($1,$2); }
+                    | type variable ptLBracket array_size ptRBracket ptSemicolon
+                      { $$ = new ArrayDeclarationNode($1,$2,$4); }
+
+array_size: Number    { $$ = driver.number($1, @1); }
+          | variable  { $$ = $1; }
+
 type: kwInt  { $$ = ValueType::IntVal; }
     | kwReal { $$ = ValueType::RealVal; }
 
@@ -134,7 +178,8 @@ method_declaration:
       variable_declarations
       statement_list
     ptRBrace
-    { $$ = new MethodNode( $2, $3, $5, $8, $9 ); }
+    { $$ = located( new MethodNode( $2, $3, $5, $8, $9 ), @1 );
+      driver.end_method(); }
 
 method_return_type: type    { $$ = $1; }
                   | kwVoid  { $$ = ValueType::VoidVal; }
@@ -150,11 +195,13 @@ parameter_list: type variable
                   $$->push_back( new ParameterNode($3, $4) ); }
 
 statement_list: statement_list statement
-                { $$ = $1;  $$->push_back( $2 ); }
+                { $$ = $1;  $$->push_back( located( $2, @2 ) ); }
               | { $$ = new std::list<StmNode*>(); }
 
 statement: variable OpAssign expr ptSemicolon
            { $$ = new AssignStmNode( $1, $3 ); }
+         | element OpAssign expr ptSemicolon
+           { $$ = new IndexAssignStmNode( $1, $3 ); }
          | Identifier ptLParen expr_list ptRParen ptSemicolon
            { $$ = new MethodCallExprStmNode( $1, $3 ); }
          | kwIf ptLParen expr ptRParen statement_block optional_else
@@ -179,6 +226,8 @@ optional_expr:  expr  { $$ = $1; }
 
 statement_block: ptLBrace statement_list ptRBrace { $$ = new BlockStmNode($2); }
 
+element: variable ptLBracket expr ptRBracket { $$ = new IndexExprNode( $1, $3 ); }
+
 incr_decr_var:  variable OpArtInc { $$ = new IncrStmNode( $1 ); }
              |  variable OpArtDec { $$ = new DecrStmNode( $1 ); }
 
@@ -191,26 +240,33 @@ expr_list: expr more_expr          { $$ = $2; $$->push_front( $1 ); }
 more_expr: ptComma expr more_expr  { $$ = $3; $$->push_front( $2 ); }
          |                         { $$ = new std::list<ExprNode*>(); }
 
-expr: Number                  { $$ = new NumberExprNode($1); }
-    | variable                { $$ = $1; }
+expr: Number                  { $$ = driver.intern(driver.number($1, @1)); }
+    | variable                { $$ = driver.intern($1); }
+    | element                 { $$ = $1; }
     | Identifier ptLParen expr_list ptRParen { $$ = new MethodCallExprStmNode($1,$3); }
     | ptLParen expr ptRParen  { $$ = $2; }
-    | expr OpArtPlus    expr  { $$ = new PlusExprNode($1,$3); }
-    | expr OpArtMinus   expr  { $$ = new MinusExprNode($1,$3); }
-    | expr OpArtMult    expr  { $$ = new MultiplyExprNode($1,$3); }
-    | expr OpArtDiv     expr  { $$ = new DivideExprNode($1,$3); }
-    | expr OpArtModulus expr  { $$ = new ModulusExprNode($1,$3); }
-    | expr OpRelEQ      expr  { $$ = new EqExprNode($1,$3); }
-    | expr OpRelNEQ     expr  { $$ = new NeqExprNode($1,$3); }
-    | expr OpRelLT      expr  { $$ = new LtExprNode($1,$3); }
-    | expr OpRelLTE     expr  { $$ = new LteExprNode($1,$3); }
-    | expr OpRelGT      expr  { $$ = new GtExprNode($1,$3); }
-    | expr OpRelGTE     expr  { $$ = new GteExprNode($1,$3); }
-    | expr OpLogAnd     expr  { $$ = new AndExprNode($1,$3); }
-    | expr OpLogOr      expr  { $$ = new OrExprNode($1,$3); }
-    |      OpLogNot     expr  { $$ = new NotExprNode($2); }
-    |      OpArtPlus    expr  %prec OpLogNot { $$ = new PlusExprNode($2); }
-    |      OpArtMinus   expr  %prec OpLogNot { $$ = new MinusExprNode($2); }
+    | expr OpArtPlus    expr  { $$ = driver.intern(new PlusExprNode($1,$3)); }
+    | expr OpArtMinus   expr  { $$ = driver.intern(new MinusExprNode($1,$3)); }
+    | expr OpArtMult    expr  { $$ = driver.intern(new MultiplyExprNode($1,$3)); }
+    | expr OpArtDiv     expr  { $$ = driver.intern(new DivideExprNode($1,$3)); }
+    | expr OpArtModulus expr  { $$ = driver.intern(new ModulusExprNode($1,$3)); }
+    | expr OpRelEQ      expr  { $$ = driver.intern(new EqExprNode($1,$3)); }
+    | expr OpRelNEQ     expr  { $$ = driver.intern(new NeqExprNode($1,$3)); }
+    | expr OpRelLT      expr  { $$ = driver.intern(new LtExprNode($1,$3)); }
+    | expr OpRelLTE     expr  { $$ = driver.intern(new LteExprNode($1,$3)); }
+    | expr OpRelGT      expr  { $$ = driver.intern(new GtExprNode($1,$3)); }
+    | expr OpRelGTE     expr  { $$ = driver.intern(new GteExprNode($1,$3)); }
+    | expr OpLogAnd     expr  { $$ = driver.intern(new AndExprNode($1,$3)); }
+    | expr OpLogOr      expr  { $$ = driver.intern(new OrExprNode($1,$3)); }
+    | expr OpBitAnd     expr  { $$ = driver.intern(new BitAndExprNode($1,$3)); }
+    | expr OpBitOr      expr  { $$ = driver.intern(new BitOrExprNode($1,$3)); }
+    | expr OpBitXor     expr  { $$ = driver.intern(new BitXorExprNode($1,$3)); }
+    | expr OpShiftLeft  expr  { $$ = driver.intern(new ShiftLeftExprNode($1,$3)); }
+    | expr OpShiftRight expr  { $$ = driver.intern(new ShiftRightExprNode($1,$3)); }
+    |      OpLogNot     expr  { $$ = driver.intern(new NotExprNode($2)); }
+    |      OpBitNot     expr  { $$ = driver.intern(new ComplementExprNode($2)); }
+    |      OpArtPlus    expr  %prec OpLogNot { $$ = driver.intern(new PlusExprNode($2)); }
+    |      OpArtMinus   expr  %prec OpLogNot { $$ = driver.intern(new MinusExprNode($2)); }
 
 %%
 
@@ -0,0 +1,203 @@
+#ifndef DECAFPARSER_DIAGNOSTICS_H
+#define DECAFPARSER_DIAGNOSTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+enum class Severity : uint8_t { Warning, Error };
+
+// What a diagnostic is about, one per kind of message.
+enum class DiagId : uint8_t {
+  // Warnings.
+  AssignType,      // Assigning a value of the other type.
+  ConditionType,   // An if or for condition that is not an integer.
+  LogicalType,     // Operands of &&, || or ! that are not integers.
+  CompareType,     // Comparing an int with a real.
+  ArithmeticType,  // Arithmetic on an int and a real.
+  ReturnType,      // Returning a value of another type.
+  ParameterType,   // Arguments that do not match the parameters.
+  WriteArguments,  // write/writeln with other than one argument.
+  IndexType,       // An array index that is not an integer.
+  BitwiseType,     // Operands of & | ^ ~ << or >> that are not integers.
+  // Errors.
+  Redeclared,
+  UndeclaredVariable,
+  UndeclaredMethod,
+  ReturnValue,  // A return with a value from a void method, or without one.
+  BreakOutsideLoop,
+  ContinueOutsideLoop,
+  MissingMain,
+  NumberRange,     // A number too large (or small) for its type.
+  ConstantAssign,  // Assigning to, or incrementing, a constant.
+  ArrayUse,        // An array without an index, or an index into a scalar.
+  ArraySize,       // An array size that is not a positive int constant.
+  IndexRange       // A constant index outside of its array.
+};
+
+inline const char* tostr(DiagId id) {
+  static const char* const Names[] = {
+      "assign-type",
+      "condition-type",
+      "logical-type",
+      "compare-type",
+      "arithmetic-type",
+      "return-type",
+      "parameter-type",
+      "write-arguments",
+      "index-type",
+      "bitwise-type",
+      "redeclared",
+      "undeclared-variable",
+      "undeclared-method",
+      "return-value",
+      "break-outside-loop",
+      "continue-outside-loop",
+      "missing-main",
+      "number-range",
+      "constant-assign",
+      "array-use",
+      "array-size",
+      "index-range"};
+  return Names[static_cast<size_t>(id)];
+}
+
+// A line and column in the source; line 0 if not known.
+struct SourceLocation {
+  SourceLocation() : line(0), col(0) {}
+  SourceLocation(int line, int col) : line(line), col(col) {}
+
+  int line;
+  int col;
+};
+
+// Collects the warnings and errors of a compilation, to be written out
+// together by flush() rather than one by one as they are found. Optionally,
+// repeats of a diagnostic (same severity, id, location and message) are
+// dropped, and only the first so many diagnostics are kept. By default neither
+// is done and the diagnostics are written as "WARNING: message" and
+// "ERROR: message" lines, as they always have been.
+class Diagnostics {
+ public:
+  // Plain: "WARNING: message". Located: "line:col: warning: message [id]".
+  enum class Format { Plain, Located };
+
+  Diagnostics()
+      : format_(Format::Plain),
+        deduplicate_(false),
+        limit_(0),
+        suppressed_(0) {
+    counts_[0] = counts_[1] = 0;
+  }
+
+  Diagnostics(const Diagnostics&) = delete;
+  Diagnostics& operator=(const Diagnostics&) = delete;
+
+  void set_format(Format format) { format_ = format; }
+
+  void set_deduplicate(bool deduplicate) { deduplicate_ = deduplicate; }
+
+  // Keep at most 'limit' diagnostics, counting those after them; 0 keeps all.
+  void set_limit(size_t limit) { limit_ = limit; }
+
+  void report(Severity severity, DiagId id, std::string message,
+              SourceLocation location = SourceLocation()) {
+    ++counts_[static_cast<size_t>(severity)];
+    if (deduplicate_ && !seen_.insert(key(severity, id, location, message))
+                             .second) {
+      return;
+    }
+    if (limit_ != 0 && records_.size() >= limit_) {
+      ++suppressed_;
+      return;
+    }
+    records_.push_back({severity, id, location, std::move(message)});
+  }
+
+  // Report the diagnostics kept by 'other', in order, as if they were
+  // reported here, and forget them there.
+  void merge(Diagnostics& other) {
+    for (Record& record : other.records_) {
+      report(record.severity, record.id, std::move(record.message),
+             record.location);
+    }
+    other.records_.clear();
+  }
+
+  // The number of diagnostics of a severity reported, including repeats and
+  // those over the limit.
+  size_t count(Severity severity) const {
+    return counts_[static_cast<size_t>(severity)];
+  }
+
+  // The number of diagnostics waiting to be written.
+  size_t size() const { return records_.size(); }
+
+  // Write the diagnostics kept since the last flush() in one go, in the order
+  // they were reported, and forget them. Repeats of them are still dropped.
+  void flush(std::ostream& os) {
+    std::string text;
+    for (const Record& record : records_) {
+      render(record, text);
+    }
+    if (suppressed_ != 0) {
+      text += std::to_string(suppressed_) + " more diagnostics not shown.\n";
+    }
+    os << text;
+    os.flush();
+    records_.clear();
+    suppressed_ = 0;
+  }
+
+ private:
+  struct Record {
+    Severity severity;
+    DiagId id;
+    SourceLocation location;
+    std::string message;
+  };
+
+  static std::string key(Severity severity, DiagId id,
+                         const SourceLocation& location,
+                         const std::string& message) {
+    std::string key;
+    key += static_cast<char>(severity);
+    key += static_cast<char>(id);
+    key += std::to_string(location.line) + ':' +
+           std::to_string(location.col) + ':';
+    return key + message;
+  }
+
+  void render(const Record& record, std::string& text) const {
+    bool error = record.severity == Severity::Error;
+    if (format_ == Format::Plain) {
+      text += error ? "ERROR: " : "WARNING: ";
+      text += record.message;
+      text += '\n';
+      return;
+    }
+    if (record.location.line != 0) {
+      text += std::to_string(record.location.line) + ':' +
+              std::to_string(record.location.col) + ": ";
+    }
+    text += error ? "error: " : "warning: ";
+    text += record.message;
+    text += " [";
+    text += tostr(record.id);
+    text += "]\n";
+  }
+
+  Format format_;
+  bool deduplicate_;
+  size_t limit_;
+  size_t suppressed_;  // Dropped over the limit since the last flush().
+  size_t counts_[2];   // By Severity.
+  std::vector<Record> records_;
+  std::unordered_set<std::string> seen_;  // Keys of the reported ones.
+};
+
+#endif  // DECAFPARSER_DIAGNOSTICS_H
@@ -0,0 +1,1216 @@
+#include "dparser.h"
+#include <algorithm>
+#include "hparser.h"
+#include "pparser.h"
+
+using namespace std;
+
+DParser::Token& DParser::Lexer::peek(size_t k) {
+  while (ahead_.size() <= k) {
+    yy::parser_decaf::symbol_type st(yylex(scanner_));
+    Token token;
+    token.type = st.token();
+    if (token.type == yy::parser_decaf::token_type::Identifier ||
+        token.type == yy::parser_decaf::token_type::Number ||
+        token.type == yy::parser_decaf::token_type::ErrUnknown) {
+      token.lexeme = st.value.as<std::string>();
+    }
+    token.line = st.location.begin.line;
+    token.col = st.location.begin.column;
+    token.close = 0;
+    ahead_.push_back(token);
+  }
+  return ahead_[k];
+}
+
+void DParser::Lexer::next() {
+  if (!ahead_.empty()) {
+    ahead_.pop_front();
+    ++position_;
+  }
+}
+
+void DParser::error(decaf::token_type type_expected) {
+  // What was found before the syntax error is reported before it.
+  data_.diagnostics.flush(*out_);
+  *out_ << "Syntax error (line " << token().line << ", col " << token().col
+        << "): expected token " << type_expected << ", but got token "
+        << token().type << " (" << token().lexeme << ")." << std::endl;
+  throw SyntaxError();
+}
+
+void DParser::match(decaf::token_type type) {
+  if (token().type == type) {
+    lexer_->next();
+  } else {
+    error(type);
+  }
+}
+
+int DParser::parse() {
+  source_ = read_source(file_);
+  line_starts_.assign(1, 0);
+  for (size_t i = 0; i < source_.size(); ++i) {
+    if (source_[i] == '\n') {
+      line_starts_.push_back(i + 1);
+    }
+  }
+  int res = 0;
+  try {
+    Lexer lexer(source_.data(), source_.size(), 1, 1, debug_lexer_);
+    lexer_ = &lexer;
+    program();
+  } catch (const SyntaxError&) {
+    res = 1;
+  }
+  lexer_ = nullptr;
+  return res;
+}
+
+void DParser::program() {
+  match(decaf::token_type::kwClass);
+  match(decaf::token_type::Identifier);
+  match(decaf::token_type::ptLBrace);
+  field_declarations();
+  tac_.append(TAC::InstrType::GOTO, "main");
+  method_declaration();
+  while (token().type == decaf::token_type::kwStatic) {
+    method_declaration();
+  }
+  match(decaf::token_type::ptRBrace);
+  match(decaf::token_type::EOI);
+
+  SymbolTable::Entry* entry = data_.sym_table.lookup("", "main");
+  if (entry == nullptr) {
+    error_msg(data_, DiagId::MissingMain, "Main method is missing.",
+              location());
+  }
+}
+
+// The variables and constants of the class. A constant is told from a method,
+// which starts with "static" too, by the "final" after it.
+void DParser::field_declarations() {
+  variable_declarations();
+  while (token().type == decaf::token_type::kwStatic &&
+         token(1).type == decaf::token_type::kwFinal) {
+    constant_declaration();
+    variable_declarations();
+  }
+}
+
+void DParser::constant_declaration() {
+  match(decaf::token_type::kwStatic);
+  match(decaf::token_type::kwFinal);
+  ValueType type = this->type();
+  string id = token().lexeme;
+  match(decaf::token_type::Identifier);
+  match(decaf::token_type::OpAssign);
+  string literal = token().lexeme;
+  Constant constant;
+  parse_literal(literal, constant);
+  if (!constant.in_range) {
+    error_msg(data_, DiagId::NumberRange,
+              "Number '" + literal + "' is out of range.", location());
+  }
+  match(decaf::token_type::Number);
+  declare_constant(data_, id, type, literal, constant, location());
+  match(decaf::token_type::ptSemicolon);
+}
+
+void DParser::variable_declarations() {
+  while (token().type == decaf::token_type::kwInt ||
+         token().type == decaf::token_type::kwReal) {
+    ValueType type = this->type();
+    if (token().type == decaf::token_type::Identifier &&
+        token(1).type == decaf::token_type::ptLBracket) {
+      string id = token().lexeme;
+      match(decaf::token_type::Identifier);
+      match(decaf::token_type::ptLBracket);
+      string size = token().lexeme;
+      if (token().type == decaf::token_type::Number) {
+        match(decaf::token_type::Number);
+      } else {
+        match(decaf::token_type::Identifier);
+      }
+      match(decaf::token_type::ptRBracket);
+      declare_array(data_, tac_, id, type, size, location());
+      match(decaf::token_type::ptSemicolon);
+      continue;
+    }
+    while (true) {
+      string id = token().lexeme;
+      match(decaf::token_type::Identifier);
+      add_to_symbol_table(data_, EntryType::Variable,
+                          data_.method_name, id, type);
+      tac_.append(TAC::InstrType::VAR, id);
+      if (token().type != decaf::token_type::ptComma) {
+        break;
+      }
+      match(decaf::token_type::ptComma);
+    }
+    match(decaf::token_type::ptSemicolon);
+  }
+}
+
+ValueType DParser::type() {
+  ValueType valuetype = ValueType::VoidVal;
+  if (token().type == decaf::token_type::kwInt) {
+    match(decaf::token_type::kwInt);
+    valuetype = ValueType::IntVal;
+  } else if (token().type == decaf::token_type::kwReal) {
+    match(decaf::token_type::kwReal);
+    valuetype = ValueType::RealVal;
+  } else {
+    error(decaf::token_type::kwInt);
+  }
+  return valuetype;
+}
+
+void DParser::method_declaration() {
+  match(decaf::token_type::kwStatic);
+  ValueType return_type = method_return_type();
+  string id = token().lexeme;
+  match(decaf::token_type::Identifier);
+
+  data_.method_name = id;
+  tac_.label_next_instr(data_.method_name);
+  match(decaf::token_type::ptLParen);
+  Signature signature;
+  parameters(signature);
+  match(decaf::token_type::ptRParen);
+  add_to_symbol_table(data_, EntryType::Method, "", id, return_type,
+                      signature);
+  // Prevent someone from using a variable with the same name as the enclosing
+  // method.
+  add_to_symbol_table(data_, EntryType::Method, id, id, return_type,
+                      signature);
+
+  match(decaf::token_type::ptLBrace);
+  variable_declarations();
+  statement_list();
+  match(decaf::token_type::ptRBrace);
+  if (tac_.last_instr_type() != TAC::InstrType::RETURN) {
+    tac_.append(TAC::InstrType::RETURN);
+  }
+  data_.method_name = "";
+}
+
+ValueType DParser::method_return_type() {
+  if (token().type == decaf::token_type::kwVoid) {
+    match(decaf::token_type::kwVoid);
+    return ValueType::VoidVal;
+  }
+  return type();
+}
+
+void DParser::parameters(Signature& signature) {
+  if (token().type != decaf::token_type::kwInt &&
+      token().type != decaf::token_type::kwReal) {
+    return;
+  }
+  while (true) {
+    ValueType type = this->type();
+    string id = token().lexeme;
+    match(decaf::token_type::Identifier);
+    add_to_symbol_table(data_, EntryType::Variable,
+                        data_.method_name, id, type);
+    tac_.append(TAC::InstrType::FPARAM, id);
+    signature.push_back(type);
+    if (token().type != decaf::token_type::ptComma) {
+      break;
+    }
+    match(decaf::token_type::ptComma);
+  }
+}
+
+void DParser::statement_list() {
+  while (token().type == decaf::token_type::kwIf ||
+         token().type == decaf::token_type::kwFor ||
+         token().type == decaf::token_type::kwReturn ||
+         token().type == decaf::token_type::kwBreak ||
+         token().type == decaf::token_type::kwContinue ||
+         token().type == decaf::token_type::ptLBrace ||
+         token().type == decaf::token_type::Identifier) {
+    statement();
+  }
+}
+
+void DParser::statement() {
+  switch (token().type) {
+    case (decaf::token_type::kwIf): {
+      string lab_true_block = tac_.label_name("true_block", data_.label_no);
+      string lab_if_end = tac_.label_name("if_end", data_.label_no);
+      data_.label_no++;
+
+      match(decaf::token_type::kwIf);
+      match(decaf::token_type::ptLParen);
+      expr_or();
+      if (data_.expr_return_type != ValueType::IntVal) {
+        warning_msg(data_, DiagId::ConditionType,
+                    "Type mismatch in if statement (conditional statement is "
+                    "not an integer value).", location());
+      }
+      tac_.append(TAC::InstrType::NE, data_.expr_return_type,
+                  data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                  lab_true_block);
+      match(decaf::token_type::ptRParen);
+
+      // The else block comes first in the code; skip over the if block and
+      // come back to it once the else block is done.
+      if (token().type != decaf::token_type::ptLBrace) {
+        error(decaf::token_type::ptLBrace);
+      }
+      int line = token().line;
+      int col = token().col;
+      size_t begin = offset(line, col);
+      size_t end = begin;
+      int depth = 0;
+      do {
+        if (token().type == decaf::token_type::ptLBrace) {
+          ++depth;
+        } else if (token().type == decaf::token_type::ptRBrace) {
+          --depth;
+        } else if (token().type == decaf::token_type::EOI) {
+          error(decaf::token_type::ptRBrace);
+        }
+        end = offset(token().line, token().col) + 1;
+        lexer_->next();
+      } while (depth > 0);
+
+      if (token().type == decaf::token_type::kwElse) {
+        match(decaf::token_type::kwElse);
+        statement_block();
+      }
+      tac_.append(TAC::InstrType::GOTO, lab_if_end);
+
+      tac_.label_next_instr(lab_true_block);
+      skipped_block(begin, end, line, col);
+
+      tac_.label_next_instr(lab_if_end);
+      break;
+    }
+    case (decaf::token_type::kwFor): {
+      string lab_for_expr = tac_.label_name("for_expr", data_.label_no);
+      string lab_for_incr = tac_.label_name("for_incr", data_.label_no);
+      string lab_for_end = tac_.label_name("for_end", data_.label_no);
+      data_.for_label_no.push(data_.label_no);
+      data_.label_no++;
+
+      match(decaf::token_type::kwFor);
+      match(decaf::token_type::ptLParen);
+      string id = token().lexeme;
+      string init;  // Of a loop whose range may be known, as in the tree.
+      size_t k = 2;
+      if (!simple_operand(k, init) ||
+          token(k).type != decaf::token_type::ptSemicolon) {
+        init.clear();
+      }
+      match(decaf::token_type::Identifier);
+      check_assignable(data_, variable(id), location());
+      string var = data_.expr_return_var;
+      ValueType var_type = data_.expr_return_type;
+      match(decaf::token_type::OpAssign);
+      expr_or();
+      tac_.append(TAC::InstrType::ASSIGN,
+                  convert(data_, tac_, data_.expr_return_var,
+                          data_.expr_return_type, var_type),
+                  var);
+      if ((var_type == ValueType::IntVal &&
+           data_.expr_return_type == ValueType::RealVal) ||
+          (var_type == ValueType::RealVal &&
+           data_.expr_return_type == ValueType::IntVal)) {
+        warning_msg(data_, DiagId::AssignType,
+                    "Type mismatch in assigning to variable '" + var + "'.",
+                    location());
+      }
+      match(decaf::token_type::ptSemicolon);
+
+      string cond_var, bound;
+      TAC::InstrType op = TAC::InstrType::LT;
+      k = 0;
+      if (!loop_condition(k, cond_var, op, bound) ||
+          token(k).type != decaf::token_type::ptSemicolon) {
+        cond_var.clear();
+      }
+
+      tac_.label_next_instr(lab_for_expr);
+      expr_or();
+      if (data_.expr_return_type != ValueType::IntVal) {
+        warning_msg(data_, DiagId::ConditionType,
+                    "Type mismatch in for statement (conditional statement is "
+                    "not an integer value).", location());
+      }
+      tac_.append(TAC::InstrType::EQ, data_.expr_return_type,
+                  data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                  lab_for_end);
+      match(decaf::token_type::ptSemicolon);
+
+      // The increment is generated after the block.
+      string incr_id = token().lexeme;
+      match(decaf::token_type::Identifier);
+      bool incr = (token().type == decaf::token_type::OpArtInc);
+      if (incr) {
+        match(decaf::token_type::OpArtInc);
+      } else if (token().type == decaf::token_type::OpArtDec) {
+        match(decaf::token_type::OpArtDec);
+      } else {
+        error(decaf::token_type::OpArtInc);
+      }
+      match(decaf::token_type::ptRParen);
+      LoopRange range;
+      bool ranged = !init.empty() && cond_var == id && incr_id == id &&
+                    loop_range(data_, id, init, op, bound, incr, range) &&
+                    !assigned_in_block(id);
+      if (ranged) {
+        data_.loop_ranges.push_back(range);
+      }
+      statement_block();
+      if (ranged) {
+        data_.loop_ranges.pop_back();
+      }
+
+      tac_.label_next_instr(lab_for_incr);
+      incr_decr(incr_id, incr);
+      tac_.append(TAC::InstrType::GOTO, lab_for_expr);
+
+      tac_.label_next_instr(lab_for_end);
+      data_.for_label_no.pop();
+      break;
+    }
+    case (decaf::token_type::kwReturn): {
+      match(decaf::token_type::kwReturn);
+      bool has_expr = (token().type != decaf::token_type::ptSemicolon);
+      SymbolTable::Entry* entry = data_.sym_table.lookup("", data_.method_name);
+      if (has_expr) {
+        expr_or();
+        tac_.append(TAC::InstrType::ASSIGN,
+                    convert(data_, tac_, data_.expr_return_var,
+                            data_.expr_return_type,
+                            entry != nullptr ? entry->value_type
+                                             : ValueType::VoidVal),
+                    data_.method_name);
+      }
+      match(decaf::token_type::ptSemicolon);
+      tac_.append(TAC::InstrType::RETURN);
+
+      if (entry != nullptr) {
+        if ((has_expr && entry->value_type == ValueType::VoidVal) ||
+            (!has_expr && entry->value_type != ValueType::VoidVal)) {
+          error_msg(data_, DiagId::ReturnValue,
+                    "Return statement in '" + data_.method_name +
+                    "' does not match return value.", location());
+        }
+        if (has_expr && data_.expr_return_type != entry->value_type) {
+          warning_msg(data_, DiagId::ReturnType,
+                      "Returned value in '" + data_.method_name +
+                      "' does not match return type.", location());
+        }
+      }
+      break;
+    }
+    case (decaf::token_type::kwBreak): {
+      match(decaf::token_type::kwBreak);
+      match(decaf::token_type::ptSemicolon);
+      if (!data_.for_label_no.empty()) {
+        tac_.append(TAC::InstrType::GOTO,
+                    tac_.label_name("for_end", data_.for_label_no.top()));
+      } else {
+        error_msg(data_, DiagId::BreakOutsideLoop,
+                  "Break statement used outside a loop.", location());
+      }
+      break;
+    }
+    case (decaf::token_type::kwContinue): {
+      match(decaf::token_type::kwContinue);
+      match(decaf::token_type::ptSemicolon);
+      if (!data_.for_label_no.empty()) {
+        tac_.append(TAC::InstrType::GOTO,
+                    tac_.label_name("for_incr", data_.for_label_no.top()));
+      } else {
+        error_msg(data_, DiagId::ContinueOutsideLoop,
+                  "Continue statement used outside a loop.", location());
+      }
+      break;
+    }
+    case (decaf::token_type::ptLBrace): {
+      statement_block();
+      break;
+    }
+    case (decaf::token_type::Identifier): {
+      id_start_stm();
+      break;
+    }
+    default:
+      error(decaf::token_type::Identifier);
+  }
+}
+
+void DParser::id_start_stm() {
+  string id = token().lexeme;
+  match(decaf::token_type::Identifier);
+  switch (token().type) {
+    case decaf::token_type::ptLParen: {
+      method_call(id);
+      match(decaf::token_type::ptSemicolon);
+      break;
+    }
+    case decaf::token_type::OpAssign: {
+      check_assignable(data_, variable(id), location());
+      string var = data_.expr_return_var;
+      ValueType var_type = data_.expr_return_type;
+      match(decaf::token_type::OpAssign);
+      expr_or();
+      match(decaf::token_type::ptSemicolon);
+      tac_.append(TAC::InstrType::ASSIGN,
+                  convert(data_, tac_, data_.expr_return_var,
+                          data_.expr_return_type, var_type),
+                  var);
+      if ((var_type == ValueType::IntVal &&
+           data_.expr_return_type == ValueType::RealVal) ||
+          (var_type == ValueType::RealVal &&
+           data_.expr_return_type == ValueType::IntVal)) {
+        warning_msg(data_, DiagId::AssignType,
+                    "Type mismatch in assigning to variable '" + var + "'.",
+                    location());
+      }
+      break;
+    }
+    case decaf::token_type::ptLBracket: {
+      match(decaf::token_type::ptLBracket);
+      expr_or();
+      string index = data_.expr_return_var;
+      ValueType index_type = data_.expr_return_type;
+      match(decaf::token_type::ptRBracket);
+      match(decaf::token_type::OpAssign);
+      expr_or();
+      match(decaf::token_type::ptSemicolon);
+      store_element(data_, tac_, data_.sym_table.resolve(data_.method_name, id),
+                    id, index, index_type, data_.expr_return_var,
+                    data_.expr_return_type, location());
+      break;
+    }
+    case decaf::token_type::OpArtInc: {
+      match(decaf::token_type::OpArtInc);
+      match(decaf::token_type::ptSemicolon);
+      incr_decr(id, true);
+      break;
+    }
+    case decaf::token_type::OpArtDec: {
+      match(decaf::token_type::OpArtDec);
+      match(decaf::token_type::ptSemicolon);
+      incr_decr(id, false);
+      break;
+    }
+    default:
+      error(decaf::token_type::ptLParen);
+  }
+}
+
+void DParser::statement_block() {
+  match(decaf::token_type::ptLBrace);
+  ensure_stack([this]() { statement_list(); });
+  match(decaf::token_type::ptRBrace);
+}
+
+void DParser::skipped_block(size_t begin, size_t end, int line, int col) {
+  Lexer block(source_.data() + begin, end - begin, line, col, debug_lexer_);
+  Lexer* outer = lexer_;
+  lexer_ = &block;
+  statement_block();
+  match(decaf::token_type::EOI);
+  lexer_ = outer;
+}
+
+void DParser::method_call(const string& id) {
+  match(decaf::token_type::ptLParen);
+  SymbolTable::Entry* entry = data_.sym_table.lookup("", id);
+
+  if (entry == nullptr) {
+    if (id != "writeln" && id != "write") {
+      error_msg(data_, DiagId::UndeclaredMethod,
+                "Method '" + id + "' undeclared.", location());
+      skip_to_rparen();
+      return;
+    }
+    // write / writeln: only the first argument is evaluated, the others are
+    // skipped over.
+    size_t args = count_args();
+    if (args != 1) {
+      warning_msg(data_, DiagId::WriteArguments,
+                  "Method '" + id + "' accepts 1 argument but " +
+                  std::to_string(args) + " given.", location());
+    }
+    if (args > 0) {
+      expr_or();
+      tac_.append(TAC::InstrType::APARAM, data_.expr_return_var);
+    }
+    skip_to_rparen();
+    tac_.append(TAC::InstrType::CALL, id);
+    data_.expr_return_var = id;
+    return;
+  }
+
+  // The types of the formal parameters.
+  const Signature& formal_parameters = entry->signature;
+
+  bool wrongParameters = false;
+  auto iterFormal = formal_parameters.begin();
+  vector<string> expr_var_names;
+  string givenParams = "";
+
+  if (token().type != decaf::token_type::ptRParen) {
+    while (true) {
+      expr_or();
+      string arg_var = data_.expr_return_var;
+      if (iterFormal != formal_parameters.end()) {
+        arg_var = convert(data_, tac_, arg_var, data_.expr_return_type,
+                          *iterFormal);
+      }
+      string param_var = tac_.tmp_variable_name(data_.variable_no++);
+      tac_.append(TAC::InstrType::VAR, param_var);
+      tac_.append(TAC::InstrType::ASSIGN, arg_var, param_var);
+      expr_var_names.push_back(param_var);
+
+      if (!givenParams.empty()) {
+        givenParams += ", ";
+      }
+      givenParams += tostr(data_.expr_return_type);
+
+      if (iterFormal == formal_parameters.end() ||
+          data_.expr_return_type != *iterFormal) {
+        wrongParameters = true;
+      }
+      if (iterFormal != formal_parameters.end()) {
+        ++iterFormal;
+      }
+      if (token().type != decaf::token_type::ptComma) {
+        break;
+      }
+      match(decaf::token_type::ptComma);
+    }
+  }
+  match(decaf::token_type::ptRParen);
+  if (formal_parameters.size() != expr_var_names.size()) {
+    wrongParameters = true;
+  }
+
+  for (auto expr_var : expr_var_names) {
+    tac_.append(TAC::InstrType::APARAM, expr_var);
+  }
+
+  if (wrongParameters) {
+    warning_msg(data_, DiagId::ParameterType,
+                "Parameters mismatch for method call '" + id + "': expected " +
+                tostr(formal_parameters, ", ") + "; given " + givenParams,
+                location());
+  }
+
+  tac_.append(TAC::InstrType::CALL, id);
+  data_.expr_return_var = id;
+  if (tac_.typed()) {
+    data_.expr_return_type = entry->value_type;
+  }
+}
+
+const SymbolTable::Entry* DParser::variable(const string& id) {
+  data_.expr_return_var = id;
+  data_.expr_return_type = ValueType::VoidVal;
+
+  // The method's own variable, or else the global one.
+  SymbolTable::Entry* entry = data_.sym_table.resolve(data_.method_name, id);
+  if (entry == nullptr) {
+    error_msg(data_, DiagId::UndeclaredVariable,
+              "Undeclared identifier '" + id + "'.", location());
+  } else {
+    data_.expr_return_type = entry->value_type;
+    if (entry->entry_type == EntryType::Constant) {
+      tac_.constants().add(entry->value);
+      data_.expr_return_var = entry->value;
+    } else if (entry->array_size != 0) {
+      error_msg(data_, DiagId::ArrayUse,
+                "Array '" + id + "' is used without an index.", location());
+    }
+  }
+  return entry;
+}
+
+void DParser::incr_decr(const string& id, bool incr) {
+  check_assignable(data_, variable(id), location());
+  tac_.append(incr ? TAC::InstrType::ADD : TAC::InstrType::SUB,
+              data_.expr_return_type, data_.expr_return_var,
+              data_.expr_return_type == ValueType::RealVal ? "1.0" : "1",
+              data_.expr_return_var);
+}
+
+// The spelling of the number or variable, in parentheses or not, that starts k
+// tokens ahead, which is left after it. Returns false if there is none there.
+bool DParser::simple_operand(size_t& k, string& spelling) {
+  if (token(k).type == decaf::token_type::ptLParen) {
+    ++k;
+    if (!simple_operand(k, spelling) ||
+        token(k).type != decaf::token_type::ptRParen) {
+      return false;
+    }
+    ++k;
+    return true;
+  }
+  if (token(k).type != decaf::token_type::Number &&
+      (token(k).type != decaf::token_type::Identifier ||
+       token(k + 1).type == decaf::token_type::ptLParen ||
+       token(k + 1).type == decaf::token_type::ptLBracket)) {
+    return false;
+  }
+  spelling = token(k++).lexeme;
+  return true;
+}
+
+// The condition of a for loop k tokens ahead, if it is "var op bound" with
+// op one of < <= > >=, in parentheses or not; k is left after it.
+bool DParser::loop_condition(size_t& k, string& var, TAC::InstrType& op,
+                             string& bound) {
+  size_t start = k;
+  if (simple_operand(k, var)) {
+    switch (token(k).type) {
+      case decaf::token_type::OpRelLT:
+        op = TAC::InstrType::LT;
+        break;
+      case decaf::token_type::OpRelLTE:
+        op = TAC::InstrType::LE;
+        break;
+      case decaf::token_type::OpRelGT:
+        op = TAC::InstrType::GT;
+        break;
+      case decaf::token_type::OpRelGTE:
+        op = TAC::InstrType::GE;
+        break;
+      default:
+        return false;
+    }
+    ++k;
+    return simple_operand(k, bound);
+  }
+  k = start;
+  if (token(k).type != decaf::token_type::ptLParen) {
+    return false;
+  }
+  ++k;
+  if (!loop_condition(k, var, op, bound) ||
+      token(k).type != decaf::token_type::ptRParen) {
+    return false;
+  }
+  ++k;
+  return true;
+}
+
+// Whether the block ahead assigns to, increments or decrements 'var'. A
+// block is scanned once, with the blocks nested in it: the extent of each is
+// noted in its '{', and the assignments in the lexer, so that the loops
+// nested in it are answered from there without scanning their blocks again.
+bool DParser::assigned_in_block(const string& var) {
+  if (token().type != decaf::token_type::ptLBrace) {
+    return false;
+  }
+  size_t begin = lexer_->position();
+  if (token().close == 0) {
+    // Not inside a block scanned before, so neither is anything after it.
+    lexer_->assignments.clear();
+    vector<size_t> open;
+    for (size_t k = 0; !open.empty() || k == 0; ++k) {
+      Token& token = lexer_->peek(k);
+      if (token.type == decaf::token_type::ptLBrace) {
+        open.push_back(k);
+      } else if (token.type == decaf::token_type::ptRBrace) {
+        lexer_->peek(open.back()).close = k - open.back();
+        open.pop_back();
+      } else if (token.type == decaf::token_type::EOI) {
+        for (size_t o : open) {
+          lexer_->peek(o).close = k - o;
+        }
+        break;
+      } else if (token.type == decaf::token_type::Identifier &&
+                 (lexer_->peek(k + 1).type == decaf::token_type::OpAssign ||
+                  lexer_->peek(k + 1).type == decaf::token_type::OpArtInc ||
+                  lexer_->peek(k + 1).type == decaf::token_type::OpArtDec)) {
+        lexer_->assignments[token.lexeme].push_back(begin + k);
+      }
+    }
+  }
+  auto assigned = lexer_->assignments.find(var);
+  if (assigned == lexer_->assignments.end()) {
+    return false;
+  }
+  auto next = upper_bound(assigned->second.begin(), assigned->second.end(),
+                          begin);
+  return next != assigned->second.end() && *next < begin + token().close;
+}
+
+// Return how many tokens ahead the ')' (or ']') is that closes the group begun
+// by the '(' (or '[') k tokens ahead, or where the group is cut short. The
+// extent of every group passed over is noted in its '(', so that scanning
+// nested groups again from the inside, as the counts below do, takes linear
+// time overall.
+size_t DParser::group_end(size_t k) {
+  if (token(k).close != 0) {
+    return k + token(k).close;
+  }
+  vector<size_t> open(1, k);
+  for (++k;; ++k) {
+    Token& token = lexer_->peek(k);
+    if (token.type == decaf::token_type::ptLParen ||
+        token.type == decaf::token_type::ptLBracket) {
+      if (token.close != 0) {
+        k += token.close;
+      } else {
+        open.push_back(k);
+      }
+    } else if (token.type == decaf::token_type::ptRParen ||
+               token.type == decaf::token_type::ptRBracket) {
+      lexer_->peek(open.back()).close = k - open.back();
+      open.pop_back();
+      if (open.empty()) {
+        return k;
+      }
+    } else if (token.type == decaf::token_type::ptSemicolon ||
+               token.type == decaf::token_type::ptLBrace ||
+               token.type == decaf::token_type::ptRBrace ||
+               token.type == decaf::token_type::EOI) {
+      return k;
+    }
+  }
+}
+
+// Count the operators 'op' ahead at the current level of parentheses, up to
+// the end of the expression (or, for &&, up to the next ||).
+size_t DParser::count_top_level(decaf::token_type op) {
+  size_t count = 0;
+  for (size_t k = 0;; ++k) {
+    decaf::token_type type = token(k).type;
+    if (type == decaf::token_type::ptLParen ||
+        type == decaf::token_type::ptLBracket) {
+      k = group_end(k);
+      if (token(k).type != decaf::token_type::ptRParen &&
+          token(k).type != decaf::token_type::ptRBracket) {
+        break;
+      }
+    } else if (type == decaf::token_type::ptRParen ||
+               type == decaf::token_type::ptRBracket ||
+               type == decaf::token_type::ptSemicolon ||
+               type == decaf::token_type::ptLBrace ||
+               type == decaf::token_type::ptRBrace ||
+               type == decaf::token_type::EOI) {
+      break;
+    } else if (type == op) {
+      ++count;
+    } else if (type == decaf::token_type::ptComma ||
+               type == decaf::token_type::OpLogOr) {
+      break;
+    }
+  }
+  return count;
+}
+
+// Count the arguments ahead, up to the closing parenthesis.
+size_t DParser::count_args() {
+  if (token().type == decaf::token_type::ptRParen) {
+    return 0;
+  }
+  size_t count = 1;
+  for (size_t k = 0;; ++k) {
+    decaf::token_type type = token(k).type;
+    if (type == decaf::token_type::ptLParen ||
+        type == decaf::token_type::ptLBracket) {
+      k = group_end(k);
+      if (token(k).type != decaf::token_type::ptRParen &&
+          token(k).type != decaf::token_type::ptRBracket) {
+        break;
+      }
+    } else if (type == decaf::token_type::ptComma) {
+      ++count;
+    } else if (type == decaf::token_type::ptRParen ||
+               type == decaf::token_type::ptSemicolon ||
+               type == decaf::token_type::EOI) {
+      break;
+    }
+  }
+  return count;
+}
+
+// Skip over the tokens up to and including the closing parenthesis.
+void DParser::skip_to_rparen() {
+  int depth = 0;
+  while (depth > 0 || token().type != decaf::token_type::ptRParen) {
+    if (token().type == decaf::token_type::ptLParen) {
+      ++depth;
+    } else if (token().type == decaf::token_type::ptRParen) {
+      --depth;
+    } else if (token().type == decaf::token_type::ptSemicolon ||
+               token().type == decaf::token_type::EOI) {
+      break;
+    }
+    lexer_->next();
+  }
+  match(decaf::token_type::ptRParen);
+}
+
+void DParser::expr_or() {
+  // The code of each || in a chain starts before the code of its left
+  // operand, outermost first.
+  size_t n = count_top_level(decaf::token_type::OpLogOr);
+  vector<pair<string, int>> ors;  // Result variable and label number.
+  for (size_t i = 0; i < n; ++i) {
+    string result_var = tac_.tmp_variable_name(data_.variable_no++);
+    ors.push_back(make_pair(result_var, data_.label_no++));
+    tac_.append(TAC::InstrType::VAR, result_var);
+  }
+  expr_and();
+  while (n-- > 0) {
+    string result_var = ors[n].first;
+    string lab_or_true = tac_.label_name("or_true", ors[n].second);
+    string lab_or_end = tac_.label_name("or_end", ors[n].second);
+
+    tac_.append(TAC::InstrType::NE, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_or_true);
+    auto lhs_type = data_.expr_return_type;
+
+    match(decaf::token_type::OpLogOr);
+    expr_and();
+    tac_.append(TAC::InstrType::NE, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_or_true);
+
+    if (lhs_type != ValueType::IntVal ||
+        data_.expr_return_type != ValueType::IntVal) {
+      warning_msg(data_, DiagId::LogicalType,
+                  "Type mismatch in logical || (operands are not integer "
+                  "values).", location());
+    }
+
+    tac_.append(TAC::InstrType::ASSIGN, "0", result_var);
+    tac_.append(TAC::InstrType::GOTO, lab_or_end);
+
+    tac_.label_next_instr(lab_or_true);
+    tac_.append(TAC::InstrType::ASSIGN, "1", result_var);
+
+    tac_.label_next_instr(lab_or_end);
+
+    data_.expr_return_var = result_var;
+    data_.expr_return_type = ValueType::IntVal;
+  }
+}
+
+void DParser::expr_and() {
+  // As for ||, the code of each && starts before that of its left operand.
+  size_t n = count_top_level(decaf::token_type::OpLogAnd);
+  vector<pair<string, int>> ands;  // Result variable and label number.
+  for (size_t i = 0; i < n; ++i) {
+    string result_var = tac_.tmp_variable_name(data_.variable_no++);
+    ands.push_back(make_pair(result_var, data_.label_no++));
+    tac_.append(TAC::InstrType::VAR, result_var);
+  }
+  expr_bit_or();
+  while (n-- > 0) {
+    string result_var = ands[n].first;
+    string lab_and_false = tac_.label_name("and_false", ands[n].second);
+    string lab_and_end = tac_.label_name("and_end", ands[n].second);
+
+    auto lhs_type = data_.expr_return_type;
+    tac_.append(TAC::InstrType::EQ, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_and_false);
+
+    match(decaf::token_type::OpLogAnd);
+    expr_bit_or();
+    tac_.append(TAC::InstrType::EQ, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_and_false);
+
+    if (lhs_type != ValueType::IntVal ||
+        data_.expr_return_type != ValueType::IntVal) {
+      warning_msg(data_, DiagId::LogicalType,
+                  "Type mismatch in logical && (operands are not integer "
+                  "values).", location());
+    }
+
+    tac_.append(TAC::InstrType::ASSIGN, "1", result_var);
+    tac_.append(TAC::InstrType::GOTO, lab_and_end);
+
+    tac_.label_next_instr(lab_and_false);
+    tac_.append(TAC::InstrType::ASSIGN, "0", result_var);
+
+    tac_.label_next_instr(lab_and_end);
+
+    data_.expr_return_var = result_var;
+    data_.expr_return_type = ValueType::IntVal;
+  }
+}
+
+void DParser::expr_bit_or() {
+  expr_bit_xor();
+  while (token().type == decaf::token_type::OpBitOr) {
+    match(decaf::token_type::OpBitOr);
+    bitwise_operation(TAC::InstrType::BITOR, &DParser::expr_bit_xor);
+  }
+}
+
+void DParser::expr_bit_xor() {
+  expr_bit_and();
+  while (token().type == decaf::token_type::OpBitXor) {
+    match(decaf::token_type::OpBitXor);
+    bitwise_operation(TAC::InstrType::BITXOR, &DParser::expr_bit_and);
+  }
+}
+
+void DParser::expr_bit_and() {
+  expr_eq();
+  while (token().type == decaf::token_type::OpBitAnd) {
+    match(decaf::token_type::OpBitAnd);
+    bitwise_operation(TAC::InstrType::BITAND, &DParser::expr_eq);
+  }
+}
+
+void DParser::expr_eq() {
+  expr_rel();
+  while (true) {
+    if (token().type == decaf::token_type::OpRelEQ) {
+      match(decaf::token_type::OpRelEQ);
+      relational(TAC::InstrType::EQ, &DParser::expr_rel);
+    } else if (token().type == decaf::token_type::OpRelNEQ) {
+      match(decaf::token_type::OpRelNEQ);
+      relational(TAC::InstrType::NE, &DParser::expr_rel);
+    } else {
+      break;
+    }
+  }
+}
+
+void DParser::expr_rel() {
+  expr_shift();
+  while (true) {
+    if (token().type == decaf::token_type::OpRelLT) {
+      match(decaf::token_type::OpRelLT);
+      relational(TAC::InstrType::LT, &DParser::expr_shift);
+    } else if (token().type == decaf::token_type::OpRelLTE) {
+      match(decaf::token_type::OpRelLTE);
+      relational(TAC::InstrType::LE, &DParser::expr_shift);
+    } else if (token().type == decaf::token_type::OpRelGT) {
+      match(decaf::token_type::OpRelGT);
+      relational(TAC::InstrType::GT, &DParser::expr_shift);
+    } else if (token().type == decaf::token_type::OpRelGTE) {
+      match(decaf::token_type::OpRelGTE);
+      relational(TAC::InstrType::GE, &DParser::expr_shift);
+    } else {
+      break;
+    }
+  }
+}
+
+void DParser::expr_shift() {
+  expr_add();
+  while (true) {
+    if (token().type == decaf::token_type::OpShiftLeft) {
+      match(decaf::token_type::OpShiftLeft);
+      bitwise_operation(TAC::InstrType::SHL, &DParser::expr_add);
+    } else if (token().type == decaf::token_type::OpShiftRight) {
+      match(decaf::token_type::OpShiftRight);
+      bitwise_operation(TAC::InstrType::SHR, &DParser::expr_add);
+    } else {
+      break;
+    }
+  }
+}
+
+void DParser::expr_add() {
+  expr_mult();
+  while (true) {
+    if (token().type == decaf::token_type::OpArtPlus) {
+      match(decaf::token_type::OpArtPlus);
+      arithmetic(TAC::InstrType::ADD, &DParser::expr_mult);
+    } else if (token().type == decaf::token_type::OpArtMinus) {
+      match(decaf::token_type::OpArtMinus);
+      arithmetic(TAC::InstrType::SUB, &DParser::expr_mult);
+    } else {
+      break;
+    }
+  }
+}
+
+void DParser::expr_mult() {
+  expr_unary();
+  while (true) {
+    if (token().type == decaf::token_type::OpArtMult) {
+      match(decaf::token_type::OpArtMult);
+      arithmetic(TAC::InstrType::MULT, &DParser::expr_unary);
+    } else if (token().type == decaf::token_type::OpArtDiv) {
+      match(decaf::token_type::OpArtDiv);
+      arithmetic(TAC::InstrType::DIVIDE, &DParser::expr_unary);
+    } else if (token().type == decaf::token_type::OpArtModulus) {
+      match(decaf::token_type::OpArtModulus);
+      arithmetic(TAC::InstrType::MOD, &DParser::expr_unary);
+    } else {
+      break;
+    }
+  }
+}
+
+// Generate a relational operation whose left operand has just been generated.
+void DParser::relational(TAC::InstrType instr_type,
+                         void (DParser::*operand)()) {
+  string var_lhs = data_.expr_return_var;
+  ValueType type_lhs = data_.expr_return_type;
+
+  (this->*operand)();
+  string var_rhs = data_.expr_return_var;
+  ValueType type_rhs = data_.expr_return_type;
+
+  // Mixed operands are compared as reals.
+  ValueType type = (type_lhs == ValueType::RealVal ? type_lhs : type_rhs);
+  var_lhs = convert(data_, tac_, var_lhs, type_lhs, type);
+  var_rhs = convert(data_, tac_, var_rhs, type_rhs, type);
+
+  string lab_rel_true = tac_.label_name("rel_true", data_.label_no);
+  string lab_rel_end = tac_.label_name("rel_end", data_.label_no);
+  data_.label_no++;
+  string var = tac_.tmp_variable_name(data_.variable_no++);
+
+  tac_.append(TAC::InstrType::VAR, var);
+  tac_.append(instr_type, type, var_lhs, var_rhs, lab_rel_true);
+  tac_.append(TAC::InstrType::ASSIGN, "0", var);
+  tac_.append(TAC::InstrType::GOTO, lab_rel_end);
+  tac_.label_next_instr(lab_rel_true);
+  tac_.append(TAC::InstrType::ASSIGN, "1", var);
+  tac_.label_next_instr(lab_rel_end);
+
+  data_.expr_return_var = var;
+  data_.expr_return_type = ValueType::IntVal;
+
+  if ((type_lhs == ValueType::IntVal && type_rhs == ValueType::RealVal) ||
+      (type_lhs == ValueType::RealVal && type_rhs == ValueType::IntVal)) {
+    warning_msg(data_, DiagId::CompareType,
+                "Type mismatch in operation " + tac_.IName[instr_type] + ".",
+                location());
+  }
+}
+
+// Generate an arithmetic operation whose left operand has just been generated.
+void DParser::arithmetic(TAC::InstrType instr_type,
+                         void (DParser::*operand)()) {
+  string lhs_var = data_.expr_return_var;
+  auto lhs_type = data_.expr_return_type;
+  (this->*operand)();
+  string rhs_var = data_.expr_return_var;
+
+  if (lhs_type != data_.expr_return_type) {
+    warning_msg(data_, DiagId::ArithmeticType,
+                "Mixing int and real types in operation " +
+                tac_.IName[instr_type] + ".", location());
+  }
+  // The operation is of the type of its left operand.
+  rhs_var = convert(data_, tac_, rhs_var, data_.expr_return_type, lhs_type);
+
+  string result_var = tac_.tmp_variable_name(data_.variable_no++);
+  tac_.append(TAC::InstrType::VAR, result_var);
+
+  tac_.append(instr_type, lhs_type, lhs_var, rhs_var, result_var);
+  data_.expr_return_var = result_var;
+  data_.expr_return_type = lhs_type;
+}
+
+// Generate a bitwise operation whose left operand has just been generated.
+void DParser::bitwise_operation(TAC::InstrType instr_type,
+                                void (DParser::*operand)()) {
+  string lhs_var = data_.expr_return_var;
+  auto lhs_type = data_.expr_return_type;
+  (this->*operand)();
+  bitwise(data_, tac_, instr_type, lhs_var, lhs_type, data_.expr_return_var,
+          data_.expr_return_type, location());
+}
+
+void DParser::expr_unary() {
+  if (token().type == decaf::token_type::OpArtPlus) {
+    match(decaf::token_type::OpArtPlus);
+    ensure_stack([this]() { expr_unary(); });
+    return;
+  }
+  if (token().type == decaf::token_type::OpArtMinus) {
+    match(decaf::token_type::OpArtMinus);
+    ensure_stack([this]() { expr_unary(); });
+    string var = tac_.tmp_variable_name(data_.variable_no++);
+    tac_.append(TAC::InstrType::VAR, var);
+    tac_.append(TAC::InstrType::UMINUS, data_.expr_return_type,
+                data_.expr_return_var, var);
+    data_.expr_return_var = var;
+    return;
+  }
+  if (token().type == decaf::token_type::OpLogNot) {
+    match(decaf::token_type::OpLogNot);
+    string var = tac_.tmp_variable_name(data_.variable_no++);
+    string lab_not_true = tac_.label_name("not_true", data_.label_no);
+    string lab_not_end = tac_.label_name("not_end", data_.label_no);
+    data_.label_no++;
+
+    tac_.append(TAC::InstrType::VAR, var);
+    ensure_stack([this]() { expr_unary(); });
+    ValueType type_rhs = data_.expr_return_type;
+    tac_.append(TAC::InstrType::NE, type_rhs, data_.expr_return_var,
+                tac_.zero(type_rhs), lab_not_true);
+    tac_.append(TAC::InstrType::ASSIGN, "1", var);
+    tac_.append(TAC::InstrType::GOTO, lab_not_end);
+    tac_.label_next_instr(lab_not_true);
+    tac_.append(TAC::InstrType::ASSIGN, "0", var);
+    tac_.label_next_instr(lab_not_end);
+
+    data_.expr_return_var = var;
+    data_.expr_return_type = ValueType::IntVal;
+
+    if (type_rhs == ValueType::RealVal) {
+      warning_msg(data_, DiagId::LogicalType,
+                  "Type mismatch in logical ! operation (operand is not an "
+                  "integer value).", location());
+    }
+    return;
+  }
+  if (token().type == decaf::token_type::OpBitNot) {
+    match(decaf::token_type::OpBitNot);
+    ensure_stack([this]() { expr_unary(); });
+    complement(data_, tac_, data_.expr_return_var, data_.expr_return_type,
+               location());
+    return;
+  }
+  factor();
+}
+
+void DParser::factor() {
+  if (token().type == decaf::token_type::Number) {
+    string value = token().lexeme;
+    const Constant& constant = tac_.constants()[tac_.constants().add(value)];
+    if (!constant.in_range) {
+      error_msg(data_, DiagId::NumberRange,
+                "Number '" + value + "' is out of range.", location());
+    }
+    match(decaf::token_type::Number);
+    data_.expr_return_var = value;
+    data_.expr_return_type = constant.type;
+    return;
+  }
+  if (token().type == decaf::token_type::ptLParen) {
+    match(decaf::token_type::ptLParen);
+    ensure_stack([this]() { expr_or(); });
+    match(decaf::token_type::ptRParen);
+    return;
+  }
+  string id = token().lexeme;
+  match(decaf::token_type::Identifier);
+  if (token().type == decaf::token_type::ptLParen) {
+    ensure_stack([&]() { method_call(id); });
+  } else if (token().type == decaf::token_type::ptLBracket) {
+    match(decaf::token_type::ptLBracket);
+    ensure_stack([this]() { expr_or(); });
+    match(decaf::token_type::ptRBracket);
+    load_element(data_, tac_, data_.sym_table.resolve(data_.method_name, id),
+                 id, data_.expr_return_var, data_.expr_return_type,
+                 location());
+  } else {
+    variable(id);
+  }
+}
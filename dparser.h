@@ -0,0 +1,146 @@
+#ifndef DECAFPARSER_DPARSER_H
+#define DECAFPARSER_DPARSER_H
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "parser.h"
+
+// Generates three-address code directly from the parse routines, without
+// building a syntax tree. It does the same symbol-table and type checks as
+// Node::icg and produces the same code, which takes more lookahead than
+// HParser needs: the code of a chain of || or && operators starts before the
+// code of its leftmost operand, and the else block of an if statement is
+// generated before the if block.
+class DParser : public Parser {
+ public:
+  DParser(FILE* file, Data& data, TAC& tac, bool debug_lexer,
+          bool debug_parser)
+      : Parser(file, debug_lexer, debug_parser),
+        data_(data),
+        tac_(tac),
+        lexer_(nullptr) {}
+
+  // Parse the input and generate its code. Returns 0 on success, 1 after a
+  // syntax error.
+  virtual int parse() override;
+
+  virtual std::string get_name() const override { return "Direct"; }
+
+ private:
+  struct Token {
+    yy::parser_decaf::token_type type;  // Type of the token.
+    std::string lexeme;                 // Matched lexeme.
+    int line;                           // Line number in file where token is.
+    int col;                            // Column number in file where token is.
+    size_t close;  // For '(', '[' or '{', the tokens up to its close, once
+                   // known.
+  };
+
+  // A scanner over a region of the source and the tokens read ahead from it.
+  class Lexer {
+   public:
+    Lexer(const char* bytes, size_t len, int line, int col, bool debug)
+        : scanner_(scanner_create(bytes, len, &loc_, debug)) {
+      loc_.initialize(nullptr, line, col);
+    }
+
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
+    ~Lexer() { scanner_destroy(scanner_); }
+
+    // Return the k-th token ahead, reading up to it if needed.
+    Token& peek(size_t k);
+
+    // Drop the current token.
+    void next();
+
+    // The number of tokens dropped so far: the position of the current one.
+    size_t position() const { return position_; }
+
+    // The positions of the tokens ahead where each variable is assigned to,
+    // incremented or decremented, in order, as found by assigned_in_block().
+    std::unordered_map<std::string, std::vector<size_t>> assignments;
+
+   private:
+    yy::location loc_;
+    yyscan_t scanner_;
+    std::deque<Token> ahead_;
+    size_t position_ = 0;
+  };
+
+  // Thrown after a syntax error is reported. The code generated so far is
+  // incomplete, so parsing stops there.
+  struct SyntaxError {};
+
+  const Token& token(size_t k = 0) { return lexer_->peek(k); }
+
+  // Where the parser is, which diagnostics are reported at.
+  SourceLocation location() {
+    return SourceLocation(token().line, token().col);
+  }
+
+  void error(decaf::token_type type_expected);
+  void match(decaf::token_type type);
+
+  // Offset into the source of a line and column.
+  size_t offset(int line, int col) const {
+    return line_starts_[line - 1] + col - 1;
+  }
+
+  void program();
+  void field_declarations();
+  void constant_declaration();
+  void variable_declarations();
+  ValueType type();
+
+  void method_declaration();
+  ValueType method_return_type();
+  void parameters(Signature& signature);
+
+  void statement_list();
+  void statement();
+  void id_start_stm();
+  void statement_block();
+  void skipped_block(size_t begin, size_t end, int line, int col);
+  void method_call(const std::string& id);
+  // Returns the entry of the variable, or nullptr if it is undeclared.
+  const SymbolTable::Entry* variable(const std::string& id);
+  void incr_decr(const std::string& id, bool incr);
+  bool simple_operand(size_t& k, std::string& spelling);
+  bool loop_condition(size_t& k, std::string& var, TAC::InstrType& op,
+                      std::string& bound);
+  bool assigned_in_block(const std::string& var);
+
+  size_t group_end(size_t k);
+  size_t count_top_level(decaf::token_type op);
+  size_t count_args();
+  void skip_to_rparen();
+
+  void expr_or();
+  void expr_and();
+  void expr_bit_or();
+  void expr_bit_xor();
+  void expr_bit_and();
+  void expr_eq();
+  void expr_rel();
+  void expr_shift();
+  void expr_add();
+  void expr_mult();
+  void relational(TAC::InstrType instr_type, void (DParser::*operand)());
+  void arithmetic(TAC::InstrType instr_type, void (DParser::*operand)());
+  void bitwise_operation(TAC::InstrType instr_type,
+                         void (DParser::*operand)());
+  void expr_unary();
+  void factor();
+
+  Data& data_;
+  TAC& tac_;
+  std::string source_;
+  std::vector<size_t> line_starts_;
+  Lexer* lexer_;
+};
+
+#endif  // DECAFPARSER_DPARSER_H
@@ -0,0 +1,1318 @@
+#include "flat_ast.h"
+#include <unordered_map>
+#include "ast.h"
+#include "ast_visitor.h"
+
+using namespace std;
+
+namespace {
+
+// Checks a node at a time; its children come before it, so that their own
+// checks are done by then.
+class Checker {
+ public:
+  explicit Checker(const FlatAst& ast) : ast_(ast) {}
+
+  bool check(uint32_t n) const {
+    if (ast_.kinds[n] >= NodeKindCount ||
+        ast_.types[n] > static_cast<uint8_t>(ValueType::RealVal) ||
+        ast_.child_begins[n] > ast_.child_begins[n + 1]) {
+      return false;
+    }
+    uint32_t count = ast_.child_count(n);
+    bool has_value = ast_.values[n] < ast_.strings.size();
+    switch (ast_.kind(n)) {
+      case NodeKind::Number:
+      case NodeKind::Variable:
+        return has_value && count == 0;
+      case NodeKind::And:
+      case NodeKind::Or:
+      case NodeKind::Eq:
+      case NodeKind::Neq:
+      case NodeKind::Lt:
+      case NodeKind::Lte:
+      case NodeKind::Gt:
+      case NodeKind::Gte:
+      case NodeKind::Multiply:
+      case NodeKind::Divide:
+      case NodeKind::Modulus:
+      case NodeKind::BitAnd:
+      case NodeKind::BitOr:
+      case NodeKind::BitXor:
+      case NodeKind::ShiftLeft:
+      case NodeKind::ShiftRight:
+        return count == 2 && child_is(n, 0, is_expr) &&
+               child_is(n, 1, is_expr);
+      case NodeKind::Plus:
+      case NodeKind::Minus:
+        return count == 2 && child_is(n, 0, is_expr, true) &&
+               child_is(n, 1, is_expr);
+      case NodeKind::Not:
+      case NodeKind::Complement:
+        return count == 1 && child_is(n, 0, is_expr);
+      case NodeKind::Index:
+        return count == 2 && child_is(n, 0, NodeKind::Variable) &&
+               child_is(n, 1, is_expr);
+      case NodeKind::VariableDeclaration:
+        return children_are(n, NodeKind::Variable);
+      case NodeKind::ConstantDeclaration:
+        return count == 2 && child_is(n, 0, NodeKind::Variable) &&
+               child_is(n, 1, NodeKind::Number);
+      case NodeKind::ArrayDeclaration:
+        return count == 2 && child_is(n, 0, NodeKind::Variable) &&
+               child_is(n, 1, [](NodeKind k) {
+                 return k == NodeKind::Number || k == NodeKind::Variable;
+               });
+      case NodeKind::Parameter:
+        return count == 1 && child_is(n, 0, NodeKind::Variable);
+      case NodeKind::MethodCall:
+        return has_value && children_are(n, is_expr);
+      case NodeKind::Assign:
+        return count == 2 && child_is(n, 0, NodeKind::Variable) &&
+               child_is(n, 1, is_expr);
+      case NodeKind::IndexAssign:
+        return count == 2 && child_is(n, 0, NodeKind::Index) &&
+               child_is(n, 1, is_expr);
+      case NodeKind::Incr:
+      case NodeKind::Decr:
+        return count == 1 && child_is(n, 0, NodeKind::Variable);
+      case NodeKind::Return:
+        return count == 1 && child_is(n, 0, is_expr, true);
+      case NodeKind::Break:
+      case NodeKind::Continue:
+        return count == 0;
+      case NodeKind::Block:
+        return children_are(n, is_stm);
+      case NodeKind::If:
+        return count == 3 && child_is(n, 0, is_expr) &&
+               child_is(n, 1, NodeKind::Block) &&
+               child_is(n, 2, NodeKind::Block, true);
+      case NodeKind::For:
+        return count == 4 && child_is(n, 0, NodeKind::Assign) &&
+               child_is(n, 1, is_expr) &&
+               child_is(n, 2,
+                        [](NodeKind k) {
+                          return k == NodeKind::Incr || k == NodeKind::Decr;
+                        }) &&
+               child_is(n, 3, NodeKind::Block);
+      case NodeKind::Method:
+        return has_value && count == 3 &&
+               list_is(n, 0, NodeKind::Parameter) &&
+               list_is(n, 1,
+                       [](NodeKind k) {
+                         return k == NodeKind::VariableDeclaration ||
+                                k == NodeKind::ArrayDeclaration;
+                       }) &&
+               list_is(n, 2, is_stm);
+      case NodeKind::Program:
+        return has_value && count == 2 &&
+               list_is(n, 0,
+                       [](NodeKind k) {
+                         return k == NodeKind::VariableDeclaration ||
+                                k == NodeKind::ConstantDeclaration ||
+                                k == NodeKind::ArrayDeclaration;
+                       },
+                       true) &&
+               list_is(n, 1, NodeKind::Method, true);
+      case NodeKind::List:
+        // Its elements are checked by its parent.
+        return true;
+    }
+    return false;
+  }
+
+ private:
+  // Whether child 'i' of node 'n' is an earlier node whose kind 'accept's,
+  // or missing if 'optional'.
+  template <typename Accept>
+  bool child_is(uint32_t n, uint32_t i, Accept accept,
+                bool optional = false) const {
+    uint32_t c = ast_.child(n, i);
+    if (c == FlatAst::NoNode) {
+      return optional;
+    }
+    return c < n && accept(ast_.kind(c));
+  }
+
+  bool child_is(uint32_t n, uint32_t i, NodeKind expected,
+                bool optional = false) const {
+    return child_is(n, i, [=](NodeKind k) { return k == expected; },
+                    optional);
+  }
+
+  template <typename Accept>
+  bool children_are(uint32_t n, Accept accept) const {
+    for (uint32_t i = 0; i < ast_.child_count(n); ++i) {
+      if (!child_is(n, i, accept)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool children_are(uint32_t n, NodeKind expected) const {
+    return children_are(n, [=](NodeKind k) { return k == expected; });
+  }
+
+  // Whether child 'i' of node 'n' is a List whose elements' kinds 'accept',
+  // or missing if 'optional'.
+  template <typename Accept>
+  bool list_is(uint32_t n, uint32_t i, Accept accept,
+               bool optional = false) const {
+    uint32_t c = ast_.child(n, i);
+    if (c == FlatAst::NoNode) {
+      return optional;
+    }
+    return child_is(n, i, NodeKind::List) && children_are(c, accept);
+  }
+
+  bool list_is(uint32_t n, uint32_t i, NodeKind expected,
+               bool optional = false) const {
+    return list_is(n, i, [=](NodeKind k) { return k == expected; }, optional);
+  }
+
+  const FlatAst& ast_;
+};
+
+// Adds the nodes of an AST to a FlatAst, children before their parent, with
+// each identifier and literal kept once.
+class AstWriter : public AstVisitor<AstWriter, uint32_t> {
+ public:
+  explicit AstWriter(FlatAst& ast) : ast_(ast) {}
+
+  // Write 'node' and its subtree, returning the index of the node. Children
+  // are written through here, which switches to a new stack segment when the
+  // tree is nested too deeply for the current one.
+  template <typename T>
+  uint32_t write(const T* node) {
+    if (node == nullptr) {
+      return FlatAst::NoNode;
+    }
+    uint32_t n = ensure_stack([&]() { return visit(node); });
+    ast_.locations[n] = node->location();
+    return n;
+  }
+
+  uint32_t visit_number(const NumberExprNode* node) {
+    return add(NodeKind::Number, {}, intern(node->get_value()));
+  }
+
+  uint32_t visit_and(const AndExprNode* node) {
+    return add(node->kind(),
+               {write(node->get_lhs()), write(node->get_rhs())});
+  }
+
+  uint32_t visit_or(const OrExprNode* node) {
+    return add(node->kind(),
+               {write(node->get_lhs()), write(node->get_rhs())});
+  }
+
+  uint32_t visit_not(const NotExprNode* node) {
+    return add(NodeKind::Not, {write(node->get_rhs())});
+  }
+
+  uint32_t visit_relational(const RelationalExprNode* node) {
+    return add(node->kind(),
+               {write(node->get_lhs()), write(node->get_rhs())});
+  }
+
+  uint32_t visit_arithmetic(const ArithmeticExprNode* node) {
+    return add(node->kind(),
+               {write(node->get_lhs()), write(node->get_rhs())});
+  }
+
+  uint32_t visit_bitwise(const BitwiseExprNode* node) {
+    return add(node->kind(),
+               {write(node->get_lhs()), write(node->get_rhs())});
+  }
+
+  uint32_t visit_complement(const ComplementExprNode* node) {
+    return add(NodeKind::Complement, {write(node->get_rhs())});
+  }
+
+  uint32_t visit_variable(const VariableExprNode* node) {
+    return add(NodeKind::Variable, {}, intern(node->get_id()));
+  }
+
+  uint32_t visit_index(const IndexExprNode* node) {
+    return add(NodeKind::Index,
+               {write(node->get_array()), write(node->get_index())});
+  }
+
+  uint32_t visit_variable_declaration(const VariableDeclarationNode* node) {
+    vector<uint32_t> children;
+    write_all(node->get_vars(), children);
+    return add(NodeKind::VariableDeclaration, children, FlatAst::NoNode,
+               node->get_type());
+  }
+
+  uint32_t visit_constant_declaration(const ConstantDeclarationNode* node) {
+    return add(NodeKind::ConstantDeclaration,
+               {write(node->get_var()), write(node->get_value())},
+               FlatAst::NoNode, node->get_type());
+  }
+
+  uint32_t visit_array_declaration(const ArrayDeclarationNode* node) {
+    return add(NodeKind::ArrayDeclaration,
+               {write(node->get_var()), write(node->get_size())},
+               FlatAst::NoNode, node->get_type());
+  }
+
+  uint32_t visit_parameter(const ParameterNode* node) {
+    return add(NodeKind::Parameter, {write(node->get_var())}, FlatAst::NoNode,
+               node->get_type());
+  }
+
+  uint32_t visit_method_call(const MethodCallExprStmNode* node) {
+    vector<uint32_t> children;
+    write_all(node->get_args(), children);
+    return add(NodeKind::MethodCall, children, intern(node->get_id()));
+  }
+
+  uint32_t visit_assign(const AssignStmNode* node) {
+    return add(NodeKind::Assign,
+               {write(node->get_var()), write(node->get_expr())});
+  }
+
+  uint32_t visit_index_assign(const IndexAssignStmNode* node) {
+    return add(NodeKind::IndexAssign,
+               {write(node->get_element()), write(node->get_expr())});
+  }
+
+  uint32_t visit_incr(const IncrStmNode* node) {
+    return add(NodeKind::Incr, {write(node->get_var())});
+  }
+
+  uint32_t visit_decr(const DecrStmNode* node) {
+    return add(NodeKind::Decr, {write(node->get_var())});
+  }
+
+  uint32_t visit_return(const ReturnStmNode* node) {
+    return add(NodeKind::Return, {write(node->get_expr())});
+  }
+
+  uint32_t visit_break(const BreakStmNode*) {
+    return add(NodeKind::Break, {});
+  }
+
+  uint32_t visit_continue(const ContinueStmNode*) {
+    return add(NodeKind::Continue, {});
+  }
+
+  uint32_t visit_block(const BlockStmNode* node) {
+    vector<uint32_t> children;
+    write_all(node->get_stms(), children);
+    return add(NodeKind::Block, children);
+  }
+
+  uint32_t visit_if(const IfStmNode* node) {
+    return add(NodeKind::If, {write(node->get_expr()), write(node->get_if()),
+                              write(node->get_else())});
+  }
+
+  uint32_t visit_for(const ForStmNode* node) {
+    return add(NodeKind::For,
+               {write(node->get_assign()), write(node->get_expr()),
+                write(node->get_incr_decr()), write(node->get_block())});
+  }
+
+  uint32_t visit_method(const MethodNode* node) {
+    return add(NodeKind::Method,
+               {write_list(node->get_params()),
+                write_list(node->get_var_decls()),
+                write_list(node->get_stms())},
+               intern(node->get_id()), node->get_return_type());
+  }
+
+  uint32_t visit_program(const ProgramNode* node) {
+    return add(NodeKind::Program,
+               {write_list(node->get_var_decls()),
+                write_list(node->get_method_decls())},
+               intern(node->get_id()));
+  }
+
+ private:
+  // Write each node of 'nodes', returning the index of a List of them.
+  template <typename T>
+  uint32_t write_list(const list<T*>* nodes) {
+    if (nodes == nullptr) {
+      return FlatAst::NoNode;
+    }
+    vector<uint32_t> children;
+    write_all(nodes, children);
+    return add(NodeKind::List, children);
+  }
+
+  template <typename T>
+  void write_all(const list<T*>* nodes, vector<uint32_t>& children) {
+    children.reserve(nodes->size());
+    for (const T* node : *nodes) {
+      children.push_back(write(node));
+    }
+  }
+
+  uint32_t add(NodeKind kind, const vector<uint32_t>& children,
+               uint32_t value = FlatAst::NoNode,
+               ValueType type = ValueType::VoidVal) {
+    return ast_.add(kind, type, value, children.data(),
+                    children.data() + children.size());
+  }
+
+  uint32_t add(NodeKind kind, initializer_list<uint32_t> children,
+               uint32_t value = FlatAst::NoNode,
+               ValueType type = ValueType::VoidVal) {
+    return ast_.add(kind, type, value, children.begin(), children.end());
+  }
+
+  uint32_t intern(const string& s) {
+    auto it = string_ids_.find(s);
+    if (it != string_ids_.end()) {
+      return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(ast_.strings.size());
+    ast_.strings.push_back(s);
+    string_ids_.emplace(s, id);
+    return id;
+  }
+
+  FlatAst& ast_;
+  unordered_map<string, uint32_t> string_ids_;
+};
+
+// Builds node objects for the nodes of a FlatAst in index order, so that a
+// node's children are built before it.
+class Builder {
+ public:
+  explicit Builder(const FlatAst& ast) : ast_(ast), nodes_(ast.size()) {}
+
+  ProgramNode* build() {
+    for (uint32_t n = 0; n < ast_.size(); ++n) {
+      nodes_[n] = build(n);
+      if (ast_.locations[n].line != 0) {
+        // Only a method call made as a statement has a location.
+        Node* node = ast_.kind(n) == NodeKind::MethodCall ? stm(n) : nodes_[n];
+        node->set_location(ast_.locations[n]);
+      }
+    }
+    return get<ProgramNode>(ast_.root);
+  }
+
+ private:
+  // A method call is kept as its ExprNode, the other nodes as what they are.
+  template <typename T>
+  T* get(uint32_t c) const {
+    return c == FlatAst::NoNode ? nullptr : static_cast<T*>(nodes_[c]);
+  }
+
+  template <typename T>
+  T* get_child(uint32_t n, uint32_t i) const {
+    return get<T>(ast_.child(n, i));
+  }
+
+  StmNode* stm(uint32_t c) const {
+    if (ast_.kind(c) == NodeKind::MethodCall) {
+      return static_cast<MethodCallExprStmNode*>(get<ExprNode>(c));
+    }
+    return get<StmNode>(c);
+  }
+
+  // The children of node 'n'.
+  template <typename T>
+  list<T*>* children(uint32_t n) const {
+    list<T*>* nodes = new list<T*>();
+    for (uint32_t i = 0; i < ast_.child_count(n); ++i) {
+      nodes->push_back(get_child<T>(n, i));
+    }
+    return nodes;
+  }
+
+  list<StmNode*>* stm_children(uint32_t n) const {
+    list<StmNode*>* stms = new list<StmNode*>();
+    for (uint32_t i = 0; i < ast_.child_count(n); ++i) {
+      stms->push_back(stm(ast_.child(n, i)));
+    }
+    return stms;
+  }
+
+  // The elements of child 'i' of node 'n', which is a List.
+  template <typename T>
+  list<T*>* child_list(uint32_t n, uint32_t i) const {
+    uint32_t c = ast_.child(n, i);
+    return c == FlatAst::NoNode ? nullptr : children<T>(c);
+  }
+
+  Node* build(uint32_t n) const {
+    ExprNode* lhs = nullptr;
+    ExprNode* rhs = nullptr;
+    if (ast_.child_count(n) == 2 && is_expr(ast_.kind(n))) {
+      lhs = get_child<ExprNode>(n, 0);
+      rhs = get_child<ExprNode>(n, 1);
+    }
+    switch (ast_.kind(n)) {
+      case NodeKind::Number:
+        return new NumberExprNode(ast_.value(n));
+      case NodeKind::And:
+        return new AndExprNode(lhs, rhs);
+      case NodeKind::Or:
+        return new OrExprNode(lhs, rhs);
+      case NodeKind::Not:
+        return new NotExprNode(get_child<ExprNode>(n, 0));
+      case NodeKind::Eq:
+        return new EqExprNode(lhs, rhs);
+      case NodeKind::Neq:
+        return new NeqExprNode(lhs, rhs);
+      case NodeKind::Lt:
+        return new LtExprNode(lhs, rhs);
+      case NodeKind::Lte:
+        return new LteExprNode(lhs, rhs);
+      case NodeKind::Gt:
+        return new GtExprNode(lhs, rhs);
+      case NodeKind::Gte:
+        return new GteExprNode(lhs, rhs);
+      case NodeKind::Multiply:
+        return new MultiplyExprNode(lhs, rhs);
+      case NodeKind::Divide:
+        return new DivideExprNode(lhs, rhs);
+      case NodeKind::Modulus:
+        return new ModulusExprNode(lhs, rhs);
+      case NodeKind::Plus:
+        return lhs == nullptr ? new PlusExprNode(rhs)
+                              : new PlusExprNode(lhs, rhs);
+      case NodeKind::Minus:
+        return lhs == nullptr ? new MinusExprNode(rhs)
+                              : new MinusExprNode(lhs, rhs);
+      case NodeKind::BitAnd:
+        return new BitAndExprNode(lhs, rhs);
+      case NodeKind::BitOr:
+        return new BitOrExprNode(lhs, rhs);
+      case NodeKind::BitXor:
+        return new BitXorExprNode(lhs, rhs);
+      case NodeKind::ShiftLeft:
+        return new ShiftLeftExprNode(lhs, rhs);
+      case NodeKind::ShiftRight:
+        return new ShiftRightExprNode(lhs, rhs);
+      case NodeKind::Complement:
+        return new ComplementExprNode(get_child<ExprNode>(n, 0));
+      case NodeKind::Variable:
+        return new VariableExprNode(ast_.value(n));
+      case NodeKind::Index:
+        return new IndexExprNode(get_child<VariableExprNode>(n, 0),
+                                 get_child<ExprNode>(n, 1));
+      case NodeKind::VariableDeclaration:
+        return new VariableDeclarationNode(ast_.type(n),
+                                           children<VariableExprNode>(n));
+      case NodeKind::ConstantDeclaration:
+        return new ConstantDeclarationNode(ast_.type(n),
+                                           get_child<VariableExprNode>(n, 0),
+                                           get_child<NumberExprNode>(n, 1));
+      case NodeKind::ArrayDeclaration:
+        return new ArrayDeclarationNode(ast_.type(n),
+                                        get_child<VariableExprNode>(n, 0),
+                                        get_child<ExprNode>(n, 1));
+      case NodeKind::Parameter:
+        return new ParameterNode(ast_.type(n),
+                                 get_child<VariableExprNode>(n, 0));
+      case NodeKind::MethodCall:
+        return static_cast<ExprNode*>(
+            new MethodCallExprStmNode(ast_.value(n), children<ExprNode>(n)));
+      case NodeKind::Assign:
+        return new AssignStmNode(get_child<VariableExprNode>(n, 0),
+                                 get_child<ExprNode>(n, 1));
+      case NodeKind::IndexAssign:
+        return new IndexAssignStmNode(get_child<IndexExprNode>(n, 0),
+                                      get_child<ExprNode>(n, 1));
+      case NodeKind::Incr:
+        return new IncrStmNode(get_child<VariableExprNode>(n, 0));
+      case NodeKind::Decr:
+        return new DecrStmNode(get_child<VariableExprNode>(n, 0));
+      case NodeKind::Return:
+        return new ReturnStmNode(get_child<ExprNode>(n, 0));
+      case NodeKind::Break:
+        return new BreakStmNode();
+      case NodeKind::Continue:
+        return new ContinueStmNode();
+      case NodeKind::Block:
+        return new BlockStmNode(stm_children(n));
+      case NodeKind::If:
+        return new IfStmNode(get_child<ExprNode>(n, 0),
+                             get_child<BlockStmNode>(n, 1),
+                             get_child<BlockStmNode>(n, 2));
+      case NodeKind::For:
+        return new ForStmNode(get_child<AssignStmNode>(n, 0),
+                              get_child<ExprNode>(n, 1),
+                              get_child<IncrDecrStmNode>(n, 2),
+                              get_child<BlockStmNode>(n, 3));
+      case NodeKind::Method:
+        return new MethodNode(ast_.type(n), ast_.value(n),
+                              child_list<ParameterNode>(n, 0),
+                              child_list<VariableDeclarationNode>(n, 1),
+                              stm_children(ast_.child(n, 2)));
+      case NodeKind::Program:
+        return new ProgramNode(ast_.value(n),
+                               child_list<VariableDeclarationNode>(n, 0),
+                               child_list<MethodNode>(n, 1));
+      case NodeKind::List:
+        break;
+    }
+    return nullptr;
+  }
+
+  const FlatAst& ast_;
+  vector<Node*> nodes_;
+};
+
+// Node::icg over the arrays of a FlatAst: each gen_ function here does what
+// the icg of the corresponding node class does.
+class FlatIcg {
+ public:
+  FlatIcg(const FlatAst& ast, Data& data, TAC& tac)
+      : ast_(ast), data_(data), tac_(tac) {}
+
+  // Children are generated through this, which switches to a new stack
+  // segment when the tree is nested too deeply for the current one, and
+  // reports the diagnostics of a node that has a location there.
+  void gen(uint32_t n) {
+    SourceLocation outer = data_.location;
+    if (ast_.locations[n].line != 0) {
+      data_.location = ast_.locations[n];
+    }
+    ensure_stack([&]() { gen_node(n); });
+    data_.location = outer;
+  }
+
+ private:
+  uint32_t child(uint32_t n, uint32_t i) const { return ast_.child(n, i); }
+
+  void gen_node(uint32_t n) {
+    switch (ast_.kind(n)) {
+      case NodeKind::Number:
+        gen_number(n);
+        break;
+      case NodeKind::And:
+        gen_and(n);
+        break;
+      case NodeKind::Or:
+        gen_or(n);
+        break;
+      case NodeKind::Not:
+        gen_not(n);
+        break;
+      case NodeKind::Eq:
+        gen_relational(n, TAC::InstrType::EQ);
+        break;
+      case NodeKind::Neq:
+        gen_relational(n, TAC::InstrType::NE);
+        break;
+      case NodeKind::Lt:
+        gen_relational(n, TAC::InstrType::LT);
+        break;
+      case NodeKind::Lte:
+        gen_relational(n, TAC::InstrType::LE);
+        break;
+      case NodeKind::Gt:
+        gen_relational(n, TAC::InstrType::GT);
+        break;
+      case NodeKind::Gte:
+        gen_relational(n, TAC::InstrType::GE);
+        break;
+      case NodeKind::Multiply:
+        gen_arithmetic(n, TAC::InstrType::MULT);
+        break;
+      case NodeKind::Divide:
+        gen_arithmetic(n, TAC::InstrType::DIVIDE);
+        break;
+      case NodeKind::Modulus:
+        gen_arithmetic(n, TAC::InstrType::MOD);
+        break;
+      case NodeKind::Plus:
+        if (child(n, 0) == FlatAst::NoNode) {
+          gen(child(n, 1));
+        } else {
+          gen_arithmetic(n, TAC::InstrType::ADD);
+        }
+        break;
+      case NodeKind::Minus:
+        if (child(n, 0) == FlatAst::NoNode) {
+          gen_uminus(n);
+        } else {
+          gen_arithmetic(n, TAC::InstrType::SUB);
+        }
+        break;
+      case NodeKind::BitAnd:
+        gen_bitwise(n, TAC::InstrType::BITAND);
+        break;
+      case NodeKind::BitOr:
+        gen_bitwise(n, TAC::InstrType::BITOR);
+        break;
+      case NodeKind::BitXor:
+        gen_bitwise(n, TAC::InstrType::BITXOR);
+        break;
+      case NodeKind::ShiftLeft:
+        gen_bitwise(n, TAC::InstrType::SHL);
+        break;
+      case NodeKind::ShiftRight:
+        gen_bitwise(n, TAC::InstrType::SHR);
+        break;
+      case NodeKind::Complement:
+        gen(child(n, 0));
+        complement(data_, tac_, data_.expr_return_var, data_.expr_return_type);
+        break;
+      case NodeKind::Variable:
+        gen_variable(n);
+        break;
+      case NodeKind::Index:
+        gen(child(n, 1));
+        load_element(data_, tac_, symbol(child(n, 0)), ast_.value(child(n, 0)),
+                     data_.expr_return_var, data_.expr_return_type);
+        break;
+      case NodeKind::VariableDeclaration:
+        gen_variable_declaration(n);
+        break;
+      case NodeKind::ConstantDeclaration:
+        gen_constant_declaration(n);
+        break;
+      case NodeKind::ArrayDeclaration:
+        declare_array(data_, tac_, ast_.value(child(n, 0)), ast_.type(n),
+                      ast_.value(child(n, 1)));
+        break;
+      case NodeKind::Parameter:
+        gen_parameter(n);
+        break;
+      case NodeKind::MethodCall:
+        gen_method_call(n);
+        break;
+      case NodeKind::Assign:
+        gen_assign(n);
+        break;
+      case NodeKind::IndexAssign:
+        gen_index_assign(n);
+        break;
+      case NodeKind::Incr:
+        gen_variable(child(n, 0));
+        check_assignable(data_, symbol(child(n, 0)));
+        tac_.append(TAC::InstrType::ADD, data_.expr_return_type,
+                    data_.expr_return_var,
+                    data_.expr_return_type == ValueType::RealVal ? "1.0" : "1",
+                    data_.expr_return_var);
+        break;
+      case NodeKind::Decr:
+        gen_variable(child(n, 0));
+        check_assignable(data_, symbol(child(n, 0)));
+        tac_.append(TAC::InstrType::SUB, data_.expr_return_type,
+                    data_.expr_return_var,
+                    data_.expr_return_type == ValueType::RealVal ? "1.0" : "1",
+                    data_.expr_return_var);
+        break;
+      case NodeKind::Return:
+        gen_return(n);
+        break;
+      case NodeKind::Break:
+      case NodeKind::Continue:
+        gen_break_continue(n);
+        break;
+      case NodeKind::Block:
+        gen_children(n);
+        break;
+      case NodeKind::If:
+        gen_if(n);
+        break;
+      case NodeKind::For:
+        gen_for(n);
+        break;
+      case NodeKind::Method:
+        gen_method(n);
+        break;
+      case NodeKind::Program:
+        gen_program(n);
+        break;
+      case NodeKind::List:
+        gen_children(n);
+        break;
+    }
+  }
+
+  void gen_children(uint32_t n) {
+    for (uint32_t i = 0; i < ast_.child_count(n); ++i) {
+      gen(child(n, i));
+    }
+  }
+
+  void gen_number(uint32_t n) {
+    const string& value = ast_.value(n);
+    const Constant& constant = tac_.constants()[tac_.constants().add(value)];
+    data_.expr_return_var = value;
+    data_.expr_return_type = constant.type;
+  }
+
+  void gen_and(uint32_t n) {
+    string result_var = tac_.tmp_variable_name(data_.variable_no++);
+    string lab_and_false = tac_.label_name("and_false", data_.label_no);
+    string lab_and_end = tac_.label_name("and_end", data_.label_no);
+    data_.label_no++;
+
+    tac_.append(TAC::InstrType::VAR, result_var);
+
+    gen(child(n, 0));
+    auto lhs_type = data_.expr_return_type;
+    tac_.append(TAC::InstrType::EQ, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_and_false);
+
+    gen(child(n, 1));
+    tac_.append(TAC::InstrType::EQ, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_and_false);
+
+    if (lhs_type != ValueType::IntVal ||
+        data_.expr_return_type != ValueType::IntVal) {
+      warning_msg(data_, DiagId::LogicalType,
+                  "Type mismatch in logical && (operands are not integer "
+                  "values).");
+    }
+
+    tac_.append(TAC::InstrType::ASSIGN, "1", result_var);
+    tac_.append(TAC::InstrType::GOTO, lab_and_end);
+    tac_.label_next_instr(lab_and_false);
+    tac_.append(TAC::InstrType::ASSIGN, "0", result_var);
+    tac_.label_next_instr(lab_and_end);
+
+    data_.expr_return_var = result_var;
+    data_.expr_return_type = ValueType::IntVal;
+  }
+
+  void gen_or(uint32_t n) {
+    string result_var = tac_.tmp_variable_name(data_.variable_no++);
+    string lab_or_true = tac_.label_name("or_true", data_.label_no);
+    string lab_or_end = tac_.label_name("or_end", data_.label_no);
+    data_.label_no++;
+
+    tac_.append(TAC::InstrType::VAR, result_var);
+
+    gen(child(n, 0));
+    tac_.append(TAC::InstrType::NE, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_or_true);
+    auto lhs_type = data_.expr_return_type;
+
+    gen(child(n, 1));
+    tac_.append(TAC::InstrType::NE, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_or_true);
+
+    if (lhs_type != ValueType::IntVal ||
+        data_.expr_return_type != ValueType::IntVal) {
+      warning_msg(data_, DiagId::LogicalType,
+                  "Type mismatch in logical || (operands are not integer "
+                  "values).");
+    }
+
+    tac_.append(TAC::InstrType::ASSIGN, "0", result_var);
+    tac_.append(TAC::InstrType::GOTO, lab_or_end);
+    tac_.label_next_instr(lab_or_true);
+    tac_.append(TAC::InstrType::ASSIGN, "1", result_var);
+    tac_.label_next_instr(lab_or_end);
+
+    data_.expr_return_var = result_var;
+    data_.expr_return_type = ValueType::IntVal;
+  }
+
+  void gen_not(uint32_t n) {
+    string var = tac_.tmp_variable_name(data_.variable_no++);
+    string lab_not_true = tac_.label_name("not_true", data_.label_no);
+    string lab_not_end = tac_.label_name("not_end", data_.label_no);
+    data_.label_no++;
+
+    tac_.append(TAC::InstrType::VAR, var);
+    gen(child(n, 0));
+    ValueType type_rhs = data_.expr_return_type;
+    tac_.append(TAC::InstrType::NE, type_rhs, data_.expr_return_var,
+                tac_.zero(type_rhs), lab_not_true);
+    tac_.append(TAC::InstrType::ASSIGN, "1", var);
+    tac_.append(TAC::InstrType::GOTO, lab_not_end);
+    tac_.label_next_instr(lab_not_true);
+    tac_.append(TAC::InstrType::ASSIGN, "0", var);
+    tac_.label_next_instr(lab_not_end);
+
+    data_.expr_return_var = var;
+    data_.expr_return_type = ValueType::IntVal;
+
+    if (type_rhs == ValueType::RealVal) {
+      warning_msg(data_, DiagId::LogicalType,
+                  "Type mismatch in logical ! operation (operand is not an "
+                  "integer value).");
+    }
+  }
+
+  void gen_relational(uint32_t n, TAC::InstrType instr_type) {
+    gen(child(n, 0));
+    string var_lhs = data_.expr_return_var;
+    ValueType type_lhs = data_.expr_return_type;
+
+    gen(child(n, 1));
+    string var_rhs = data_.expr_return_var;
+    ValueType type_rhs = data_.expr_return_type;
+
+    // Mixed operands are compared as reals.
+    ValueType type = (type_lhs == ValueType::RealVal ? type_lhs : type_rhs);
+    var_lhs = convert(data_, tac_, var_lhs, type_lhs, type);
+    var_rhs = convert(data_, tac_, var_rhs, type_rhs, type);
+
+    string lab_rel_true = tac_.label_name("rel_true", data_.label_no);
+    string lab_rel_end = tac_.label_name("rel_end", data_.label_no);
+    data_.label_no++;
+    string var = tac_.tmp_variable_name(data_.variable_no++);
+
+    tac_.append(TAC::InstrType::VAR, var);
+    tac_.append(instr_type, type, var_lhs, var_rhs, lab_rel_true);
+    tac_.append(TAC::InstrType::ASSIGN, "0", var);
+    tac_.append(TAC::InstrType::GOTO, lab_rel_end);
+    tac_.label_next_instr(lab_rel_true);
+    tac_.append(TAC::InstrType::ASSIGN, "1", var);
+    tac_.label_next_instr(lab_rel_end);
+
+    data_.expr_return_var = var;
+    data_.expr_return_type = ValueType::IntVal;
+
+    if ((type_lhs == ValueType::IntVal && type_rhs == ValueType::RealVal) ||
+        (type_lhs == ValueType::RealVal && type_rhs == ValueType::IntVal)) {
+      warning_msg(data_, DiagId::CompareType,
+                  "Type mismatch in operation " + tac_.IName[instr_type] + ".");
+    }
+  }
+
+  void gen_arithmetic(uint32_t n, TAC::InstrType instr_type) {
+    gen(child(n, 0));
+    string lhs_var = data_.expr_return_var;
+    auto lhs_type = data_.expr_return_type;
+    gen(child(n, 1));
+    string rhs_var = data_.expr_return_var;
+
+    if (lhs_type != data_.expr_return_type) {
+      warning_msg(data_, DiagId::ArithmeticType,
+                  "Mixing int and real types in operation " +
+                  tac_.IName[instr_type] + ".");
+    }
+    // The operation is of the type of its left operand.
+    rhs_var = convert(data_, tac_, rhs_var, data_.expr_return_type, lhs_type);
+
+    string result_var = tac_.tmp_variable_name(data_.variable_no++);
+    tac_.append(TAC::InstrType::VAR, result_var);
+
+    tac_.append(instr_type, lhs_type, lhs_var, rhs_var, result_var);
+    data_.expr_return_var = result_var;
+    data_.expr_return_type = lhs_type;
+  }
+
+  void gen_bitwise(uint32_t n, TAC::InstrType instr_type) {
+    gen(child(n, 0));
+    string lhs_var = data_.expr_return_var;
+    auto lhs_type = data_.expr_return_type;
+    gen(child(n, 1));
+    bitwise(data_, tac_, instr_type, lhs_var, lhs_type, data_.expr_return_var,
+            data_.expr_return_type);
+  }
+
+  void gen_uminus(uint32_t n) {
+    gen(child(n, 1));
+    string var = tac_.tmp_variable_name(data_.variable_no++);
+    tac_.append(TAC::InstrType::VAR, var);
+    tac_.append(TAC::InstrType::UMINUS, data_.expr_return_type,
+                data_.expr_return_var, var);
+    data_.expr_return_var = var;
+  }
+
+  // The entry of Variable 'n', or nullptr if it is undeclared.
+  const SymbolTable::Entry* symbol(uint32_t n) const {
+    return data_.sym_table.resolve(data_.method_name, ast_.value(n));
+  }
+
+  void gen_variable(uint32_t n) {
+    const string& id = ast_.value(n);
+    data_.expr_return_var = id;
+    data_.expr_return_type = ValueType::VoidVal;
+
+    const SymbolTable::Entry* entry = symbol(n);
+    if (entry == nullptr) {
+      error_msg(data_, DiagId::UndeclaredVariable,
+                "Undeclared identifier '" + id + "'.");
+    } else {
+      data_.expr_return_type = entry->value_type;
+      if (entry->entry_type == EntryType::Constant) {
+        tac_.constants().add(entry->value);
+        data_.expr_return_var = entry->value;
+      } else if (entry->array_size != 0) {
+        error_msg(data_, DiagId::ArrayUse,
+                  "Array '" + id + "' is used without an index.");
+      }
+    }
+  }
+
+  void gen_variable_declaration(uint32_t n) {
+    for (uint32_t i = 0; i < ast_.child_count(n); ++i) {
+      const string& id = ast_.value(child(n, i));
+      add_to_symbol_table(data_, EntryType::Variable, data_.method_name, id,
+                          ast_.type(n));
+      tac_.append(TAC::InstrType::VAR, id);
+    }
+  }
+
+  void gen_constant_declaration(uint32_t n) {
+    const string& literal = ast_.value(child(n, 1));
+    Constant constant;
+    parse_literal(literal, constant);
+    declare_constant(data_, ast_.value(child(n, 0)), ast_.type(n), literal,
+                     constant);
+  }
+
+  void gen_parameter(uint32_t n) {
+    const string& id = ast_.value(child(n, 0));
+    add_to_symbol_table(data_, EntryType::Variable, data_.method_name, id,
+                        ast_.type(n));
+    tac_.append(TAC::InstrType::FPARAM, id);
+  }
+
+  void gen_method_call(uint32_t n) {
+    const string& id = ast_.value(n);
+    uint32_t args = ast_.child_count(n);
+    SymbolTable::Entry* entry = data_.sym_table.lookup("", id);
+
+    if (entry == nullptr) {
+      if (id != "writeln" && id != "write") {
+        error_msg(data_, DiagId::UndeclaredMethod,
+                  "Method '" + id + "' undeclared.");
+      } else {
+        if (args != 1) {
+          warning_msg(data_, DiagId::WriteArguments,
+                      "Method '" + id + "' accepts 1 argument but " +
+                      to_string(args) + " given.");
+        }
+        if (args != 0) {
+          gen(child(n, 0));
+          tac_.append(TAC::InstrType::APARAM, data_.expr_return_var);
+        }
+        tac_.append(TAC::InstrType::CALL, id);
+        data_.expr_return_var = id;
+      }
+      return;
+    }
+
+    const Signature& formal_parameters = entry->signature;
+    bool wrong_parameters = formal_parameters.size() != args;
+    auto iter_formal = formal_parameters.begin();
+    vector<string> expr_var_names;
+    string given_params;
+    for (uint32_t i = 0; i < args; ++i) {
+      gen(child(n, i));
+      string arg_var = data_.expr_return_var;
+      if (iter_formal != formal_parameters.end()) {
+        arg_var = convert(data_, tac_, arg_var, data_.expr_return_type,
+                          *iter_formal);
+      }
+      string param_var = tac_.tmp_variable_name(data_.variable_no++);
+      tac_.append(TAC::InstrType::VAR, param_var);
+      tac_.append(TAC::InstrType::ASSIGN, arg_var, param_var);
+      expr_var_names.push_back(param_var);
+
+      if (!given_params.empty()) {
+        given_params += ", ";
+      }
+      given_params += tostr(data_.expr_return_type);
+
+      if (iter_formal == formal_parameters.end() ||
+          data_.expr_return_type != *iter_formal) {
+        wrong_parameters = true;
+      }
+      if (iter_formal != formal_parameters.end()) {
+        ++iter_formal;
+      }
+    }
+
+    for (auto& expr_var : expr_var_names) {
+      tac_.append(TAC::InstrType::APARAM, expr_var);
+    }
+
+    if (wrong_parameters) {
+      warning_msg(data_, DiagId::ParameterType,
+                  "Parameters mismatch for method call '" + id +
+                  "': expected " + tostr(formal_parameters, ", ") +
+                  "; given " + given_params);
+    }
+
+    tac_.append(TAC::InstrType::CALL, id);
+    data_.expr_return_var = id;
+    if (tac_.typed()) {
+      data_.expr_return_type = entry->value_type;
+    }
+  }
+
+  void gen_assign(uint32_t n) {
+    gen_variable(child(n, 0));
+    check_assignable(data_, symbol(child(n, 0)));
+    string var = data_.expr_return_var;
+    ValueType var_type = data_.expr_return_type;
+
+    gen(child(n, 1));
+    string exp_var = data_.expr_return_var;
+    ValueType exp_type = data_.expr_return_type;
+
+    tac_.append(TAC::InstrType::ASSIGN,
+                convert(data_, tac_, exp_var, exp_type, var_type), var);
+
+    if ((var_type == ValueType::IntVal && exp_type == ValueType::RealVal) ||
+        (var_type == ValueType::RealVal && exp_type == ValueType::IntVal)) {
+      warning_msg(data_, DiagId::AssignType,
+                  "Type mismatch in assigning to variable '" + var + "'.");
+    }
+  }
+
+  void gen_return(uint32_t n) {
+    bool has_expr = child(n, 0) != FlatAst::NoNode;
+    SymbolTable::Entry* entry = data_.sym_table.lookup("", data_.method_name);
+    if (has_expr) {
+      gen(child(n, 0));
+      tac_.append(TAC::InstrType::ASSIGN,
+                  convert(data_, tac_, data_.expr_return_var,
+                          data_.expr_return_type,
+                          entry != nullptr ? entry->value_type
+                                           : ValueType::VoidVal),
+                  data_.method_name);
+    }
+    tac_.append(TAC::InstrType::RETURN);
+
+    if (entry != nullptr) {
+      if ((has_expr && entry->value_type == ValueType::VoidVal) ||
+          (!has_expr && entry->value_type != ValueType::VoidVal)) {
+        error_msg(data_, DiagId::ReturnValue,
+                  "Return statement in '" + data_.method_name +
+                  "' does not match return value.");
+      }
+      if (has_expr && data_.expr_return_type != entry->value_type) {
+        warning_msg(data_, DiagId::ReturnType,
+                    "Returned value in '" + data_.method_name +
+                    "' does not match return type.");
+      }
+    }
+  }
+
+  void gen_break_continue(uint32_t n) {
+    bool is_break = ast_.kind(n) == NodeKind::Break;
+    if (!data_.for_label_no.empty()) {
+      string label = tac_.label_name(is_break ? "for_end" : "for_incr",
+                                     data_.for_label_no.top());
+      tac_.append(TAC::InstrType::GOTO, label);
+    } else if (is_break) {
+      error_msg(data_, DiagId::BreakOutsideLoop,
+                "Break statement used outside a loop.");
+    } else {
+      error_msg(data_, DiagId::ContinueOutsideLoop,
+                "Continue statement used outside a loop.");
+    }
+  }
+
+  void gen_if(uint32_t n) {
+    string lab_true_block = tac_.label_name("true_block", data_.label_no);
+    string lab_if_end = tac_.label_name("if_end", data_.label_no);
+    data_.label_no++;
+
+    gen(child(n, 0));
+    if (data_.expr_return_type != ValueType::IntVal) {
+      warning_msg(data_, DiagId::ConditionType,
+                  "Type mismatch in if statement (conditional statement is not "
+                  "an integer value).");
+    }
+    tac_.append(TAC::InstrType::NE, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_true_block);
+    if (child(n, 2) != FlatAst::NoNode) {
+      gen(child(n, 2));
+    }
+    tac_.append(TAC::InstrType::GOTO, lab_if_end);
+
+    tac_.label_next_instr(lab_true_block);
+    gen(child(n, 1));
+
+    tac_.label_next_instr(lab_if_end);
+  }
+
+  void gen_index_assign(uint32_t n) {
+    uint32_t element = child(n, 0);
+    gen(child(element, 1));
+    string index = data_.expr_return_var;
+    ValueType index_type = data_.expr_return_type;
+
+    gen(child(n, 1));
+    store_element(data_, tac_, symbol(child(element, 0)),
+                  ast_.value(child(element, 0)), index, index_type,
+                  data_.expr_return_var, data_.expr_return_type);
+  }
+
+  void gen_for(uint32_t n) {
+    string lab_for_expr = tac_.label_name("for_expr", data_.label_no);
+    string lab_for_incr = tac_.label_name("for_incr", data_.label_no);
+    string lab_for_end = tac_.label_name("for_end", data_.label_no);
+    data_.for_label_no.push(data_.label_no);
+    data_.label_no++;
+
+    gen(child(n, 0));
+
+    tac_.label_next_instr(lab_for_expr);
+    gen(child(n, 1));
+    if (data_.expr_return_type != ValueType::IntVal) {
+      warning_msg(data_, DiagId::ConditionType,
+                  "Type mismatch in for statement (conditional statement is "
+                  "not an integer value).");
+    }
+
+    tac_.append(TAC::InstrType::EQ, data_.expr_return_type,
+                data_.expr_return_var, tac_.zero(data_.expr_return_type),
+                lab_for_end);
+    LoopRange range;
+    bool ranged = loop_range(n, range);
+    if (ranged) {
+      data_.loop_ranges.push_back(range);
+    }
+    gen(child(n, 3));
+    if (ranged) {
+      data_.loop_ranges.pop_back();
+    }
+
+    tac_.label_next_instr(lab_for_incr);
+    gen(child(n, 2));
+    tac_.append(TAC::InstrType::GOTO, lab_for_expr);
+
+    tac_.label_next_instr(lab_for_end);
+    data_.for_label_no.pop();
+  }
+
+  // The range of the variable of For 'n' in its body, if known (see
+  // ::loop_range).
+  bool loop_range(uint32_t n, LoopRange& range) {
+    uint32_t cond = child(n, 1);
+    const string& var = ast_.value(child(child(n, 0), 0));
+    if (ast_.value(child(child(n, 2), 0)) != var ||
+        ast_.kind(cond) < NodeKind::Lt || ast_.kind(cond) > NodeKind::Gte ||
+        ast_.kind(child(cond, 0)) != NodeKind::Variable ||
+        ast_.value(child(cond, 0)) != var) {
+      return false;
+    }
+    static const TAC::InstrType Ops[] = {
+        TAC::InstrType::LT, TAC::InstrType::LE, TAC::InstrType::GT,
+        TAC::InstrType::GE};
+    TAC::InstrType op = Ops[static_cast<int>(ast_.kind(cond)) -
+                            static_cast<int>(NodeKind::Lt)];
+    if (!::loop_range(data_, var, spelling(child(child(n, 0), 1)), op,
+                      spelling(child(cond, 1)),
+                      ast_.kind(child(n, 2)) == NodeKind::Incr, range)) {
+      return false;
+    }
+
+    // The body must not assign the variable, at any depth.
+    vector<uint32_t> nodes(1, child(n, 3));
+    while (!nodes.empty()) {
+      uint32_t node = nodes.back();
+      nodes.pop_back();
+      switch (ast_.kind(node)) {
+        case NodeKind::Block:
+        case NodeKind::If:
+        case NodeKind::For:
+          for (uint32_t i = 0; i < ast_.child_count(node); ++i) {
+            if (child(node, i) != FlatAst::NoNode &&
+                is_stm(ast_.kind(child(node, i)))) {
+              nodes.push_back(child(node, i));
+            }
+          }
+          break;
+        case NodeKind::Assign:
+        case NodeKind::Incr:
+        case NodeKind::Decr:
+          if (ast_.value(child(node, 0)) == var) {
+            return false;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+  }
+
+  // The literal of a Number, or the name of a Variable; empty otherwise.
+  string spelling(uint32_t n) const {
+    NodeKind kind = ast_.kind(n);
+    return kind == NodeKind::Number || kind == NodeKind::Variable
+               ? ast_.value(n)
+               : string();
+  }
+
+  void gen_method(uint32_t n) {
+    const string& id = ast_.value(n);
+    uint32_t params = child(n, 0);
+    Signature signature;
+    data_.method_name = id;
+    tac_.label_next_instr(data_.method_name);
+    for (uint32_t i = 0; i < ast_.child_count(params); ++i) {
+      uint32_t param = child(params, i);
+      gen_parameter(param);
+      signature.push_back(ast_.type(param));
+    }
+    add_to_symbol_table(data_, EntryType::Method, "", id, ast_.type(n),
+                        signature);
+    add_to_symbol_table(data_, EntryType::Method, id, id, ast_.type(n),
+                        signature);
+
+    gen_children(child(n, 1));
+    gen_children(child(n, 2));
+    if (tac_.last_instr_type() != TAC::InstrType::RETURN) {
+      tac_.append(TAC::InstrType::RETURN);
+    }
+    data_.method_name = "";
+  }
+
+  void gen_program(uint32_t n) {
+    if (child(n, 0) != FlatAst::NoNode) {
+      gen_children(child(n, 0));
+    }
+    tac_.append(TAC::InstrType::GOTO, "main");
+    if (child(n, 1) != FlatAst::NoNode) {
+      gen_children(child(n, 1));
+    }
+
+    SymbolTable::Entry* entry = data_.sym_table.lookup("", "main");
+    if (entry == nullptr) {
+      error_msg(data_, DiagId::MissingMain, "Main method is missing.");
+    }
+  }
+
+  const FlatAst& ast_;
+  Data& data_;
+  TAC& tac_;
+};
+
+}  // namespace
+
+bool FlatAst::check() const {
+  uint32_t n = size();
+  if (types.size() != n || values.size() != n || locations.size() != n ||
+      child_begins.size() != size_t(n) + 1 || child_begins[0] != 0 ||
+      child_begins[n] != children.size()) {
+    return false;
+  }
+  Checker checker(*this);
+  for (uint32_t i = 0; i < n; ++i) {
+    if (!checker.check(i)) {
+      return false;
+    }
+  }
+  return root < n && kind(root) == NodeKind::Program;
+}
+
+void flatten(const ProgramNode* program, FlatAst& ast) {
+  AstWriter writer(ast);
+  ast.root = writer.write(program);
+}
+
+ProgramNode* unflatten(const FlatAst& ast) { return Builder(ast).build(); }
+
+void flat_icg(const FlatAst& ast, Data& data, TAC& tac) {
+  FlatIcg(ast, data, tac).gen(ast.root);
+}
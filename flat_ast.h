@@ -0,0 +1,153 @@
+#ifndef DECAFPARSER_FLAT_AST_H
+#define DECAFPARSER_FLAT_AST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "diagnostics.h"
+#include "symbol_table.h"
+
+class ProgramNode;
+struct Data;
+class TAC;
+
+// The kind of each node, one per class of ast.h, in the node objects and in a
+// FlatAst. List nodes, only in a FlatAst, hold the children of a node that has
+// more than one list of them.
+enum class NodeKind : uint8_t {
+  Number,
+  And,
+  Or,
+  Not,
+  Eq,
+  Neq,
+  Lt,
+  Lte,
+  Gt,
+  Gte,
+  Multiply,
+  Divide,
+  Modulus,
+  Plus,
+  Minus,
+  BitAnd,
+  BitOr,
+  BitXor,
+  ShiftLeft,
+  ShiftRight,
+  Complement,
+  Variable,
+  Index,
+  VariableDeclaration,
+  ConstantDeclaration,
+  ArrayDeclaration,
+  Parameter,
+  MethodCall,
+  Assign,
+  IndexAssign,
+  Incr,
+  Decr,
+  Return,
+  Break,
+  Continue,
+  Block,
+  If,
+  For,
+  Method,
+  Program,
+  List
+};
+
+const uint8_t NodeKindCount = static_cast<uint8_t>(NodeKind::List) + 1;
+
+// Method calls are both expressions and statements.
+inline bool is_expr(NodeKind kind) {
+  return kind <= NodeKind::Index || kind == NodeKind::MethodCall;
+}
+
+inline bool is_stm(NodeKind kind) {
+  return kind >= NodeKind::MethodCall && kind <= NodeKind::For;
+}
+
+// An AST held in arrays indexed by node, rather than as a graph of node
+// objects. A node's children come before it, and its child indices are the
+// range children[child_begins[n], child_begins[n + 1]), so the children of
+// consecutive nodes are consecutive too. A missing (null) child is NoNode.
+//
+// The children of each kind of node, in order:
+//   And, Or, Eq ... Gte, Multiply, Divide, Modulus, BitAnd ... ShiftRight: two
+//     expressions.
+//   Plus, Minus: an expression or NoNode (unary), an expression.
+//   Not, Complement: an expression.
+//   Index: a Variable, the array, and an expression.
+//   VariableDeclaration: Variables.
+//   ConstantDeclaration: a Variable, a Number.
+//   ArrayDeclaration: a Variable, a Number or Variable (constant), the size.
+//   Parameter, Incr, Decr: a Variable.
+//   MethodCall: expressions, the arguments.
+//   Assign: a Variable, an expression.
+//   IndexAssign: an Index, an expression.
+//   Return: an expression or NoNode.
+//   Block: statements.
+//   If: an expression, a Block, a Block or NoNode (no else).
+//   For: an Assign, an expression, an Incr or Decr, a Block.
+//   Method: Lists of Parameters, VariableDeclarations and statements.
+//   Program: Lists of Variable-, Constant- and ArrayDeclarations and of
+//     Methods, each possibly NoNode.
+// Number, Variable, MethodCall, Method and Program have a value, their
+// literal or identifier; the declarations, Parameter and Method a type.
+// Statements, declarations and methods may have a location.
+struct FlatAst {
+  static const uint32_t NoNode = 0xffffffff;
+
+  FlatAst() : child_begins(1, 0), root(NoNode) {}
+
+  uint32_t size() const { return static_cast<uint32_t>(kinds.size()); }
+
+  NodeKind kind(uint32_t n) const { return static_cast<NodeKind>(kinds[n]); }
+
+  ValueType type(uint32_t n) const { return static_cast<ValueType>(types[n]); }
+
+  const std::string& value(uint32_t n) const { return strings[values[n]]; }
+
+  uint32_t child_count(uint32_t n) const {
+    return child_begins[n + 1] - child_begins[n];
+  }
+
+  uint32_t child(uint32_t n, uint32_t i) const {
+    return children[child_begins[n] + i];
+  }
+
+  // Add a node whose children are [begin, end), returning its index.
+  uint32_t add(NodeKind kind, ValueType type, uint32_t value,
+               const uint32_t* begin, const uint32_t* end) {
+    kinds.push_back(static_cast<uint8_t>(kind));
+    types.push_back(static_cast<uint8_t>(type));
+    values.push_back(value);
+    locations.push_back(SourceLocation());
+    children.insert(children.end(), begin, end);
+    child_begins.push_back(static_cast<uint32_t>(children.size()));
+    return size() - 1;
+  }
+
+  // Whether the arrays hold an AST as described above, rooted at a Program.
+  bool check() const;
+
+  std::vector<uint8_t> kinds;          // NodeKind
+  std::vector<uint8_t> types;          // ValueType
+  std::vector<uint32_t> values;        // Index into 'strings', or NoNode.
+  std::vector<SourceLocation> locations;
+  std::vector<uint32_t> child_begins;  // One more than there are nodes.
+  std::vector<uint32_t> children;
+  std::vector<std::string> strings;  // Identifiers and literals, once each.
+  uint32_t root;
+};
+
+// Convert between the node classes and a FlatAst.
+void flatten(const ProgramNode* program, FlatAst& ast);
+ProgramNode* unflatten(const FlatAst& ast);
+
+// Generate the code of a checked FlatAst, the same as Node::icg would.
+void flat_icg(const FlatAst& ast, Data& data, TAC& tac);
+
+#endif  // DECAFPARSER_FLAT_AST_H
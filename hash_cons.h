@@ -0,0 +1,126 @@
+#ifndef DECAFPARSER_HASH_CONS_H
+#define DECAFPARSER_HASH_CONS_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "ast.h"
+
+// Hash-consing of pure expression nodes (numbers, variables, and the
+// arithmetic, bitwise, relational and logical operators over pure operands): a
+// node equal to one made before, the same kind with the same literal or
+// identifier and the same operand nodes, is replaced by that one, so that
+// structurally identical subtrees are a single node. Nodes are interned bottom
+// up, as they are built, so that equal operands are already the same node and
+// comparing them is comparing pointers.
+//
+// Method calls and array elements are left alone, and with them the
+// expressions over them. The meaning of an identifier depends on the method it
+// is in, so a parser keeps one table per method, clearing it at the end of
+// each.
+class HashConsTable {
+ public:
+  HashConsTable() : hits_(0) {}
+
+  HashConsTable(const HashConsTable&) = delete;
+  HashConsTable& operator=(const HashConsTable&) = delete;
+
+  // Return the node equal to 'node' that was interned before, deleting
+  // 'node', or else 'node' itself, which equal nodes are replaced by from
+  // then on. Only the node is deleted, as its operands are shared.
+  ExprNode* intern(ExprNode* node) {
+    Key key;
+    if (!make_key(node, key)) {
+      return node;
+    }
+    auto inserted = nodes_.insert(std::make_pair(key, node));
+    if (!inserted.second) {
+      ++hits_;
+      delete node;
+      return inserted.first->second;
+    }
+    interned_.insert(node);
+    return node;
+  }
+
+  // Forget the nodes interned so far; later nodes share none of them.
+  void clear() {
+    nodes_.clear();
+    interned_.clear();
+  }
+
+  // The number of distinct nodes interned since the last clear().
+  size_t size() const { return nodes_.size(); }
+
+  // The number of nodes replaced by an equal one, in all.
+  size_t hits() const { return hits_; }
+
+ private:
+  struct Key {
+    NodeKind kind;
+    const ExprNode* lhs;
+    const ExprNode* rhs;
+    std::string value;
+
+    bool operator==(const Key& other) const {
+      return kind == other.kind && lhs == other.lhs && rhs == other.rhs &&
+             value == other.value;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t hash = std::hash<std::string>()(key.value);
+      hash = hash * 31 + static_cast<size_t>(key.kind);
+      hash = hash * 31 + std::hash<const ExprNode*>()(key.lhs);
+      return hash * 31 + std::hash<const ExprNode*>()(key.rhs);
+    }
+  };
+
+  // Fill in the key of 'node'. Returns false if the node is not pure.
+  bool make_key(const ExprNode* node, Key& key) const {
+    key.kind = node->kind();
+    key.lhs = nullptr;
+    key.rhs = nullptr;
+    if (auto number = dyn_cast<NumberExprNode>(node)) {
+      key.value = number->get_value();
+      return true;
+    }
+    if (auto variable = dyn_cast<VariableExprNode>(node)) {
+      key.value = variable->get_id();
+      return true;
+    }
+    if (auto relational = dyn_cast<RelationalExprNode>(node)) {
+      key.lhs = relational->get_lhs();
+      key.rhs = relational->get_rhs();
+    } else if (auto arithmetic = dyn_cast<ArithmeticExprNode>(node)) {
+      key.lhs = arithmetic->get_lhs();  // nullptr if unary.
+      key.rhs = arithmetic->get_rhs();
+    } else if (auto op_and = dyn_cast<AndExprNode>(node)) {
+      key.lhs = op_and->get_lhs();
+      key.rhs = op_and->get_rhs();
+    } else if (auto op_or = dyn_cast<OrExprNode>(node)) {
+      key.lhs = op_or->get_lhs();
+      key.rhs = op_or->get_rhs();
+    } else if (auto bitwise = dyn_cast<BitwiseExprNode>(node)) {
+      key.lhs = bitwise->get_lhs();
+      key.rhs = bitwise->get_rhs();
+    } else if (auto op_not = dyn_cast<NotExprNode>(node)) {
+      key.rhs = op_not->get_rhs();
+    } else if (auto complement = dyn_cast<ComplementExprNode>(node)) {
+      key.rhs = complement->get_rhs();
+    } else {
+      return false;
+    }
+    return (key.lhs == nullptr || interned_.count(key.lhs) != 0) &&
+           interned_.count(key.rhs) != 0;
+  }
+
+  std::unordered_map<Key, ExprNode*, KeyHash> nodes_;
+  std::unordered_set<const ExprNode*> interned_;  // The values of nodes_.
+  size_t hits_;
+};
+
+#endif  // DECAFPARSER_HASH_CONS_H
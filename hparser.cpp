@@ -0,0 +1,772 @@
+
+#include "hparser.h"
+
+using namespace std;
+
+int HParser::parse() {
+  try {
+    set_AST(program());
+  } catch (const SyntaxError&) {
+    // An error in the class head or after the last method; there is nothing
+    // left to recover.
+  }
+  return errors_ == 0 ? 0 : 1;
+}
+
+void HParser::produce() {
+  Token token;
+  bool end;
+  do {
+    scan(token);
+    end = (token.type == decaf::token_type::EOI);
+    while (!ring_->try_push(token)) {
+      if (stop_) {
+        return;  // The parser is gone and will take no more tokens.
+      }
+      std::this_thread::yield();
+    }
+  } while (!end);
+}
+
+ProgramNode* HParser::parse_class_head() {
+  string name;
+  list<VariableDeclarationNode*>* list_vdn = nullptr;
+  try {
+    match(decaf::token_type::kwClass);
+    name = token_.lexeme;
+    match(decaf::token_type::Identifier);
+    match(decaf::token_type::ptLBrace);
+    list_vdn = field_declarations();
+    match(decaf::token_type::kwStatic);
+    match(decaf::token_type::EOI);
+  } catch (const SyntaxError&) {
+    if (list_vdn == nullptr) {
+      list_vdn = new list<VariableDeclarationNode*>();
+    }
+  }
+  return new ProgramNode(name, list_vdn, new list<MethodNode*>());
+}
+
+list<MethodNode*>* HParser::parse_methods() {
+  list<MethodNode*>* list_mdn = new list<MethodNode*>();
+  while (token_.type == decaf::token_type::kwStatic) {
+    try {
+      list_mdn->push_back(located(&HParser::method_declaration));
+    } catch (const SyntaxError&) {
+      skip_method();
+    }
+    end_method();
+  }
+  try {
+    match(decaf::token_type::EOI);
+  } catch (const SyntaxError&) {
+  }
+  return list_mdn;
+}
+
+ProgramNode* HParser::program() {
+  match(decaf::token_type::kwClass);
+  string name = token_.lexeme;
+  match(decaf::token_type::Identifier);
+  match(decaf::token_type::ptLBrace);
+  auto list_vdn = field_declarations();
+  auto list_mdn = method_declarations();
+  match(decaf::token_type::ptRBrace);
+  match(decaf::token_type::EOI);
+  return new ProgramNode(name, list_vdn, list_mdn);
+}
+
+// The variables and constants of the class. A constant is told from a method,
+// which starts with "static" too, by the "final" after it.
+list<VariableDeclarationNode*>* HParser::field_declarations() {
+  auto list_vdn = new list<VariableDeclarationNode*>();
+  while (true) {
+    try {
+      if (token_.type == decaf::token_type::kwStatic &&
+          peek().type == decaf::token_type::kwFinal) {
+        list_vdn->push_back(located(&HParser::constant_declaration));
+      } else if (token_.type == decaf::token_type::kwInt ||
+                 token_.type == decaf::token_type::kwReal) {
+        list_vdn->push_back(located(&HParser::variable_declaration));
+      } else {
+        break;
+      }
+    } catch (const SyntaxError&) {
+      skip_declaration();
+    }
+  }
+  return list_vdn;
+}
+
+ConstantDeclarationNode* HParser::constant_declaration() {
+  match(decaf::token_type::kwStatic);
+  match(decaf::token_type::kwFinal);
+  ValueType type = this->type();
+  VariableExprNode* var = variable();
+  match(decaf::token_type::OpAssign);
+  auto value = number(token_.lexeme, token_.line, token_.col);
+  match(decaf::token_type::Number);
+  match(decaf::token_type::ptSemicolon);
+  return new ConstantDeclarationNode(type, var, value);
+}
+
+list<VariableDeclarationNode*>* HParser::variable_declarations() {
+  auto list_vdn = new list<VariableDeclarationNode*>();
+  while (token_.type == decaf::token_type::kwInt ||
+         token_.type == decaf::token_type::kwReal) {
+    try {
+      list_vdn->push_back(located(&HParser::variable_declaration));
+    } catch (const SyntaxError&) {
+      skip_declaration();
+    }
+  }
+  return list_vdn;
+}
+
+// A list of variables, or one array, whose size is a number or a constant.
+VariableDeclarationNode* HParser::variable_declaration() {
+  ValueType type = this->type();
+  if (token_.type == decaf::token_type::Identifier &&
+      peek().type == decaf::token_type::ptLBracket) {
+    VariableExprNode* var = variable();
+    match(decaf::token_type::ptLBracket);
+    ExprNode* size = nullptr;
+    if (token_.type == decaf::token_type::Number) {
+      size = number(token_.lexeme, token_.line, token_.col);
+      match(decaf::token_type::Number);
+    } else {
+      size = variable();
+    }
+    match(decaf::token_type::ptRBracket);
+    match(decaf::token_type::ptSemicolon);
+    return new ArrayDeclarationNode(type, var, size);
+  }
+  auto list_v = variable_list();
+  return new VariableDeclarationNode(type, list_v);
+}
+
+ValueType HParser::type() {
+  ValueType valuetype = ValueType::VoidVal;
+  if (token_.type == decaf::token_type::kwInt) {
+    match(decaf::token_type::kwInt);
+    valuetype = ValueType::IntVal;
+  } else if (token_.type == decaf::token_type::kwReal) {
+    match(decaf::token_type::kwReal);
+    valuetype = ValueType::RealVal;
+  } else {
+    error(decaf::token_type::kwInt);
+  }
+  return valuetype;
+}
+
+list<VariableExprNode*>* HParser::variable_list() {
+  auto list_v = new list<VariableExprNode*>();
+  list_v->push_back(variable());
+  while (token_.type == decaf::token_type::ptComma) {
+    match(decaf::token_type::ptComma);
+    list_v->push_back(variable());
+  }
+  match(decaf::token_type::ptSemicolon);
+  return list_v;
+}
+
+VariableExprNode* HParser::variable() {
+  auto node = new VariableExprNode(token_.lexeme);
+  match(decaf::token_type::Identifier);
+  return node;
+}
+
+list<MethodNode*>* HParser::method_declarations() {
+  list<MethodNode*>* list_mdn = new list<MethodNode*>();
+  do {
+    try {
+      list_mdn->push_back(located(&HParser::method_declaration));
+    } catch (const SyntaxError&) {
+      skip_method();
+    }
+    end_method();
+  } while (token_.type == decaf::token_type::kwStatic);
+  return list_mdn;
+}
+
+MethodNode* HParser::method_declaration() {
+  match(decaf::token_type::kwStatic);
+  auto type = method_return_type();
+  string method_name = token_.lexeme;
+  match(decaf::token_type::Identifier);
+  match(decaf::token_type::ptLParen);
+  auto params = parameters();
+  match(decaf::token_type::ptRParen);
+  match(decaf::token_type::ptLBrace);
+  auto list_vdn = variable_declarations();
+  auto list_stm = statement_list();
+  match(decaf::token_type::ptRBrace);
+  return new MethodNode(type, method_name, params, list_vdn, list_stm);
+}
+
+ValueType HParser::method_return_type() {
+  if (token_.type == decaf::token_type::kwVoid) {
+    match(decaf::token_type::kwVoid);
+    return ValueType::VoidVal;
+  }
+  return type();
+}
+
+list<ParameterNode*>* HParser::parameters() {
+  if (token_.type == decaf::token_type::kwInt ||
+      token_.type == decaf::token_type::kwReal) {
+    return parameter_list();
+  }
+  return new list<ParameterNode*>();
+}
+
+list<ParameterNode*>* HParser::parameter_list() {
+  auto param_list = new list<ParameterNode*>();
+  ValueType param_type = type();
+  param_list->push_back(new ParameterNode(param_type, variable()));
+  while (token_.type == decaf::token_type::ptComma) {
+    match(decaf::token_type::ptComma);
+    param_type = type();
+    param_list->push_back(new ParameterNode(param_type, variable()));
+  }
+  return param_list;
+}
+
+list<StmNode*>* HParser::statement_list() {
+  auto stm_list = new list<StmNode*>();
+  // A statement list always ends the block; anything else that is not a
+  // statement is reported by statement().
+  while (token_.type != decaf::token_type::ptRBrace &&
+         token_.type != decaf::token_type::kwStatic &&
+         token_.type != decaf::token_type::EOI) {
+    parens_ = 0;
+    try {
+      stm_list->push_back(located(&HParser::statement));
+    } catch (const SyntaxError&) {
+      skip_statement();
+    }
+  }
+  return stm_list;
+}
+
+StmNode* HParser::statement() {
+  switch (token_.type) {
+    case (decaf::token_type::kwIf): {
+      match(decaf::token_type::kwIf);
+      match(decaf::token_type::ptLParen);
+      ExprNode* expr = expr_or();
+      match(decaf::token_type::ptRParen);
+      BlockStmNode* stm_if = statement_block();
+      BlockStmNode* stm_else = nullptr;
+      // optional_else added here:
+      if (token_.type == decaf::token_type::kwElse) {
+        match(decaf::token_type::kwElse);
+        stm_else = statement_block();
+      }
+      return new IfStmNode(expr, stm_if, stm_else);
+    }
+    case (decaf::token_type::kwFor): {
+      match(decaf::token_type::kwFor);
+      match(decaf::token_type::ptLParen);
+      VariableExprNode* var_new = variable();
+      match(decaf::token_type::OpAssign);
+      ExprNode* value = expr_or();
+      match(decaf::token_type::ptSemicolon);
+      ExprNode* condition = expr_or();
+      match(decaf::token_type::ptSemicolon);
+      VariableExprNode* var2 = variable();
+      IncrDecrStmNode* incr_decr = nullptr;
+      if (token_.type == decaf::token_type::OpArtInc) {
+        match(decaf::token_type::OpArtInc);
+        incr_decr = new IncrStmNode(var2);
+      } else if (token_.type == decaf::token_type::OpArtDec) {
+        match(decaf::token_type::OpArtDec);
+        incr_decr = new DecrStmNode(var2);
+      } else {
+        error(decaf::token_type::OpArtInc);
+      }
+      match(decaf::token_type::ptRParen);
+      BlockStmNode* block = statement_block();
+      return new ForStmNode(new AssignStmNode(var_new, value), condition,
+                            incr_decr, block);
+    }
+    case (decaf::token_type::kwReturn): {
+      match(decaf::token_type::kwReturn);
+      // optional_expr handeled here
+      ExprNode* opt_expr = nullptr;
+      if (token_.type != decaf::token_type::ptSemicolon) {
+        opt_expr = expr_or();
+      }
+      match(decaf::token_type::ptSemicolon);
+      return new ReturnStmNode(opt_expr);
+    }
+    case (decaf::token_type::kwBreak): {
+      match(decaf::token_type::kwBreak);
+      match(decaf::token_type::ptSemicolon);
+      return new BreakStmNode();
+    }
+    case (decaf::token_type::kwContinue): {
+      match(decaf::token_type::kwContinue);
+      match(decaf::token_type::ptSemicolon);
+      return new ContinueStmNode();
+    }
+    case (decaf::token_type::ptLBrace): {
+      return statement_block();
+    }
+    case (decaf::token_type::Identifier): {
+      return id_start_stm();
+    }
+    default:
+      error(decaf::token_type::Identifier);
+  }
+  return nullptr;
+}
+
+StmNode* HParser::id_start_stm() {
+  string id = token_.lexeme;
+  match(decaf::token_type::Identifier);
+  switch (token_.type) {
+    case decaf::token_type::ptLParen: {
+      match(decaf::token_type::ptLParen);
+      auto ex_list = expr_list();
+      match(decaf::token_type::ptRParen);
+      match(decaf::token_type::ptSemicolon);
+      return new MethodCallExprStmNode(id, ex_list);
+    }
+    case decaf::token_type::OpAssign: {
+      match(decaf::token_type::OpAssign);
+      auto expr = expr_or();
+      match(decaf::token_type::ptSemicolon);
+      return new AssignStmNode(new VariableExprNode(id), expr);
+    }
+    case decaf::token_type::ptLBracket: {
+      match(decaf::token_type::ptLBracket);
+      auto index = expr_or();
+      match(decaf::token_type::ptRBracket);
+      match(decaf::token_type::OpAssign);
+      auto expr = expr_or();
+      match(decaf::token_type::ptSemicolon);
+      return new IndexAssignStmNode(
+          new IndexExprNode(new VariableExprNode(id), index), expr);
+    }
+    case decaf::token_type::OpArtInc: {
+      match(decaf::token_type::OpArtInc);
+      match(decaf::token_type::ptSemicolon);
+      return new IncrStmNode(new VariableExprNode(id));
+    }
+    case decaf::token_type::OpArtDec: {
+      match(decaf::token_type::OpArtDec);
+      match(decaf::token_type::ptSemicolon);
+      return new DecrStmNode(new VariableExprNode(id));
+    }
+    default:
+      error(decaf::token_type::ptLParen);
+  }
+  return nullptr;
+}
+
+BlockStmNode* HParser::statement_block() {
+  match(decaf::token_type::ptLBrace);
+  auto stm_list = ensure_stack([this]() { return statement_list(); });
+  match(decaf::token_type::ptRBrace);
+  return new BlockStmNode(stm_list);
+}
+
+// Panic mode: skip up to and including the ';' that ends the statement, or
+// the '}' of a block it opened, or up to the next statement keyword or the
+// end of the enclosing block. A ';' inside parentheses, as in the head of a
+// for loop, does not end the statement.
+void HParser::skip_statement() {
+  int depth = 0;
+  int parens = parens_;
+  while (token_.type != decaf::token_type::EOI &&
+         token_.type != decaf::token_type::kwStatic) {
+    switch (token_.type) {
+      case decaf::token_type::ptLBrace:
+        ++depth;
+        break;
+      case decaf::token_type::ptRBrace:
+        if (depth == 0) {
+          return;
+        }
+        if (--depth == 0) {
+          last_line_ = token_.line;
+          advance();
+          return;
+        }
+        break;
+      case decaf::token_type::ptLParen:
+        ++parens;
+        break;
+      case decaf::token_type::ptRParen:
+        if (parens > 0) {
+          --parens;
+        }
+        break;
+      case decaf::token_type::ptSemicolon:
+        if (depth == 0 && parens == 0) {
+          last_line_ = token_.line;
+          advance();
+          return;
+        }
+        break;
+      case decaf::token_type::kwIf:
+      case decaf::token_type::kwFor:
+      case decaf::token_type::kwReturn:
+      case decaf::token_type::kwBreak:
+      case decaf::token_type::kwContinue:
+        if (depth == 0) {
+          return;
+        }
+        break;
+      default:
+        break;
+    }
+    last_line_ = token_.line;
+    advance();
+  }
+}
+
+// Skip up to and including the ';' that ends the declaration, or up to
+// whatever follows the declarations.
+void HParser::skip_declaration() {
+  while (token_.type != decaf::token_type::EOI &&
+         token_.type != decaf::token_type::kwStatic &&
+         token_.type != decaf::token_type::kwInt &&
+         token_.type != decaf::token_type::kwReal &&
+         token_.type != decaf::token_type::ptLBrace &&
+         token_.type != decaf::token_type::ptRBrace) {
+    bool end = (token_.type == decaf::token_type::ptSemicolon);
+    last_line_ = token_.line;
+    advance();
+    if (end) {
+      return;
+    }
+  }
+}
+
+// Skip up to the next method, or past the body of this one if the error came
+// before it.
+void HParser::skip_method() {
+  int depth = 0;
+  while (token_.type != decaf::token_type::EOI &&
+         token_.type != decaf::token_type::kwStatic) {
+    if (token_.type == decaf::token_type::ptLBrace) {
+      ++depth;
+    } else if (token_.type == decaf::token_type::ptRBrace) {
+      if (depth == 0) {
+        return;
+      }
+      if (--depth == 0) {
+        last_line_ = token_.line;
+        advance();
+        return;
+      }
+    }
+    last_line_ = token_.line;
+    advance();
+  }
+}
+
+// expr_list and more_expressions are in the same method.
+list<ExprNode*>* HParser::expr_list() {
+  list<ExprNode*>* expr_list = new list<ExprNode*>();
+  if (token_.type != decaf::token_type::Number &&
+      token_.type != decaf::token_type::ptLParen &&
+      token_.type != decaf::token_type::Identifier &&
+      token_.type != decaf::token_type::OpArtPlus &&
+      token_.type != decaf::token_type::OpArtMinus &&
+      token_.type != decaf::token_type::OpLogNot &&
+      token_.type != decaf::token_type::OpBitNot) {
+    return expr_list;
+  }
+  expr_list->push_front(expr_or());
+  while (token_.type == decaf::token_type::ptComma) {
+    match(decaf::token_type::ptComma);
+    expr_list->push_back(expr_or());
+  }
+  return expr_list;
+}
+
+ExprNode* HParser::expr_or() {
+  ExprNode* lhs = expr_and();
+  return expr_or_(lhs);
+}
+
+ExprNode* HParser::expr_or_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpLogOr) {
+      match(decaf::token_type::OpLogOr);
+      ExprNode* rhs = expr_and();
+      lhs = intern(new OrExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_and() {
+  ExprNode* lhs = expr_bit_or();
+  return expr_and_(lhs);
+}
+
+ExprNode* HParser::expr_and_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpLogAnd) {
+      match(decaf::token_type::OpLogAnd);
+      ExprNode* rhs = expr_bit_or();
+      lhs = intern(new AndExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_bit_or() {
+  ExprNode* lhs = expr_bit_xor();
+  return expr_bit_or_(lhs);
+}
+
+ExprNode* HParser::expr_bit_or_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpBitOr) {
+      match(decaf::token_type::OpBitOr);
+      ExprNode* rhs = expr_bit_xor();
+      lhs = intern(new BitOrExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_bit_xor() {
+  ExprNode* lhs = expr_bit_and();
+  return expr_bit_xor_(lhs);
+}
+
+ExprNode* HParser::expr_bit_xor_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpBitXor) {
+      match(decaf::token_type::OpBitXor);
+      ExprNode* rhs = expr_bit_and();
+      lhs = intern(new BitXorExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_bit_and() {
+  ExprNode* lhs = expr_eq();
+  return expr_bit_and_(lhs);
+}
+
+ExprNode* HParser::expr_bit_and_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpBitAnd) {
+      match(decaf::token_type::OpBitAnd);
+      ExprNode* rhs = expr_eq();
+      lhs = intern(new BitAndExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_eq() {
+  ExprNode* lhs = expr_rel();
+  return expr_eq_(lhs);
+}
+
+ExprNode* HParser::expr_eq_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpRelEQ) {
+      match(decaf::token_type::OpRelEQ);
+      ExprNode* rhs = expr_rel();
+      lhs = intern(new EqExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpRelNEQ) {
+      match(decaf::token_type::OpRelNEQ);
+      ExprNode* rhs = expr_rel();
+      lhs = intern(new NeqExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_rel() {
+  ExprNode* lhs = expr_shift();
+  return expr_rel_(lhs);
+}
+
+ExprNode* HParser::expr_rel_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpRelLT) {
+      match(decaf::token_type::OpRelLT);
+      ExprNode* rhs = expr_shift();
+      lhs = intern(new LtExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpRelLTE) {
+      match(decaf::token_type::OpRelLTE);
+      ExprNode* rhs = expr_shift();
+      lhs = intern(new LteExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpRelGT) {
+      match(decaf::token_type::OpRelGT);
+      ExprNode* rhs = expr_shift();
+      lhs = intern(new GtExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpRelGTE) {
+      match(decaf::token_type::OpRelGTE);
+      ExprNode* rhs = expr_shift();
+      lhs = intern(new GteExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_shift() {
+  ExprNode* lhs = expr_add();
+  return expr_shift_(lhs);
+}
+
+ExprNode* HParser::expr_shift_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpShiftLeft) {
+      match(decaf::token_type::OpShiftLeft);
+      ExprNode* rhs = expr_add();
+      lhs = intern(new ShiftLeftExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpShiftRight) {
+      match(decaf::token_type::OpShiftRight);
+      ExprNode* rhs = expr_add();
+      lhs = intern(new ShiftRightExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_add() {
+  ExprNode* lhs = expr_mult();
+  return expr_add_(lhs);
+}
+
+ExprNode* HParser::expr_add_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpArtPlus) {
+      match(decaf::token_type::OpArtPlus);
+      ExprNode* rhs = expr_mult();
+      lhs = intern(new PlusExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpArtMinus) {
+      match(decaf::token_type::OpArtMinus);
+      ExprNode* rhs = expr_mult();
+      lhs = intern(new MinusExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_mult() {
+  ExprNode* lhs = expr_unary();
+  return expr_mult_(lhs);
+}
+
+ExprNode* HParser::expr_mult_(ExprNode* lhs) {
+  while (true) {
+    if (token_.type == decaf::token_type::OpArtMult) {
+      match(decaf::token_type::OpArtMult);
+      ExprNode* rhs = expr_unary();
+      lhs = intern(new MultiplyExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpArtDiv) {
+      match(decaf::token_type::OpArtDiv);
+      ExprNode* rhs = expr_unary();
+      lhs = intern(new DivideExprNode(lhs, rhs));
+      continue;
+    }
+    if (token_.type == decaf::token_type::OpArtModulus) {
+      match(decaf::token_type::OpArtModulus);
+      ExprNode* rhs = expr_unary();
+      lhs = intern(new ModulusExprNode(lhs, rhs));
+      continue;
+    }
+    break;
+  }
+  return lhs;
+}
+
+ExprNode* HParser::expr_unary() {
+  if (token_.type == decaf::token_type::OpArtPlus) {
+    match(decaf::token_type::OpArtPlus);
+    ExprNode* operand = ensure_stack([this]() { return expr_unary(); });
+    return intern(new PlusExprNode(operand));
+  }
+  if (token_.type == decaf::token_type::OpArtMinus) {
+    match(decaf::token_type::OpArtMinus);
+    ExprNode* operand = ensure_stack([this]() { return expr_unary(); });
+    return intern(new MinusExprNode(operand));
+  }
+  if (token_.type == decaf::token_type::OpLogNot) {
+    match(decaf::token_type::OpLogNot);
+    ExprNode* operand = ensure_stack([this]() { return expr_unary(); });
+    return intern(new NotExprNode(operand));
+  }
+  if (token_.type == decaf::token_type::OpBitNot) {
+    match(decaf::token_type::OpBitNot);
+    ExprNode* operand = ensure_stack([this]() { return expr_unary(); });
+    return intern(new ComplementExprNode(operand));
+  }
+  return factor();
+}
+
+ExprNode* HParser::factor() {
+  if (token_.type == decaf::token_type::Number) {
+    ExprNode* node = intern(number(token_.lexeme, token_.line, token_.col));
+    match(decaf::token_type::Number);
+    return node;
+  }
+  if (token_.type == decaf::token_type::ptLParen) {
+    match(decaf::token_type::ptLParen);
+    ExprNode* node = ensure_stack([this]() { return expr_or(); });
+    match(decaf::token_type::ptRParen);
+    return node;
+  }
+  string var_name = token_.lexeme;
+  match(decaf::token_type::Identifier);
+  if (token_.type == decaf::token_type::ptLParen) {
+    match(decaf::token_type::ptLParen);
+    list<ExprNode*>* expr_l = ensure_stack([this]() { return expr_list(); });
+    match(decaf::token_type::ptRParen);
+    return new MethodCallExprStmNode(var_name, expr_l);
+  }
+  // An element is not interned: its value changes with stores to the array.
+  if (token_.type == decaf::token_type::ptLBracket) {
+    match(decaf::token_type::ptLBracket);
+    ExprNode* index = ensure_stack([this]() { return expr_or(); });
+    match(decaf::token_type::ptRBracket);
+    return new IndexExprNode(new VariableExprNode(var_name), index);
+  }
+  return intern(new VariableExprNode(var_name));
+}
+
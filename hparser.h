@@ -0,0 +1,316 @@
+
+#ifndef DECAFPARSER_HPARSER_H
+#define DECAFPARSER_HPARSER_H
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+#include <utility>
+#include "parser.h"
+#include "spsc_ring.h"
+
+#define OUTPUT_TT(tt) case decaf::token_type::tt: os << #tt; break;
+
+inline std::ostream& operator<<(std::ostream& os, decaf::token_type type) {
+  switch (type) {
+    OUTPUT_TT(Identifier)
+    OUTPUT_TT(Number)
+    OUTPUT_TT(OpRelEQ)
+    OUTPUT_TT(OpRelNEQ)
+    OUTPUT_TT(OpRelLT)
+    OUTPUT_TT(OpRelLTE)
+    OUTPUT_TT(OpRelGT)
+    OUTPUT_TT(OpRelGTE)
+    OUTPUT_TT(OpArtInc)
+    OUTPUT_TT(OpArtDec)
+    OUTPUT_TT(OpArtPlus)
+    OUTPUT_TT(OpArtMinus)
+    OUTPUT_TT(OpArtMult)
+    OUTPUT_TT(OpArtDiv)
+    OUTPUT_TT(OpArtModulus)
+    OUTPUT_TT(OpLogAnd)
+    OUTPUT_TT(OpLogOr)
+    OUTPUT_TT(OpLogNot)
+    OUTPUT_TT(OpBitAnd)
+    OUTPUT_TT(OpBitOr)
+    OUTPUT_TT(OpBitXor)
+    OUTPUT_TT(OpBitNot)
+    OUTPUT_TT(OpShiftLeft)
+    OUTPUT_TT(OpShiftRight)
+    OUTPUT_TT(OpAssign)
+    OUTPUT_TT(kwClass)
+    OUTPUT_TT(kwStatic)
+    OUTPUT_TT(kwFinal)
+    OUTPUT_TT(kwVoid)
+    OUTPUT_TT(kwIf)
+    OUTPUT_TT(kwElse)
+    OUTPUT_TT(kwFor)
+    OUTPUT_TT(kwReturn)
+    OUTPUT_TT(kwBreak)
+    OUTPUT_TT(kwContinue)
+    OUTPUT_TT(kwInt)
+    OUTPUT_TT(kwReal)
+    OUTPUT_TT(ptLBrace)
+    OUTPUT_TT(ptRBrace)
+    OUTPUT_TT(ptLBracket)
+    OUTPUT_TT(ptRBracket)
+    OUTPUT_TT(ptLParen)
+    OUTPUT_TT(ptRParen)
+    OUTPUT_TT(ptSemicolon)
+    OUTPUT_TT(ptComma)
+    OUTPUT_TT(EOI)
+    OUTPUT_TT(ErrUnknown)
+  }
+  return os;
+}
+
+class HParser : public Parser {
+ private:
+  struct Token {
+    yy::parser_decaf::token_type type;  // Type of the token.
+    std::string lexeme;                 // Matched lexeme.
+    int line;                           // Line number in file where token is.
+    int col;                            // Column number in file where token is.
+  };
+
+  Token token_;
+  Token next_;      // The token after token_, if it was peeked at.
+  bool has_next_;
+  int last_line_;  // Line of the last token matched.
+  int parens_;     // '(' matched in this statement and not closed yet.
+
+  // Thrown after a syntax error is reported, to unwind to the nearest
+  // statement, declaration or method, where parsing picks up again.
+  struct SyntaxError {};
+
+  // When pipelined, the scanner runs on lexer_thread_ and hands the tokens
+  // over through ring_.
+  std::unique_ptr<SpscRing<Token>> ring_;
+  std::thread lexer_thread_;
+  std::atomic<bool> stop_;  // Set to make the lexer thread give up.
+  bool lexed_all_;          // The consumer has taken EOI off the ring.
+
+  void get_next(Token& token) {
+    if (ring_) {
+      if (!lexed_all_) {
+        while (!ring_->try_pop(token)) {
+          std::this_thread::yield();
+        }
+        lexed_all_ = (token.type == decaf::token_type::EOI);
+      }
+      return;
+    }
+    scan(token);
+  }
+
+  // Move on to the next token.
+  void advance() {
+    if (has_next_) {
+      std::swap(token_, next_);
+      has_next_ = false;
+    } else {
+      get_next(token_);
+    }
+  }
+
+  // The token after token_, read ahead of time.
+  const Token& peek() {
+    if (!has_next_) {
+      get_next(next_);
+      has_next_ = true;
+    }
+    return next_;
+  }
+
+  // The lexer thread's loop.
+  void produce();
+
+  void scan(Token& token) {
+    yy::parser_decaf::symbol_type st(yylex(scanner_));
+    token.type = st.token();
+    if (token.type == yy::parser_decaf::token_type::Identifier ||
+        token.type == yy::parser_decaf::token_type::Number ||
+        token.type == yy::parser_decaf::token_type::ErrUnknown) {
+      token.lexeme = st.value.as<std::string>();
+    } else {
+      token.lexeme.clear();
+    }
+    token.line = st.location.begin.line;
+    token.col = st.location.begin.column;
+  }
+
+  void report(decaf::token_type type_expected) {
+    *out_ << "Syntax error (line " << token_.line << ", col " << token_.col
+          << "): expected token " << type_expected << ", but got token "
+          << token_.type << " (" << token_.lexeme << ")." << std::endl;
+    ++errors_;
+  }
+
+  void error(decaf::token_type type_expected) {
+    report(type_expected);
+    throw SyntaxError();
+  }
+
+  void match(decaf::token_type type) {
+    if (token_.type == type) {
+      if (type == decaf::token_type::ptLParen) {
+        ++parens_;
+      } else if (type == decaf::token_type::ptRParen && parens_ > 0) {
+        --parens_;
+      }
+      last_line_ = token_.line;
+      advance();
+    } else if (type == decaf::token_type::ptSemicolon && semicolon_missing()) {
+      report(type);  // Carry on as if it were there.
+    } else {
+      error(type);
+    }
+  }
+
+  // Parse a statement, declaration or method with 'parse', and give it the
+  // location of its first token.
+  template <typename T>
+  T* located(T* (HParser::*parse)()) {
+    SourceLocation location(token_.line, token_.col);
+    T* node = (this->*parse)();
+    node->set_location(location);
+    return node;
+  }
+
+  // A ';' is taken to be left out if what follows starts a new line, a new
+  // statement or declaration, or closes the block.
+  bool semicolon_missing() const {
+    switch (token_.type) {
+      case decaf::token_type::ptRBrace:
+      case decaf::token_type::kwIf:
+      case decaf::token_type::kwFor:
+      case decaf::token_type::kwReturn:
+      case decaf::token_type::kwBreak:
+      case decaf::token_type::kwContinue:
+      case decaf::token_type::kwInt:
+      case decaf::token_type::kwReal:
+      case decaf::token_type::kwStatic:
+        return true;
+      default:
+        return token_.line > last_line_ &&
+               token_.type != decaf::token_type::EOI;
+    }
+  }
+
+ public:
+  // If 'pipelined', the input is scanned on a thread of its own while it is
+  // being parsed.
+  HParser(FILE* file, bool debug_lexer, bool debug_parser,
+          bool pipelined = false)
+      : Parser(file, debug_lexer, debug_parser),
+        has_next_(false),
+        last_line_(0),
+        parens_(0),
+        stop_(false),
+        lexed_all_(false) {
+    if (pipelined) {
+      ring_.reset(new SpscRing<Token>(1024));
+      lexer_thread_ = std::thread(&HParser::produce, this);
+    }
+    get_next(token_);
+  }
+
+  HParser(const char* bytes, size_t len, int line, int col, bool debug_lexer,
+          bool debug_parser)
+      : Parser(bytes, len, line, col, debug_lexer, debug_parser),
+        has_next_(false),
+        last_line_(line),
+        parens_(0),
+        stop_(false),
+        lexed_all_(false) {
+    get_next(token_);
+  }
+
+  virtual ~HParser() {
+    if (ring_) {
+      stop_ = true;
+      lexer_thread_.join();
+    }
+  }
+
+  // Parse the input, recovering from syntax errors so that all of them are
+  // reported. Returns 0 if there were none, 1 otherwise.
+  virtual int parse() override;
+
+  // Parse the input as the head of a class, "class Id { field_declarations",
+  // followed by the "static" of the first method and the end of input. The
+  // methods of the returned program are left empty.
+  ProgramNode* parse_class_head();
+
+  // Parse the input as a sequence of method declarations up to the end of input.
+  std::list<MethodNode*>* parse_methods();
+
+  virtual std::string get_name() const override { return "Handmade"; }
+
+ private:
+  // Add your private functions and variables here below ...
+  ProgramNode* program();
+  std::list<VariableDeclarationNode*>* field_declarations();
+  ConstantDeclarationNode* constant_declaration();
+  std::list<VariableDeclarationNode*>* variable_declarations();
+  VariableDeclarationNode* variable_declaration();
+  std::list<VariableExprNode*>* variable_list();
+  VariableExprNode* variable();
+  ValueType type();
+
+  std::list<MethodNode*>* method_declarations();
+  MethodNode* method_declaration();
+  ValueType method_return_type();
+
+  std::list<ParameterNode*>* parameters();
+  std::list<ParameterNode*>* parameter_list();
+
+  std::list<StmNode*>* statement_list();
+  StmNode* statement();
+  StmNode* id_start_stm();
+
+  BlockStmNode* statement_block();
+
+  // Skip the rest of a statement, declaration or method after a syntax error.
+  void skip_statement();
+  void skip_declaration();
+  void skip_method();
+
+  std::list<ExprNode*>* expr_list();
+
+  ExprNode* expr_or();
+  ExprNode* expr_or_(ExprNode* lhs);
+
+  ExprNode* expr_and();
+  ExprNode* expr_and_(ExprNode* lhs);
+
+  ExprNode* expr_bit_or();
+  ExprNode* expr_bit_or_(ExprNode* lhs);
+
+  ExprNode* expr_bit_xor();
+  ExprNode* expr_bit_xor_(ExprNode* lhs);
+
+  ExprNode* expr_bit_and();
+  ExprNode* expr_bit_and_(ExprNode* lhs);
+
+  ExprNode* expr_eq();
+  ExprNode* expr_eq_(ExprNode* lhs);
+
+  ExprNode* expr_rel();
+  ExprNode* expr_rel_(ExprNode* lhs);
+
+  ExprNode* expr_shift();
+  ExprNode* expr_shift_(ExprNode* lhs);
+
+  ExprNode* expr_add();
+  ExprNode* expr_add_(ExprNode* lhs);
+
+  ExprNode* expr_mult();
+  ExprNode* expr_mult_(ExprNode* lhs);
+
+  ExprNode* expr_unary();
+
+  ExprNode* factor();
+};
+#endif  // DECAFPARSER_HPARSER_H
@@ -0,0 +1,250 @@
+#include "iparser.h"
+#include <algorithm>
+#include <sstream>
+#include <unordered_set>
+#include "ast_visitor.h"
+#include "hparser.h"
+
+using namespace std;
+
+namespace {
+
+// Frees a subtree of the AST that is no longer used: each of its nodes once,
+// even if it is shared, and the lists that hold the children. The nodes are
+// deleted when the deleter goes out of scope.
+class AstDeleter : public AstVisitor<AstDeleter> {
+ public:
+  ~AstDeleter() {
+    for (auto node : nodes_) {
+      delete node;
+    }
+  }
+
+  template <typename T>
+  void free(const T* node) {
+    if (node != nullptr && seen_.insert(node).second) {
+      nodes_.push_back(node);
+      ensure_stack([&]() { visit(node); });
+    }
+  }
+
+  template <typename T>
+  void free_list(const list<T*>* nodes) {
+    if (nodes != nullptr) {
+      for (auto node : *nodes) {
+        free(node);
+      }
+      delete nodes;
+    }
+  }
+
+  void visit_and(const AndExprNode* node) {
+    free(node->get_lhs());
+    free(node->get_rhs());
+  }
+
+  void visit_or(const OrExprNode* node) {
+    free(node->get_lhs());
+    free(node->get_rhs());
+  }
+
+  void visit_not(const NotExprNode* node) { free(node->get_rhs()); }
+
+  void visit_relational(const RelationalExprNode* node) {
+    free(node->get_lhs());
+    free(node->get_rhs());
+  }
+
+  void visit_arithmetic(const ArithmeticExprNode* node) {
+    free(node->get_lhs());
+    free(node->get_rhs());
+  }
+
+  void visit_bitwise(const BitwiseExprNode* node) {
+    free(node->get_lhs());
+    free(node->get_rhs());
+  }
+
+  void visit_complement(const ComplementExprNode* node) {
+    free(node->get_rhs());
+  }
+
+  void visit_method_call(const MethodCallExprStmNode* node) {
+    free_list(node->get_args());
+  }
+
+  void visit_index(const IndexExprNode* node) {
+    free(node->get_array());
+    free(node->get_index());
+  }
+
+  void visit_variable_declaration(const VariableDeclarationNode* node) {
+    free_list(node->get_vars());
+  }
+
+  void visit_constant_declaration(const ConstantDeclarationNode* node) {
+    visit_variable_declaration(node);
+    free(node->get_value());
+  }
+
+  void visit_array_declaration(const ArrayDeclarationNode* node) {
+    visit_variable_declaration(node);
+    free(node->get_size());
+  }
+
+  void visit_parameter(const ParameterNode* node) { free(node->get_var()); }
+
+  void visit_assign(const AssignStmNode* node) {
+    free(node->get_var());
+    free(node->get_expr());
+  }
+
+  void visit_index_assign(const IndexAssignStmNode* node) {
+    free(node->get_element());
+    free(node->get_expr());
+  }
+
+  void visit_incr(const IncrStmNode* node) { free(node->get_var()); }
+
+  void visit_decr(const DecrStmNode* node) { free(node->get_var()); }
+
+  void visit_return(const ReturnStmNode* node) { free(node->get_expr()); }
+
+  void visit_block(const BlockStmNode* node) { free_list(node->get_stms()); }
+
+  void visit_if(const IfStmNode* node) {
+    free(node->get_expr());
+    free(node->get_if());
+    free(node->get_else());
+  }
+
+  void visit_for(const ForStmNode* node) {
+    free(node->get_assign());
+    free(node->get_expr());
+    free(node->get_incr_decr());
+    free(node->get_block());
+  }
+
+  void visit_method(const MethodNode* node) {
+    free_list(node->get_params());
+    free_list(node->get_var_decls());
+    free_list(node->get_stms());
+  }
+
+  void visit_program(const ProgramNode* node) {
+    free_list(node->get_var_decls());
+    free_list(node->get_method_decls());
+  }
+
+ private:
+  unordered_set<const void*> seen_;
+  vector<const Node*> nodes_;
+};
+
+}  // namespace
+
+int IParser::parse() {
+  if (file_ != nullptr) {
+    source_ = read_source(file_);
+  }
+  parse_all();
+  return errors_ == 0 ? 0 : 1;
+}
+
+void IParser::parse_all() {
+  {
+    AstDeleter deleter;
+    deleter.free(get_AST());
+  }
+  set_AST(nullptr);
+  spans_.clear();
+  methods_.clear();
+  Prescan scan = prescan(source_);
+  if (!scan.ok) {
+    HParser parser(source_.data(), source_.size(), 1, 1, debug_lexer_,
+                   debug_parser_);
+    parser.set_output(*out_);
+    parser.parse();
+    set_AST(parser.get_AST());
+    errors_ = parser.error_count();
+    return;
+  }
+  ProgramNode* program =
+      parse_prescanned(source_, scan, debug_lexer_, debug_parser_, *out_,
+                       errors_);
+  spans_ = scan.methods;
+  list<MethodNode*>* methods = program->get_method_decls();
+  for (auto it = methods->begin(); it != methods->end(); ++it) {
+    methods_.push_back(it);
+  }
+  set_AST(program);
+}
+
+bool IParser::edit(size_t offset, size_t removed, const string& inserted) {
+  offset = min(offset, source_.size());
+  removed = min(removed, source_.size() - offset);
+
+  // Find the method the edit falls in, if any.
+  auto it = upper_bound(
+      spans_.begin(), spans_.end(), offset,
+      [](size_t off, const Prescan::Span& span) { return off < span.begin; });
+  bool in_method = (it != spans_.begin() && offset < (it - 1)->end &&
+                    offset + removed <= (it - 1)->end);
+
+  int line_delta =
+      static_cast<int>(count(inserted.begin(), inserted.end(), '\n')) -
+      static_cast<int>(count(source_.begin() + offset,
+                             source_.begin() + offset + removed, '\n'));
+  source_.replace(offset, removed, inserted);
+  if (!in_method) {
+    parse_all();
+    return false;
+  }
+
+  size_t k = (it - 1) - spans_.begin();
+  Prescan::Span span = spans_[k];
+  span.end = span.end + inserted.size() - removed;
+
+  // The edited region must still be exactly one method declaration.
+  string region = source_.substr(span.begin, span.end - span.begin);
+  string wrapped = "class C {" + region + "}";
+  Prescan check = prescan(wrapped);
+  if (!check.ok || check.methods.size() != 1 ||
+      check.methods.front().begin != wrapped.size() - region.size() - 1 ||
+      check.methods.front().end != wrapped.size() - 1) {
+    parse_all();
+    return false;
+  }
+
+  // A method with syntax errors is left to parse_all() to report, along with
+  // any in the rest of the source.
+  HParser parser(region.data(), region.size(), span.line, span.col,
+                 debug_lexer_, debug_parser_);
+  ostringstream messages;
+  parser.set_output(messages);
+  list<MethodNode*>* reparsed = parser.parse_methods();
+  if (parser.error_count() > 0 || errors_ > 0 || reparsed->size() != 1) {
+    delete reparsed;
+    parse_all();
+    return false;
+  }
+  {
+    AstDeleter deleter;
+    deleter.free(*methods_[k]);
+  }
+  *methods_[k] = reparsed->front();
+  delete reparsed;
+  spans_[k] = span;
+
+  // Shift the methods that follow the edit.
+  for (size_t m = k + 1; m < spans_.size(); ++m) {
+    spans_[m].begin = spans_[m].begin + inserted.size() - removed;
+    spans_[m].end = spans_[m].end + inserted.size() - removed;
+    spans_[m].line += line_delta;
+    size_t newline = source_.rfind('\n', spans_[m].begin);
+    spans_[m].col = static_cast<int>(
+        newline == string::npos ? spans_[m].begin + 1
+                                : spans_[m].begin - newline);
+  }
+  return true;
+}
@@ -0,0 +1,46 @@
+#ifndef DECAFPARSER_IPARSER_H
+#define DECAFPARSER_IPARSER_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include "parser.h"
+#include "pparser.h"
+
+// Keeps a program's source and syntax tree in step under text edits. An edit
+// that stays inside one method declaration, and leaves it a single method,
+// re-lexes and re-parses only that method; every other MethodNode is reused.
+// Any other edit falls back to parsing the whole source again.
+class IParser : public Parser {
+ public:
+  IParser(FILE* file, bool debug_lexer, bool debug_parser)
+      : Parser(file, debug_lexer, debug_parser) {}
+
+  IParser(const std::string& source, bool debug_lexer, bool debug_parser)
+      : Parser(source.data(), source.size(), 1, 1, debug_lexer, debug_parser),
+        source_(source) {}
+
+  // Parse the whole source. Returns 0 if there were no syntax errors, 1
+  // otherwise.
+  virtual int parse() override;
+
+  virtual std::string get_name() const override { return "Incremental"; }
+
+  // Replace 'removed' bytes at 'offset' of the source with 'inserted' and
+  // bring the syntax tree up to date. Returns true if a single method was
+  // re-parsed, false if the whole source had to be. The nodes that are
+  // replaced, the method's or the whole tree's, are freed.
+  bool edit(size_t offset, size_t removed, const std::string& inserted);
+
+  // Return the current source text.
+  const std::string& get_source() const { return source_; }
+
+ private:
+  void parse_all();
+
+  std::string source_;
+  std::vector<Prescan::Span> spans_;  // Empty if the class could not be split.
+  std::vector<std::list<MethodNode*>::iterator> methods_;  // One per span.
+};
+
+#endif  // DECAFPARSER_IPARSER_H
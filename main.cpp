@@ -1,39 +1,35 @@
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include "ast_cache.h"
 #include "bparser.h"
+#include "dparser.h"
+#include "pparser.h"
 #include "symbol_table.h"
 
 using namespace std;
 
+// Where -c keeps the ASTs of the programs it has parsed.
+const char* AstCacheDir = ".decafcache";
+
 std::string name_without_extension(const std::string& filename) {
   size_t lastdot = filename.find_last_of(".");
   if (lastdot == std::string::npos) return filename;
   return filename.substr(0, lastdot);
 }
 
-void print_indented(const std::string& str, ostream& os) {
-  const int IndentLevel = 3;
-  int indent = 0;
-  for (auto c : str) {
-    if (c == '(') {
-      os << '\n';
-      for (int j = 0; j < indent; ++j) {
-        os << ' ';
-      }
-      indent += IndentLevel;
-    } else if (c == ')') {
-      indent -= IndentLevel;
-    }
-    os << c;
-  }
-  os << std::endl;
-}
-
 int main(int argc, char* argv[]) {
   // Process the command-line arguments, if any.
-  // Usage: program [ option [ filename ] ]  (option -s -a )
+  // Usage: program [ option [ filename ] ]  (option -s -a -p -d -c -h -t -j -l)
   bool output_sym_table = false;
   bool output_ast = false;
+  bool parallel_parse = false;
+  bool direct_tac = false;
+  bool use_cache = false;
+  bool hash_consing = false;
+  bool typed_tac = false;
+  bool parallel_codegen = false;
+  bool located_diagnostics = false;
   if (argc >= 2) {
     if (string(argv[1]) == "-s") {
       output_sym_table = true;
@@ -41,6 +37,27 @@ int main(int argc, char* argv[]) {
     if (string(argv[1]) == "-a") {
       output_ast = true;
     }
+    if (string(argv[1]) == "-p") {
+      parallel_parse = true;
+    }
+    if (string(argv[1]) == "-d") {
+      direct_tac = true;
+    }
+    if (string(argv[1]) == "-c") {
+      use_cache = true;
+    }
+    if (string(argv[1]) == "-h") {
+      hash_consing = true;
+    }
+    if (string(argv[1]) == "-t") {
+      typed_tac = true;
+    }
+    if (string(argv[1]) == "-j") {
+      parallel_codegen = true;
+    }
+    if (string(argv[1]) == "-l") {
+      located_diagnostics = true;
+    }
   }
 
   string filename("test.decaf");
@@ -48,52 +65,134 @@ int main(int argc, char* argv[]) {
     filename = argv[2];
   }
 
-  // Open file with Decaf program, exit if error opening file.
-  FILE* file = fopen(filename.c_str(), "r");
+  // Open file with Decaf program, exit if error opening file. A filename of
+  // "-" reads the program from standard input, parsing it as it arrives.
+  bool from_stdin = (filename == "-");
+  FILE* file = from_stdin ? stdin : fopen(filename.c_str(), "r");
   if (file == nullptr) {
     cerr << "Could not open input file '" << filename << "'." << endl;
     return -1;
   }
 
+  std::string tacfilename =
+      from_stdin ? "stdout" : name_without_extension(filename) + ".tac";
+  // When the code goes to stdout, everything else goes to stderr, so that
+  // stdout can be piped on as TAC.
+  ostream& messages = from_stdin ? cerr : cout;
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  // With -t, the code has int and real instructions, and explicit conversions.
+  tac.set_typed(typed_tac);
+  // With -l, diagnostics are written as "line:col: warning: message [id]".
+  if (located_diagnostics) {
+    data.diagnostics.set_format(Diagnostics::Format::Located);
+  }
+
+  // With -c, a program parsed before is not lexed and parsed again: its AST
+  // is loaded from the cache, keyed by a hash of the source.
+  AstCache cache(AstCacheDir);
+  std::string src;
+  ProgramNode* cached_ast = nullptr;
+  if (use_cache) {
+    src = read_source(file);
+    FlatAst flat;
+    if (cache.load(src, flat)) {
+      cached_ast = unflatten(flat);
+    }
+  }
+
   // Instantiate the parser.
-  Parser* parser =
-      new BParser(file, false, false);  // Change flags to true for debugging.
+  Parser* parser = nullptr;
+  if (cached_ast != nullptr) {
+    // No parser needed.
+  } else if (use_cache) {
+    parser = new BParser(src.data(), src.size(), 1, 1, false, false);
+  } else if (direct_tac) {
+    // Generates the TAC while parsing, without building the AST.
+    parser = new DParser(file, data, tac, false, false);
+  } else if (parallel_parse) {
+    parser = new PParser(file, false, false);
+  } else {
+    parser =
+        new BParser(file, false, false);  // Change flags to true for debugging.
+    // With -h, identical pure expressions in a method share one node.
+    parser->set_hash_consing(hash_consing);
+  }
+  if (parser != nullptr) {
+    parser->set_output(messages);
+  }
 
   // Parse and output the generated abstract syntax tree.
-  cout << "====> PARSING FILE " << filename << " USING PARSER "
-       << parser->get_name() << endl;
-  parser->parse();
-  Node* ast = parser->get_AST();
+  int res = 0;
+  Node* ast = cached_ast;
+  if (parser == nullptr) {
+    messages << "====> LOADING FILE " << filename << " FROM AST CACHE "
+             << cache.path(source_hash(src)) << endl;
+  } else {
+    messages << "====> PARSING FILE " << filename << " USING PARSER "
+             << parser->get_name() << endl;
+    if (direct_tac) {
+      messages << "====> TAC --> " << tacfilename << endl;
+    }
+    res = parser->parse();
+    ast = parser->get_AST();
+    if (use_cache && res == 0 && ast != nullptr) {
+      FlatAst flat;
+      flatten(static_cast<ProgramNode*>(ast), flat);
+      cache.store(src, flat);
+    }
+  }
   if (output_ast) {
-    cout << "====> AST" << endl;
+    messages << "====> AST" << endl;
     if (ast != nullptr) {
-      print_indented(ast->str(), std::cout);
+      {
+        AstPrinter printer(messages, true);
+        printer << ast;
+      }
+      messages << std::endl;
     }
   }
 
-  std::string tacfilename = name_without_extension(filename) + ".tac";
-  cout << "====> TAC --> " << tacfilename << endl;
-  SymbolTable st;
-  Data data(st);
-  TAC tac;
-  if (ast != nullptr) {
-    ast->icg(data, tac);
-    ofstream fs(tacfilename);
-    tac.output(fs);
-    fs.close();
+  if (!direct_tac) {
+    messages << "====> TAC --> " << tacfilename << endl;
+  }
+  // Code is generated only for a program without syntax errors, and written
+  // out only if it has no other errors either.
+  if (ast != nullptr && res == 0) {
+    if (parallel_codegen) {
+      // With -j, the methods are generated on all cores.
+      parallel_icg(static_cast<ProgramNode*>(ast), data, tac,
+                   thread::hardware_concurrency());
+    } else {
+      ast->icg(data, tac);
+    }
+  }
+  data.diagnostics.flush(messages);
+  if (res == 0 && data.error_count == 0 && (ast != nullptr || direct_tac)) {
+    if (from_stdin) {
+      // Straight to stdout, so that the code can be piped on.
+      tac.output(stdout);
+    } else {
+      ofstream fs(tacfilename);
+      tac.output(fs);
+      fs.close();
+    }
   }
 
   if (output_sym_table) {
-    cout << "====> SYMBOL-TABLE" << endl;
-    cout << "\nSymbol table (" << st.size() << "):" << endl;
+    messages << "====> SYMBOL-TABLE" << endl;
+    messages << "\nSymbol table (" << st.size() << "):" << endl;
     list<SymbolTable::Entry> L = st.entries();
     for (auto elem : L) {
-      cout << SymbolTable::to_str(elem) << endl;
+      messages << SymbolTable::to_str(elem) << endl;
     }
   }
 
   // Clean up and return.
-  fclose(file);
+  if (!from_stdin) {
+    fclose(file);
+  }
   delete parser;
-  return 0;
+  return (res == 0 && data.error_count == 0) ? 0 : 1;
 }
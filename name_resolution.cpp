@@ -0,0 +1,121 @@
+#include "ast.h"
+#include "ast_visitor.h"
+
+namespace {
+
+// Binds the names in the statements of a method, in one walk over them.
+class NameResolver : public AstVisitor<NameResolver> {
+ public:
+  NameResolver(Data& data, const std::string& method)
+      : data_(data),
+        st_(data.sym_table),
+        scope_(st_.find_id(method)) {}
+
+  // Resolve the names in 'node' and its subtree. Children are resolved
+  // through here, which switches to a new stack segment when the tree is
+  // nested too deeply for the current one.
+  template <typename T>
+  void resolve(const T* node) {
+    if (node != nullptr) {
+      ensure_stack([&]() { visit(node); });
+    }
+  }
+
+  void visit_and(const AndExprNode* node) {
+    resolve(node->get_lhs());
+    resolve(node->get_rhs());
+  }
+
+  void visit_or(const OrExprNode* node) {
+    resolve(node->get_lhs());
+    resolve(node->get_rhs());
+  }
+
+  void visit_not(const NotExprNode* node) { resolve(node->get_rhs()); }
+
+  void visit_relational(const RelationalExprNode* node) {
+    resolve(node->get_lhs());
+    resolve(node->get_rhs());
+  }
+
+  void visit_arithmetic(const ArithmeticExprNode* node) {
+    resolve(node->get_lhs());
+    resolve(node->get_rhs());
+  }
+
+  void visit_bitwise(const BitwiseExprNode* node) {
+    resolve(node->get_lhs());
+    resolve(node->get_rhs());
+  }
+
+  void visit_complement(const ComplementExprNode* node) {
+    resolve(node->get_rhs());
+  }
+
+  // The method's own variable, or else the global one.
+  void visit_variable(const VariableExprNode* node) {
+    data_.symbols[node] = st_.resolve(scope_, st_.find_id(node->get_id()));
+  }
+
+  void visit_method_call(const MethodCallExprStmNode* node) {
+    data_.symbols[node] =
+        st_.lookup(st_.global_scope(), st_.find_id(node->get_id()));
+    for (auto arg : *node->get_args()) {
+      resolve(arg);
+    }
+  }
+
+  void visit_index(const IndexExprNode* node) {
+    visit_variable(node->get_array());
+    resolve(node->get_index());
+  }
+
+  void visit_assign(const AssignStmNode* node) {
+    visit_variable(node->get_var());
+    resolve(node->get_expr());
+  }
+
+  void visit_index_assign(const IndexAssignStmNode* node) {
+    visit_index(node->get_element());
+    resolve(node->get_expr());
+  }
+
+  void visit_incr(const IncrStmNode* node) { visit_variable(node->get_var()); }
+
+  void visit_decr(const DecrStmNode* node) { visit_variable(node->get_var()); }
+
+  void visit_return(const ReturnStmNode* node) { resolve(node->get_expr()); }
+
+  void visit_block(const BlockStmNode* node) {
+    for (auto stm : *node->get_stms()) {
+      resolve(stm);
+    }
+  }
+
+  void visit_if(const IfStmNode* node) {
+    resolve(node->get_expr());
+    resolve(node->get_if());
+    resolve(node->get_else());
+  }
+
+  void visit_for(const ForStmNode* node) {
+    visit_assign(node->get_assign());
+    resolve(node->get_expr());
+    resolve(node->get_incr_decr());
+    resolve(node->get_block());
+  }
+
+ private:
+  Data& data_;
+  SymbolTable& st_;
+  SymbolTable::Id scope_;
+};
+
+}  // namespace
+
+void resolve_names(const MethodNode* method, Data& data) {
+  NameResolver resolver(data, method->get_id());
+  for (auto stm : *method->get_stms()) {
+    resolver.resolve(stm);
+  }
+}
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+void parallel_icg(const ProgramNode* program, Data& data, TAC& tac,
+                  unsigned workers) {
+  if (program->get_var_decls() != nullptr) {
+    for (auto vd : *program->get_var_decls()) {
+      child_icg(vd, data, tac);
+    }
+  }
+  tac.append(TAC::InstrType::GOTO, "main");
+
+  // Declare all methods, in order, each with its own data and code, and
+  // resolve the names in each one before the next is declared, so that a
+  // method sees only those declared up to it, as with icg. The symbol table
+  // is complete after this, and only read from then on.
+  vector<const MethodNode*> methods;
+  if (program->get_method_decls() != nullptr) {
+    methods.assign(program->get_method_decls()->begin(),
+                   program->get_method_decls()->end());
+  }
+  deque<Data> method_data;
+  vector<TAC> method_tac(methods.size());
+  for (size_t m = 0; m < methods.size(); ++m) {
+    method_data.emplace_back(data.sym_table);
+    method_data[m].location = methods[m]->location();
+    method_tac[m].set_typed(tac.typed());
+    method_tac[m].set_label_scope(methods[m]->get_id());
+    methods[m]->declare(method_data[m], method_tac[m]);
+    resolve_names(methods[m], method_data[m]);
+  }
+
+  atomic<size_t> next_method(0);
+  auto work = [&]() {
+    for (size_t m = next_method++; m < methods.size(); m = next_method++) {
+      methods[m]->define(method_data[m], method_tac[m]);
+    }
+  };
+  vector<thread> threads;
+  for (size_t t = 1; t < min<size_t>(max(1u, workers), methods.size()); ++t) {
+    threads.push_back(thread(work));
+  }
+  work();
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (size_t m = 0; m < methods.size(); ++m) {
+    tac.splice(method_tac[m]);
+    data.diagnostics.merge(method_data[m].diagnostics);
+    data.error_count += method_data[m].error_count;
+  }
+
+  if (data.sym_table.lookup("", "main") == nullptr) {
+    error_msg(data, DiagId::MissingMain, "Main method is missing.");
+  }
+}
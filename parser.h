@@ -1,14 +1,24 @@
-
 #ifndef DECAFPARSER_PARSER_H
 #define DECAFPARSER_PARSER_H
 
+#include <cstdio>
+#include <iostream>
+#include <memory>
 #include <string>
 #include "ast.h"
+#include "hash_cons.h"
 #include "parser_decaf.hpp"
 using decaf = yy::parser_decaf;
-#define YY_DECL decaf::symbol_type yylex()
+#define YY_DECL decaf::symbol_type yylex(yyscan_t yyscanner)
 YY_DECL;
 
+// The scanner is reentrant (see decaf.l); each parser owns one. The location
+// 'loc' is updated by the scanner as tokens are read.
+yyscan_t scanner_create(FILE* file, yy::location* loc, bool debug);
+yyscan_t scanner_create(const char* bytes, size_t len, yy::location* loc,
+                        bool debug);
+void scanner_destroy(yyscan_t scanner);
+
 class Parser {
  public:
   // Constructor, input stream to read provided.
@@ -16,7 +26,27 @@ class Parser {
       : file_(file),
         debug_lexer_(debug_lexer),
         debug_parser_(debug_parser),
-        ast_(nullptr) {}
+        ast_(nullptr),
+        out_(&std::cout),
+        errors_(0),
+        scanner_(scanner_create(file_, &loc_, debug_lexer_)) {}
+
+  // Constructor, in-memory input to read provided. Locations start at the
+  // given line and column, so that a region of a larger file can be parsed.
+  Parser(const char* bytes, size_t len, int line, int col, bool debug_lexer,
+         bool debug_parser)
+      : file_(nullptr),
+        debug_lexer_(debug_lexer),
+        debug_parser_(debug_parser),
+        ast_(nullptr),
+        out_(&std::cout),
+        errors_(0),
+        scanner_(scanner_create(bytes, len, &loc_, debug_lexer_)) {
+    loc_.initialize(nullptr, line, col);
+  }
+
+  Parser(const Parser&) = delete;
+  Parser& operator=(const Parser&) = delete;
 
   // Parse the input. This method could potentially throw IO-related exceptions.
   virtual int parse() = 0;
@@ -30,14 +60,64 @@ class Parser {
   // Return the root node of the abstract syntax tree.
   Node* get_AST() { return ast_; }
 
+  // Report syntax errors to 'os' instead of standard output.
+  void set_output(std::ostream& os) { out_ = &os; }
+
+  // Return the number of errors reported to the output.
+  int error_count() const { return errors_; }
+
+  // Build the AST with identical pure expressions shared (see hash_cons.h).
+  // Off by default; set before parse().
+  void set_hash_consing(bool on) {
+    hash_cons_.reset(on ? new HashConsTable() : nullptr);
+  }
+
+  // The table of shared expressions, or nullptr if hash-consing is off.
+  const HashConsTable* hash_cons_table() const { return hash_cons_.get(); }
+
+  // Called by the parsers on each expression node they build: returns the
+  // node to use in its place.
+  ExprNode* intern(ExprNode* node) {
+    return hash_cons_ ? hash_cons_->intern(node) : node;
+  }
+
+  // Called by the parsers on each number literal, read at 'line' and 'col':
+  // returns its node, after reporting the literal if it is out of range.
+  // Code generation takes the literals of a parsed program as they are.
+  NumberExprNode* number(const std::string& literal, int line, int col) {
+    NumberExprNode* node = new NumberExprNode(literal);
+    if (!node->get_constant().in_range) {
+      *out_ << "Error (line " << line << ", col " << col << "): Number '"
+            << literal << "' is out of range." << std::endl;
+      ++errors_;
+    }
+    return node;
+  }
+
+  NumberExprNode* number(const std::string& literal, const yy::location& loc) {
+    return number(literal, loc.begin.line, loc.begin.column);
+  }
+
+  // Called by the parsers at the end of each method declaration.
+  void end_method() {
+    if (hash_cons_) {
+      hash_cons_->clear();
+    }
+  }
+
   // Destructor.
-  virtual ~Parser() = default;
+  virtual ~Parser() { scanner_destroy(scanner_); }
 
  protected:
   FILE* file_;
   bool debug_lexer_;
   bool debug_parser_;
   Node* ast_;
+  std::ostream* out_;
+  int errors_;  // Errors reported to out_ so far.
+  yy::location loc_;
+  yyscan_t scanner_;
+  std::unique_ptr<HashConsTable> hash_cons_;
 };
 
 #endif  // DECAFPARSER_PARSER_H
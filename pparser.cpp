@@ -0,0 +1,207 @@
+#include "pparser.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <sstream>
+#include <thread>
+#include "hparser.h"
+
+using namespace std;
+
+string read_source(FILE* file) {
+  string src;
+  char buf[1 << 16];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+    src.append(buf, n);
+  }
+  return src;
+}
+
+static bool is_word_char(char c) {
+  return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Whether the word that follows offset 'i' in 'src', past blanks and
+// comments, is 'word'.
+static bool next_word_is(const string& src, size_t i, const char* word) {
+  while (i < src.size()) {
+    if (src[i] == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+      i = src.find("*/", i + 2);
+      if (i == string::npos) {
+        return false;
+      }
+      i += 2;
+    } else if (isspace(static_cast<unsigned char>(src[i]))) {
+      ++i;
+    } else {
+      break;
+    }
+  }
+  size_t j = i;
+  while (j < src.size() && is_word_char(src[j])) {
+    ++j;
+  }
+  return src.compare(i, j - i, word) == 0;
+}
+
+Prescan prescan(const string& src) {
+  Prescan result;
+  result.ok = false;
+
+  size_t i = 0;
+  int line = 1, col = 1;
+  auto advance = [&](size_t count) {
+    for (; count > 0; --count, ++i) {
+      if (src[i] == '\n') {
+        ++line;
+        col = 1;
+      } else {
+        ++col;
+      }
+    }
+  };
+
+  int depth = 0;
+  bool in_method = false;
+  bool closed = false;
+  Prescan::Span method = {0, 0, 1, 1};
+  while (i < src.size()) {
+    char c = src[i];
+    if (c == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+      size_t end = src.find("*/", i + 2);
+      if (end == string::npos) {
+        return result;
+      }
+      advance(end + 2 - i);
+      continue;
+    }
+    if (isspace(static_cast<unsigned char>(c))) {
+      advance(1);
+      continue;
+    }
+    if (closed) {
+      return result;  // Something follows the end of the class.
+    }
+    if (is_word_char(c)) {
+      size_t j = i;
+      while (j < src.size() && is_word_char(src[j])) {
+        ++j;
+      }
+      if (depth == 1 && !in_method) {
+        // "static final" declares a constant, which belongs to the head.
+        if (src.compare(i, j - i, "static") == 0 &&
+            (!next_word_is(src, j, "final") || !result.methods.empty())) {
+          in_method = true;
+          method = {i, 0, line, col};
+        } else if (!result.methods.empty()) {
+          return result;
+        }
+      }
+      advance(j - i);
+      continue;
+    }
+    if (c == '{') {
+      ++depth;
+    } else if (c == '}') {
+      --depth;
+      if (depth < 0 || (depth == 0 && in_method)) {
+        return result;
+      }
+      if (depth == 1 && in_method) {
+        method.end = i + 1;
+        result.methods.push_back(method);
+        in_method = false;
+      }
+      closed = (depth == 0);
+    } else if (depth == 1 && !in_method && !result.methods.empty()) {
+      return result;
+    }
+    advance(1);
+  }
+
+  if (closed && !result.methods.empty()) {
+    // The head keeps the "static" of the first method, so that a missing ";"
+    // after the last field is reported against it, as HParser would.
+    result.head = {0, result.methods.front().begin + 6, 1, 1};
+    result.ok = true;
+  }
+  return result;
+}
+
+ProgramNode* parse_prescanned(const string& src, const Prescan& scan,
+                              bool debug_lexer, bool debug_parser,
+                              ostream& out, int& errors) {
+  HParser head_parser(src.data() + scan.head.begin,
+                      scan.head.end - scan.head.begin, scan.head.line,
+                      scan.head.col, debug_lexer, debug_parser);
+  head_parser.set_output(out);
+  ProgramNode* program = head_parser.parse_class_head();
+  errors = head_parser.error_count();
+
+  // Group consecutive methods into chunks of about equal size, a few chunks
+  // per worker so that methods of uneven size even out.
+  size_t workers = max(1u, thread::hardware_concurrency());
+  size_t target = (scan.methods.back().end - scan.methods.front().begin) /
+                      (workers * 4) +
+                  1;
+  vector<pair<size_t, size_t>> chunks;  // First and last method of a chunk.
+  size_t first = 0;
+  for (size_t m = 0; m < scan.methods.size(); ++m) {
+    if (scan.methods[m].end - scan.methods[first].begin >= target ||
+        m + 1 == scan.methods.size()) {
+      chunks.push_back(make_pair(first, m));
+      first = m + 1;
+    }
+  }
+
+  vector<list<MethodNode*>*> results(chunks.size(), nullptr);
+  vector<ostringstream> messages(chunks.size());
+  vector<int> chunk_errors(chunks.size(), 0);
+  atomic<size_t> next_chunk(0);
+  auto work = [&]() {
+    for (size_t c = next_chunk++; c < chunks.size(); c = next_chunk++) {
+      const Prescan::Span& begin = scan.methods[chunks[c].first];
+      const Prescan::Span& end = scan.methods[chunks[c].second];
+      HParser parser(src.data() + begin.begin, end.end - begin.begin,
+                     begin.line, begin.col, debug_lexer, debug_parser);
+      parser.set_output(messages[c]);
+      results[c] = parser.parse_methods();
+      chunk_errors[c] = parser.error_count();
+    }
+  };
+  vector<thread> threads;
+  for (size_t t = 1; t < min(workers, chunks.size()); ++t) {
+    threads.push_back(thread(work));
+  }
+  work();
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  list<MethodNode*>* methods = program->get_method_decls();
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    methods->splice(methods->end(), *results[c]);
+    delete results[c];
+    out << messages[c].str();
+    errors += chunk_errors[c];
+  }
+  return program;
+}
+
+int PParser::parse() {
+  string src = read_source(file_);
+  Prescan scan = prescan(src);
+  if (!scan.ok) {
+    // Let the sequential parser report whatever is wrong with the input.
+    HParser parser(src.data(), src.size(), 1, 1, debug_lexer_, debug_parser_);
+    parser.set_output(*out_);
+    int res = parser.parse();
+    set_AST(parser.get_AST());
+    return res;
+  }
+  int errors;
+  set_AST(
+      parse_prescanned(src, scan, debug_lexer_, debug_parser_, *out_, errors));
+  return errors == 0 ? 0 : 1;
+}
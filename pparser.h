@@ -0,0 +1,53 @@
+#ifndef DECAFPARSER_PPARSER_H
+#define DECAFPARSER_PPARSER_H
+
+#include <string>
+#include <vector>
+#include "parser.h"
+
+// Method boundaries of a Decaf class, found by brace matching alone.
+struct Prescan {
+  struct Span {
+    size_t begin;  // Offset of the first byte.
+    size_t end;    // Offset one past the last byte.
+    int line;      // Line and column of the first byte.
+    int col;
+  };
+
+  bool ok;                    // False if the class could not be split up.
+  Span head;                  // "class Id { field_declarations static".
+  std::vector<Span> methods;  // One span per "static ... { ... }".
+};
+
+// Find the method declarations in 'src' by tracking brace depth, skipping
+// comments. Anything at class level that is not a method once the methods
+// have started, or unbalanced braces, makes the result not ok; the input is
+// then left for a sequential parser to report on.
+Prescan prescan(const std::string& src);
+
+// Read all of 'file' into memory.
+std::string read_source(FILE* file);
+
+// Parse a class that prescan() has split up: the head on the calling thread,
+// the methods on worker threads. The methods of the returned program are in
+// source order, one per span in 'scan.methods' unless there are syntax errors.
+// Those are reported to 'out' in source order once all threads are done, and
+// counted in 'errors'.
+ProgramNode* parse_prescanned(const std::string& src, const Prescan& scan,
+                              bool debug_lexer, bool debug_parser,
+                              std::ostream& out, int& errors);
+
+// Parses the methods of a class on worker threads, each chunk of consecutive
+// methods with its own handmade parser and scanner, and assembles them into
+// the program in source order.
+class PParser : public Parser {
+ public:
+  PParser(FILE* file, bool debug_lexer, bool debug_parser)
+      : Parser(file, debug_lexer, debug_parser) {}
+
+  virtual int parse() override;
+
+  virtual std::string get_name() const override { return "Parallel"; }
+};
+
+#endif  // DECAFPARSER_PPARSER_H
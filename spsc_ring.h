@@ -0,0 +1,79 @@
+#ifndef DECAFPARSER_SPSC_RING_H
+#define DECAFPARSER_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// A bounded queue between exactly one producer thread and one consumer
+// thread, without locks. Values are swapped in and out of preallocated slots,
+// so a slot's storage (e.g. a string's buffer) is reused rather than
+// reallocated. The two ends' indices sit on separate cache lines, and each end
+// keeps its own copy of the other's index, re-reading the shared one only when
+// the ring looks full or empty.
+template <typename T>
+class SpscRing {
+ public:
+  // 'capacity' is rounded up to a power of two.
+  explicit SpscRing(size_t capacity)
+      : head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  // Producer: swap 'value' into the ring. Returns false if it is full.
+  bool try_push(T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == slots_.size()) {
+        return false;
+      }
+    }
+    std::swap(slots_[tail & mask_], value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: swap the oldest value out of the ring into 'value'. Returns
+  // false if it is empty.
+  bool try_pop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    std::swap(slots_[head & mask_], value);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static const size_t CacheLine = 64;
+
+  std::vector<T> slots_;
+  size_t mask_;
+  char pad0_[CacheLine];
+
+  // Written by the consumer.
+  std::atomic<size_t> head_;
+  size_t cached_tail_;
+  char pad1_[CacheLine];
+
+  // Written by the producer.
+  std::atomic<size_t> tail_;
+  size_t cached_head_;
+  char pad2_[CacheLine];
+};
+
+#endif  // DECAFPARSER_SPSC_RING_H
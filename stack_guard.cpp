@@ -0,0 +1,72 @@
+#include "stack_guard.h"
+#include <pthread.h>
+#include <exception>
+#include <new>
+
+using namespace std;
+
+// Lowest usable address of the current thread's stack, which grows down.
+static char* find_stack_limit() {
+  pthread_t self = pthread_self();
+#ifdef __APPLE__
+  char* top = static_cast<char*>(pthread_get_stackaddr_np(self));
+  return top - pthread_get_stacksize_np(self);
+#else
+  pthread_attr_t attr;
+  void* addr = nullptr;
+  size_t size = 0;
+  if (pthread_getattr_np(self, &attr) == 0) {
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+  }
+  return static_cast<char*>(addr);
+#endif
+}
+
+size_t stack_remaining() {
+  static thread_local char* limit = find_stack_limit();
+  char here;
+  if (limit == nullptr || &here < limit) {
+    return StackRedZone + 1;  // Unknown; carry on as usual.
+  }
+  return static_cast<size_t>(&here - limit);
+}
+
+namespace {
+
+struct NewStackJob {
+  const function<void()>* f;
+  exception_ptr error;
+};
+
+extern "C" void* run_job(void* arg) {
+  NewStackJob* job = static_cast<NewStackJob*>(arg);
+  try {
+    (*job->f)();
+  } catch (...) {
+    job->error = current_exception();
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+void run_on_new_stack(const function<void()>& f) {
+  // The segment is the stack of a thread of its own, which the caller waits
+  // for; nothing runs concurrently.
+  NewStackJob job;
+  job.f = &f;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, StackSegmentSize);
+  pthread_t thread;
+  int res = pthread_create(&thread, &attr, run_job, &job);
+  pthread_attr_destroy(&attr);
+  if (res != 0) {
+    throw bad_alloc();
+  }
+  pthread_join(thread, nullptr);
+  if (job.error) {
+    rethrow_exception(job.error);
+  }
+}
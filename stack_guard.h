@@ -0,0 +1,51 @@
+#ifndef DECAFPARSER_STACK_GUARD_H
+#define DECAFPARSER_STACK_GUARD_H
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+// Recursive descent and the recursive str() and icg() nest as deeply as the
+// program does. The recursive steps go through ensure_stack(), which runs
+// them on the current stack while there is room, and on a new stack segment
+// otherwise, so that nesting depth is bounded by memory rather than by the
+// size of the native stack.
+
+const size_t StackRedZone = 256 * 1024;           // Room to leave on a stack.
+const size_t StackSegmentSize = 8 * 1024 * 1024;  // Size of a new segment.
+
+// Bytes left on the current thread's stack.
+size_t stack_remaining();
+
+// Run 'f' on a new stack segment and wait for it to finish. Exceptions thrown
+// by 'f' are passed on to the caller.
+void run_on_new_stack(const std::function<void()>& f);
+
+template <typename Result>
+struct NewStackCall {
+  template <typename F>
+  static Result run(F& f) {
+    Result result = Result();
+    run_on_new_stack([&]() { result = f(); });
+    return result;
+  }
+};
+
+template <>
+struct NewStackCall<void> {
+  template <typename F>
+  static void run(F& f) {
+    run_on_new_stack([&]() { f(); });
+  }
+};
+
+// Return f(), called on a new stack segment if the current one runs low.
+template <typename F>
+auto ensure_stack(F f) -> decltype(f()) {
+  if (stack_remaining() > StackRedZone) {
+    return f();
+  }
+  return NewStackCall<typename std::decay<decltype(f())>::type>::run(f);
+}
+
+#endif  // DECAFPARSER_STACK_GUARD_H
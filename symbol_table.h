@@ -1,11 +1,15 @@
 #ifndef DECAFPARSER_SYMBOL_TABLE_H
 #define DECAFPARSER_SYMBOL_TABLE_H
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <list>
-#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
-enum class ValueType { VoidVal, IntVal, RealVal };
+enum class ValueType : uint8_t { VoidVal, IntVal, RealVal };
 
 inline std::string tostr(ValueType t) {
   return ((t == ValueType::VoidVal)
@@ -13,14 +17,106 @@ inline std::string tostr(ValueType t) {
               : ((t == ValueType::IntVal) ? "int" : "real"));
 }
 
-enum class EntryType { Variable, Method };
+// The types of a method's parameters, in order.
+typedef std::vector<ValueType> Signature;
+
+// The types of 'signature' by name, with 'separator' between them.
+inline std::string tostr(const Signature& signature,
+                         const std::string& separator) {
+  std::string s;
+  for (ValueType type : signature) {
+    if (!s.empty()) {
+      s += separator;
+    }
+    s += tostr(type);
+  }
+  return s;
+}
+
+enum class EntryType { Variable, Method, Constant };
 
 inline std::string tostr(EntryType t) {
-  return ((t == EntryType::Variable) ? "Variable" : "Method");
+  return ((t == EntryType::Variable)
+              ? "Variable"
+              : ((t == EntryType::Method) ? "Method" : "Constant"));
 }
 
+// Interns identifiers: each distinct string gets a small integer id, so that
+// identifiers can be compared and hashed as integers. The strings are kept in
+// an open-addressing hash table of ids; finding one allocates nothing.
+class IdentifierTable {
+ public:
+  typedef uint32_t Id;
+  static const Id NoId = 0xffffffff;
+
+  IdentifierTable() : slots_(InitialSlots, Id(NoId)) {}
+
+  // The id of 'name', added if it is new.
+  Id intern(const std::string& name) {
+    size_t slot = find_slot(name);
+    if (slots_[slot] == NoId) {
+      slots_[slot] = static_cast<Id>(names_.size());
+      names_.push_back(name);
+      if (2 * names_.size() > slots_.size()) {
+        rehash();
+      }
+      return static_cast<Id>(names_.size() - 1);
+    }
+    return slots_[slot];
+  }
+
+  // The id of 'name', or NoId if it has not been interned.
+  Id find(const std::string& name) const { return slots_[find_slot(name)]; }
+
+  const std::string& name(Id id) const { return names_[id]; }
+
+  size_t size() const { return names_.size(); }
+
+  void clear() {
+    names_.clear();
+    slots_.assign(InitialSlots, Id(NoId));
+  }
+
+ private:
+  static const size_t InitialSlots = 64;  // A power of two.
+
+  static uint32_t hash(const std::string& name) {
+    uint32_t hash = 2166136261u;  // 32-bit FNV-1a.
+    for (unsigned char c : name) {
+      hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+  }
+
+  // The slot holding 'name', or the empty slot where it would go.
+  size_t find_slot(const std::string& name) const {
+    size_t mask = slots_.size() - 1;
+    size_t slot = hash(name) & mask;
+    while (slots_[slot] != NoId && names_[slots_[slot]] != name) {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void rehash() {
+    slots_.assign(2 * slots_.size(), Id(NoId));
+    for (Id id = 0; id < names_.size(); ++id) {
+      slots_[find_slot(names_[id])] = id;
+    }
+  }
+
+  std::deque<std::string> names_;  // By id; references stay valid.
+  std::vector<Id> slots_;          // Open addressing, linear probing.
+};
+
+// The symbols of a program, in scopes: the global scope "" and a scope per
+// method, named after it, inside the global one. Scope and symbol names are
+// interned, and entries are found by the pair of ids in an open-addressing
+// hash table, so a lookup is a couple of probes and allocates nothing.
 class SymbolTable {
  public:
+  typedef IdentifierTable::Id Id;
+
   // Entry in the symbol table.
   class Entry {
    public:
@@ -28,49 +124,147 @@ class SymbolTable {
     std::string scope;
     EntryType entry_type;
     ValueType value_type;
-    std::string signature;
+    Signature signature;     // Of a method; empty for a variable.
+    std::string value;       // The literal of a constant; empty otherwise.
+    int64_t array_size = 0;  // Of an array variable; 0 for a scalar.
   };
 
   static std::string to_str(Entry e) {
     return std::string("(") + e.name + "," + e.scope + "," +
-           tostr(e.entry_type) + "," + tostr(e.value_type) + "," + e.signature +
-           ")";
+           tostr(e.entry_type) + "," + tostr(e.value_type) +
+           (e.array_size != 0 ? "[" + std::to_string(e.array_size) + "]"
+                              : "") +
+           "," +
+           tostr(e.signature, "::") +
+           (e.entry_type == EntryType::Constant ? "," + e.value : "") + ")";
   }
 
+  SymbolTable() : slots_(InitialSlots) { global_ = ids_.intern(""); }
+
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable& operator=(const SymbolTable&) = delete;
+
   // Returns the size of the symbol table.
-  size_t size() const { return data_.size(); }
+  size_t size() const { return entries_.size(); }
 
   // Clears the symbol table.
-  void clear() { data_.clear(); }
+  void clear() {
+    entries_.clear();
+    slots_.assign(InitialSlots, Slot());
+    ids_.clear();
+    global_ = ids_.intern("");
+  }
+
+  // The id of an identifier, for the lookups by id; interned if it is new.
+  Id id(const std::string& name) { return ids_.intern(name); }
+
+  // The id of an identifier, or NoId if it is not known; never interned, so
+  // that threads can look up names at the same time.
+  Id find_id(const std::string& name) const { return ids_.find(name); }
+
+  // The id of the global scope.
+  Id global_scope() const { return global_; }
 
   // Returns entry in symbol table for 'key' if exists, otherwise nullptr.
-  SymbolTable::Entry* lookup(std::string scope, std::string name) {
-    auto it = data_.find(key(scope, name));
-    return (it == data_.end()) ? nullptr : &(it->second);
+  SymbolTable::Entry* lookup(const std::string& scope,
+                             const std::string& name) {
+    return lookup(ids_.find(scope), ids_.find(name));
+  }
+
+  SymbolTable::Entry* lookup(Id scope, Id name) {
+    if (scope == IdentifierTable::NoId || name == IdentifierTable::NoId) {
+      return nullptr;
+    }
+    return slots_[find_slot(scope, name)].entry;
+  }
+
+  // Returns the entry that 'name' refers to in 'scope': its own, if it has
+  // one, or else the global one, or nullptr if there is neither.
+  SymbolTable::Entry* resolve(const std::string& scope,
+                              const std::string& name) {
+    return resolve(ids_.find(scope), ids_.find(name));
+  }
+
+  SymbolTable::Entry* resolve(Id scope, Id name) {
+    SymbolTable::Entry* entry = lookup(scope, name);
+    if (entry == nullptr && scope != global_) {
+      entry = lookup(global_, name);
+    }
+    return entry;
   }
 
   // Add a new entry to the symbol table
   // (overriding an existing entry with same name, if any).
   SymbolTable::Entry* add(const SymbolTable::Entry& entry) {
-    data_[key(entry.scope, entry.name)] = entry;
-    return lookup(entry.scope, entry.name);
+    Id scope = ids_.intern(entry.scope);
+    Id name = ids_.intern(entry.name);
+    Slot& slot = slots_[find_slot(scope, name)];
+    if (slot.entry != nullptr) {
+      *slot.entry = entry;
+      return slot.entry;
+    }
+    entries_.push_back(entry);
+    slot.scope = scope;
+    slot.name = name;
+    slot.entry = &entries_.back();
+    if (2 * entries_.size() > slots_.size()) {
+      rehash();
+    }
+    return &entries_.back();
   }
 
   // Returns a list of the entries in the symbol table ordered by name.
   std::list<SymbolTable::Entry> entries() const {
+    // Ordered as "scope::name", as the table used to be keyed.
+    std::vector<std::pair<std::string, const Entry*>> keyed;
+    keyed.reserve(entries_.size());
+    for (const Entry& entry : entries_) {
+      keyed.push_back(std::make_pair(entry.scope + "::" + entry.name, &entry));
+    }
+    std::sort(keyed.begin(), keyed.end());
     std::list<SymbolTable::Entry> list_of_entries;
-    for (auto it : data_) {
-      list_of_entries.push_back(it.second);
+    for (auto& key : keyed) {
+      list_of_entries.push_back(*key.second);
     }
     return list_of_entries;
   }
 
  private:
-  std::string key(std::string scope, std::string name) {
-    return scope + std::string("::") + name;
+  static const size_t InitialSlots = 64;  // A power of two.
+
+  struct Slot {
+    Slot() : scope(0), name(0), entry(nullptr) {}
+    Id scope;
+    Id name;
+    Entry* entry;  // nullptr if the slot is empty.
+  };
+
+  // The slot holding the entry for (scope, name), or the empty slot where it
+  // would go.
+  size_t find_slot(Id scope, Id name) const {
+    size_t mask = slots_.size() - 1;
+    size_t slot = (((scope * 0x9e3779b1u) ^ name) * 0x85ebca6bu) & mask;
+    while (slots_[slot].entry != nullptr &&
+           (slots_[slot].scope != scope || slots_[slot].name != name)) {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void rehash() {
+    std::vector<Slot> old(2 * slots_.size());
+    old.swap(slots_);
+    for (const Slot& slot : old) {
+      if (slot.entry != nullptr) {
+        slots_[find_slot(slot.scope, slot.name)] = slot;
+      }
+    }
   }
 
-  std::map<std::string, SymbolTable::Entry> data_;
+  IdentifierTable ids_;
+  Id global_;
+  std::deque<Entry> entries_;  // In the order added; pointers stay valid.
+  std::vector<Slot> slots_;    // Open addressing, linear probing.
 };
 
 #endif  // DECAFPARSER_SYMBOL_TABLE_H
@@ -3,17 +3,24 @@
 #define DECAFPARSER_TAC_H
 
 #include <assert.h>
-#include <iomanip>
+#include <cstdio>
 #include <iostream>
-#include <list>
 #include <vector>
+#include "constant_pool.h"
+#include "symbol_table.h"
 
 class TAC {
  public:
   const std::vector<std::string> IName = {
-      "UMINUS", "ADD",  "SUB",    "MULT",   "DIVIDE", "MOD",    "AND", "OR",
-      "NOT",    "CALL", "FPARAM", "APARAM", "RETURN", "GOTO",   "LT",  "LE",
-      "GT",     "GE",   "EQ",     "NE",     "VAR",    "ASSIGN", "NOOP"};
+      "UMINUS", "ADD",   "SUB",     "MULT",    "DIVIDE",  "MOD",    "AND",
+      "OR",     "NOT",   "CALL",    "FPARAM",  "APARAM",  "RETURN", "GOTO",
+      "LT",     "LE",    "GT",      "GE",      "EQ",      "NE",     "VAR",
+      "ASSIGN", "NOOP",  "IUMINUS", "FUMINUS", "IADD",    "FADD",   "ISUB",
+      "FSUB",   "IMULT", "FMULT",   "IDIVIDE", "FDIVIDE", "IMOD",   "FMOD",
+      "ILT",    "FLT",   "ILE",     "FLE",     "IGT",     "FGT",    "IGE",
+      "FGE",    "IEQ",   "FEQ",     "INE",     "FNE",     "ITOF",   "FTOI",
+      "ARRAY",  "LOAD",  "STORE",   "BOUNDS",  "BITAND",  "BITOR",  "BITXOR",
+      "BITNOT", "SHL",   "SHR"};
 
   enum InstrType {
     UMINUS,
@@ -38,70 +45,220 @@ class TAC {
     NE,
     VAR,
     ASSIGN,
-    NOOP
+    NOOP,
+    // Typed code only: the int and real variants of the operations above
+    // that depend on the type of their operands, in the same order, and the
+    // conversions between int and real.
+    IUMINUS,
+    FUMINUS,
+    IADD,
+    FADD,
+    ISUB,
+    FSUB,
+    IMULT,
+    FMULT,
+    IDIVIDE,
+    FDIVIDE,
+    IMOD,
+    FMOD,
+    ILT,
+    FLT,
+    ILE,
+    FLE,
+    IGT,
+    FGT,
+    IGE,
+    FGE,
+    IEQ,
+    FEQ,
+    INE,
+    FNE,
+    ITOF,
+    FTOI,
+    // Arrays, of ints or reals as declared:
+    //   ARRAY  size         a    a is an array of 'size' elements.
+    //   LOAD   a      i     t    t = a[i]
+    //   STORE  x      i     a    a[i] = x
+    //   BOUNDS i      size       Stop unless 0 <= i < size.
+    ARRAY,
+    LOAD,
+    STORE,
+    BOUNDS,
+    // Bitwise operations, on ints only, whether the code is typed or not.
+    // SHR shifts the sign bit in.
+    BITAND,
+    BITOR,
+    BITXOR,
+    BITNOT,
+    SHL,
+    SHR
   };
 
+  // What an operand is: a temporary, t<number>; a variable or method, by
+  // name; a number literal; or a label.
+  enum class OperandKind : uint8_t { Temp, Variable, Constant, Label };
+
+  // An operand as a tagged 32-bit id: the kind in the top two bits, and below
+  // them the number of the temporary, the index of the name in the code's
+  // table of names, or the index of the literal in constants(). Its text is
+  // only made when the code is written out.
+  typedef uint32_t Operand;
+  static const Operand NoOperand = 0xffffffff;
+
+  static Operand make_operand(OperandKind kind, uint32_t index) {
+    return (static_cast<uint32_t>(kind) << 30) | index;
+  }
+  static OperandKind operand_kind(Operand operand) {
+    return static_cast<OperandKind>(operand >> 30);
+  }
+  static uint32_t operand_index(Operand operand) {
+    return operand & 0x3fffffff;
+  }
+
+  // An instruction, of a fixed size; an operand that is not there, and the
+  // label of an unlabeled instruction, are NoOperand.
   struct Quad {
-    Quad(std::string l, TAC::InstrType t) : label(l), type(t) {}
-    Quad(std::string l, TAC::InstrType t, std::string r)
-        : label(l), type(t), result(r) {}
-    Quad(std::string l, TAC::InstrType t, std::string p1, std::string r)
-        : label(l), type(t), param1(p1), result(r) {}
-    Quad(std::string l, TAC::InstrType t, std::string p1, std::string p2,
-         std::string r)
-        : label(l), type(t), param1(p1), param2(p2), result(r) {}
-
-    std::string label;
+    Operand label;
     TAC::InstrType type;
-    std::string param1;
-    std::string param2;
-    std::string result;
+    Operand param1;
+    Operand param2;
+    Operand result;
   };
 
-  void clear() { program_.clear(); }
+  TAC() : typed_(false) {}
+
+  // Typed code has the operations whose meaning depends on the type of their
+  // operands in their int or real variant (IADD, FADD, ...), and converts
+  // operands of the other type explicitly (ITOF, FTOI), so that it can be run
+  // without checking types. Untyped code, the default, is what JTacInt runs.
+  void set_typed(bool typed) { typed_ = typed; }
+  bool typed() const { return typed_; }
+
+  // The variant of 'itype' for operands of 'type' if the code is typed, and
+  // otherwise 'itype' itself. Operands of no type (void) are taken as int.
+  InstrType typed_instr(InstrType itype, ValueType type) const {
+    if (!typed_) {
+      return itype;
+    }
+    int real = (type == ValueType::RealVal ? 1 : 0);
+    switch (itype) {
+      case UMINUS:
+      case ADD:
+      case SUB:
+      case MULT:
+      case DIVIDE:
+      case MOD:
+        return static_cast<InstrType>(IUMINUS + 2 * (itype - UMINUS) + real);
+      case LT:
+      case LE:
+      case GT:
+      case GE:
+      case EQ:
+      case NE:
+        return static_cast<InstrType>(ILT + 2 * (itype - LT) + real);
+      default:
+        return itype;
+    }
+  }
+
+  // The zero a condition of 'type' is compared with: "0.0" for a real in
+  // typed code, whose real comparisons take two reals, and otherwise "0".
+  const char* zero(ValueType type) const {
+    return typed_ && type == ValueType::RealVal ? "0.0" : "0";
+  }
+
+  // The number literals of the code, each once, with their values.
+  ConstantPool& constants() { return constants_; }
+  const ConstantPool& constants() const { return constants_; }
+
+  // Forget the code, its names and literals, and the labels waiting for the
+  // next instruction.
+  void clear() {
+    program_.clear();
+    labels_.clear();
+    names_.clear();
+    constants_.clear();
+  }
 
   void append(InstrType itype) {
     assert(itype == InstrType::NOOP || itype == InstrType::RETURN);
-    program_.push_back(Quad(get_label(), itype));
+    push(get_label(), itype, NoOperand, NoOperand, NoOperand);
   }
 
-  void append(InstrType itype, std::string result) {
+  void append(InstrType itype, const std::string& result) {
     assert(itype == InstrType::RETURN || itype == InstrType::GOTO ||
            itype == InstrType::VAR || itype == InstrType::CALL ||
            itype == InstrType::FPARAM || itype == InstrType::APARAM);
-    program_.push_back(Quad(get_label(), itype, result));
+    push(get_label(), itype, NoOperand, NoOperand,
+         operand(result, itype == InstrType::GOTO));
   }
 
-  void append(InstrType itype, std::string param1, std::string result) {
+  void append(InstrType itype, const std::string& param1,
+              const std::string& result) {
     assert(itype == InstrType::UMINUS || itype == InstrType::NOT ||
-           itype == InstrType::ASSIGN);
-    program_.push_back(Quad(get_label(), itype, param1, result));
+           itype == InstrType::ASSIGN || itype == InstrType::IUMINUS ||
+           itype == InstrType::FUMINUS || itype == InstrType::ITOF ||
+           itype == InstrType::FTOI || itype == InstrType::ARRAY ||
+           itype == InstrType::BITNOT);
+    push(get_label(), itype, operand(param1), NoOperand, operand(result));
   }
 
-  void append(InstrType itype, std::string param1, std::string param2,
-              std::string result) {
+  void append(InstrType itype, const std::string& param1,
+              const std::string& param2, const std::string& result) {
     assert(itype == InstrType::ADD || itype == InstrType::SUB ||
            itype == InstrType::MULT || itype == InstrType::DIVIDE ||
            itype == InstrType::MOD || itype == InstrType::AND ||
            itype == InstrType::OR || itype == InstrType::NOT ||
            itype == InstrType::LT || itype == InstrType::LE ||
            itype == InstrType::GT || itype == InstrType::GE ||
-           itype == InstrType::EQ || itype == InstrType::NE);
-    program_.push_back(Quad(get_label(), itype, param1, param2, result));
+           itype == InstrType::EQ || itype == InstrType::NE ||
+           (itype >= InstrType::IADD && itype <= InstrType::FNE) ||
+           itype == InstrType::LOAD || itype == InstrType::STORE ||
+           itype == InstrType::BOUNDS ||
+           (itype >= InstrType::BITAND && itype <= InstrType::SHR &&
+            itype != InstrType::BITNOT));
+    push(get_label(), itype, operand(param1), operand(param2),
+         operand(result, jumps(itype)));
+  }
+
+  // Append the variant of 'itype' for operands of 'type' (see typed_instr).
+  void append(InstrType itype, ValueType type, const std::string& param1,
+              const std::string& result) {
+    append(typed_instr(itype, type), param1, result);
+  }
+
+  void append(InstrType itype, ValueType type, const std::string& param1,
+              const std::string& param2, const std::string& result) {
+    append(typed_instr(itype, type), param1, param2, result);
   }
 
   void end_append() {
     // NOTE: if label.
   }
 
-  void label_next_instr(std::string label) { labels_.push_back(label); }
+  void label_next_instr(const std::string& label) {
+    labels_.push_back(operand(label, true));
+  }
+
+  // Labels are "lab_<substr>_<no>", or "lab_<scope>_<substr>_<no>" after
+  // set_label_scope(scope), so that code generated on its own, a method's,
+  // can be put together with other code without its labels clashing.
+  void set_label_scope(const std::string& scope) { label_scope_ = scope; }
 
   std::string label_name(const std::string& substr, int no) {
-    return std::string("lab_") + substr + "_" + std::to_string(no);
+    std::string label("lab_");
+    if (!label_scope_.empty()) {
+      label += label_scope_ + "_";
+    }
+    return label + substr + "_" + std::to_string(no);
   }
 
-  std::string tmp_variable_name(int no) {
-    return std::string("t") + std::to_string(no);
+  // The name of temporary 'no', as the generators pass it to append(): a
+  // mark that no identifier can begin with, and the number. So a temporary
+  // is told from a variable by how it was made, not by its spelling, and a
+  // variable called t1 is not taken for one. It is written out as "t<no>".
+  std::string tmp_variable_name(int no) const {
+    return TempMark + std::to_string(no);
   }
 
   TAC::InstrType last_instr_type() {
@@ -111,36 +268,227 @@ class TAC {
     return (program_.back()).type;
   }
 
+  const std::vector<Quad>& program() const { return program_; }
+
+  // The text of 'operand'; empty for NoOperand.
+  std::string name(Operand operand) const {
+    if (operand == NoOperand) {
+      return std::string();
+    }
+    switch (operand_kind(operand)) {
+      case OperandKind::Temp:
+        return "t" + std::to_string(operand_index(operand));
+      case OperandKind::Constant:
+        return constants_.literal(operand_index(operand));
+      default:
+        return names_.name(operand_index(operand));
+    }
+  }
+
+  // Move the code of 'other', and its literals, to the end of this code,
+  // leaving 'other' empty.
+  // Labels waiting for the next instruction here label the first one of
+  // 'other', and those waiting in 'other' wait here.
+  void splice(TAC& other) {
+    // The names and literals of 'other' by their index here.
+    std::vector<uint32_t> names(other.names_.size());
+    for (uint32_t i = 0; i < names.size(); ++i) {
+      names[i] = names_.intern(other.names_.name(i));
+    }
+    std::vector<uint32_t> literals(other.constants_.size());
+    for (uint32_t c = 0; c < literals.size(); ++c) {
+      literals[c] =
+          constants_.add(other.constants_.literal(c), other.constants_[c]);
+    }
+    auto moved = [&](Operand operand) {
+      if (operand == NoOperand) {
+        return operand;
+      }
+      uint32_t index = operand_index(operand);
+      switch (operand_kind(operand)) {
+        case OperandKind::Variable:
+        case OperandKind::Label:
+          return make_operand(operand_kind(operand), names[index]);
+        case OperandKind::Constant:
+          return make_operand(OperandKind::Constant, literals[index]);
+        default:
+          return operand;
+      }
+    };
+
+    Operand first_label =
+        other.program_.empty() ? NoOperand : moved(other.program_[0].label);
+    if (!other.program_.empty() && !labels_.empty()) {
+      if (first_label == NoOperand) {
+        first_label = labels_.back();
+        labels_.pop_back();
+      }
+      for (Operand label : labels_) {
+        push(label, TAC::InstrType::GOTO, NoOperand, NoOperand, first_label);
+      }
+      labels_.clear();
+    }
+    program_.reserve(program_.size() + other.program_.size());
+    for (const Quad& q : other.program_) {
+      push(moved(q.label), q.type, moved(q.param1), moved(q.param2),
+           moved(q.result));
+    }
+    if (!other.program_.empty()) {
+      program_[program_.size() - other.program_.size()].label = first_label;
+    }
+    for (Operand label : other.labels_) {
+      labels_.push_back(moved(label));
+    }
+    other.clear();
+  }
+
+  // Write the code as text, one instruction a line, with the label, the
+  // operation and the operands right-aligned in their columns. The text is
+  // formatted into a buffer that is written out in large chunks.
   void output(std::ostream& os) {
-    for (auto q : program_) {
-      if (q.label.empty()) {
-        os << std::setw(17) << "";
+    write_text([&os](const char* text, size_t size) { os.write(text, size); });
+  }
+
+  // As above, to a file such as stdout.
+  void output(FILE* file) {
+    write_text([file](const char* text, size_t size) {
+      fwrite(text, 1, size, file);
+    });
+  }
+
+ private:
+  // Whether the result of 'itype' is a label to jump to.
+  static bool jumps(InstrType itype) {
+    return itype == InstrType::GOTO ||
+           (itype >= InstrType::LT && itype <= InstrType::NE) ||
+           (itype >= InstrType::ILT && itype <= InstrType::FNE);
+  }
+
+  // Begins the name of a temporary (see tmp_variable_name()).
+  static const char TempMark = '\x01';
+
+  // The operand that 'name' is, interned; a label if 'label'.
+  Operand operand(const std::string& name, bool label = false) {
+    if (name.empty()) {
+      return NoOperand;
+    }
+    if (label) {
+      return make_operand(OperandKind::Label, names_.intern(name));
+    }
+    if (name[0] >= '0' && name[0] <= '9') {
+      return make_operand(OperandKind::Constant, constants_.add(name));
+    }
+    if (name[0] == TempMark) {
+      uint32_t number = 0;
+      for (size_t i = 1; i < name.size(); ++i) {
+        number = number * 10 + (name[i] - '0');
+      }
+      return make_operand(OperandKind::Temp, number);
+    }
+    return make_operand(OperandKind::Variable, names_.intern(name));
+  }
+
+  // Bytes of text gathered before they are written out.
+  static const size_t TextChunk = 1 << 16;
+
+  template <typename Sink>
+  void write_text(Sink sink) {
+    text_.clear();
+    text_.reserve(TextChunk + 256);
+    for (const Quad& q : program_) {
+      if (q.label == NoOperand) {
+        text_.append(17, ' ');
       } else {
-        std::string label = q.label + ":";
-        os << std::setw(17) << std::right << label;
+        const std::string& label = names_.name(operand_index(q.label));
+        pad(label.size() + 1, 17);
+        text_.append(label).push_back(':');
       }
-      os << std::setw(8) << std::right << IName[q.type] << "  " << std::setw(17)
-         << q.param1 << "  " << std::setw(17) << q.param2 << "  "
-         << std::setw(17) << q.result << std::endl;
+      const std::string& instr = IName[q.type];
+      pad(instr.size(), 8);
+      text_.append(instr);
+      write_operand(q.param1);
+      write_operand(q.param2);
+      write_operand(q.result);
+      text_.push_back('\n');
+      if (text_.size() >= TextChunk) {
+        sink(text_.data(), text_.size());
+        text_.clear();
+      }
+    }
+    if (!text_.empty()) {
+      sink(text_.data(), text_.size());
     }
   }
 
- private:
-  std::string get_label() {
-    std::string label = "";
-    if (!labels_.empty()) {
-      while (labels_.size() > 1) {
-        program_.push_back(
-            Quad(labels_.front(), TAC::InstrType::GOTO, labels_.back()));
-        labels_.pop_front();
+  // Spaces before text of 'size' bytes right-aligned in 'width' columns.
+  void pad(size_t size, size_t width) {
+    if (size < width) {
+      text_.append(width - size, ' ');
+    }
+  }
+
+  // Two spaces, then 'operand' right-aligned in 17 columns.
+  void write_operand(Operand operand) {
+    text_.append(2, ' ');
+    if (operand == NoOperand) {
+      text_.append(17, ' ');
+      return;
+    }
+    uint32_t index = operand_index(operand);
+    switch (operand_kind(operand)) {
+      case OperandKind::Temp: {
+        char digits[11];
+        char* end = digits + sizeof(digits);
+        char* begin = end;
+        do {
+          *--begin = static_cast<char>('0' + index % 10);
+          index /= 10;
+        } while (index != 0);
+        *--begin = 't';
+        pad(end - begin, 17);
+        text_.append(begin, end);
+        break;
+      }
+      case OperandKind::Constant: {
+        const std::string& literal = constants_.literal(index);
+        pad(literal.size(), 17);
+        text_.append(literal);
+        break;
+      }
+      default: {
+        const std::string& name = names_.name(index);
+        pad(name.size(), 17);
+        text_.append(name);
+        break;
       }
-      label = labels_.front();
-      labels_.pop_front();
     }
+  }
+
+  void push(Operand label, InstrType itype, Operand param1, Operand param2,
+            Operand result) {
+    Quad q = {label, itype, param1, param2, result};
+    program_.push_back(q);
+  }
+
+  Operand get_label() {
+    if (labels_.empty()) {
+      return NoOperand;
+    }
+    for (size_t i = 0; i + 1 < labels_.size(); ++i) {
+      push(labels_[i], TAC::InstrType::GOTO, NoOperand, NoOperand,
+           labels_.back());
+    }
+    Operand label = labels_.back();
+    labels_.clear();
     return label;
   }
 
-  std::list<std::string> labels_;
-  std::list<Quad> program_;
+  std::vector<Operand> labels_;  // Waiting for the next instruction.
+  std::vector<Quad> program_;
+  bool typed_;
+  std::string label_scope_;
+  IdentifierTable names_;  // Of the variables, methods and labels.
+  ConstantPool constants_;
+  std::string text_;  // Reused by write_text().
 };
 #endif  // DECAFPARSER_TAC_H
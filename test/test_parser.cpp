@@ -1,9 +1,26 @@
 #define CATCH_CONFIG_MAIN
+#include <unistd.h>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include "ast_cache.h"
+#include "ast_visitor.h"
 #include "bparser.h"
 #include "catch.hpp"
+#include "dparser.h"
 #include "hparser.h"
+#include "iparser.h"
+#include "pparser.h"
+
+std::string get_parallel_ast(std::string filename) {
+  FILE* fin = fopen(filename.c_str(), "r");
+  PParser parser(fin, false, false);
+  parser.parse();
+  std::string ast = parser.get_AST()->str();
+  fclose(fin);
+  return ast;
+}
 
 std::string get_ast(std::string filename, bool handmade = false) {
   FILE* fin = fopen(filename.c_str(), "r");
@@ -16,6 +33,24 @@ std::string get_ast(std::string filename, bool handmade = false) {
   return ast;
 }
 
+std::string get_tac(FILE* fin, bool direct, bool typed = false) {
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  tac.set_typed(typed);
+  if (direct) {
+    DParser parser(fin, data, tac, false, false);
+    parser.parse();
+  } else {
+    BParser parser(fin, false, false);
+    parser.parse();
+    parser.get_AST()->icg(data, tac);
+  }
+  std::ostringstream os;
+  tac.output(os);
+  return os.str();
+}
+
 TEST_CASE("compare asts") {
   for (auto filename : {"test.decaf", "test2.decaf", "demo.decaf"}) {
     std::cerr << "checking " << filename << std::endl;
@@ -27,3 +62,1164 @@ TEST_CASE("compare asts") {
     std::cerr << std::endl;
   }
 }
+
+TEST_CASE("pipelined parse matches sequential parse") {
+  for (auto filename : {"test.decaf", "test2.decaf", "demo.decaf"}) {
+    FILE* fin = fopen(filename, "r");
+    HParser parser(fin, false, false, true);
+    parser.parse();
+    REQUIRE(parser.get_AST()->str() == get_ast(filename, true));
+    fclose(fin);
+  }
+}
+
+TEST_CASE("parallel parse matches sequential parse") {
+  for (auto filename : {"test.decaf", "test2.decaf", "demo.decaf"}) {
+    REQUIRE(get_parallel_ast(filename) == get_ast(filename));
+  }
+}
+
+TEST_CASE("direct code generation matches icg") {
+  std::string src =
+      "class C {\n"
+      "  int a, b;\n"
+      "  static int f(int x, real y) {\n"
+      "    if (x < 1 || x > 9 && !(y == 2.0) || a) { return -x; }\n"
+      "    else { if (a) { a++; } }\n"
+      "    return x * 2 + a % 3;\n"
+      "  }\n"
+      "  static void main() {\n"
+      "    int i;\n"
+      "    for (i = 0; i < 10 && b != 1; i++) {\n"
+      "      if (i == 3) { continue; }\n"
+      "      b = f(i, 1.5) - (b / 2);\n"
+      "      writeln(b);\n"
+      "    }\n"
+      "  }\n"
+      "}\n";
+  std::string tacs[2];
+  for (int direct = 0; direct < 2; ++direct) {
+    FILE* fin = tmpfile();
+    fputs(src.c_str(), fin);
+    rewind(fin);
+    tacs[direct] = get_tac(fin, direct == 1);
+    fclose(fin);
+  }
+  REQUIRE(tacs[1] == tacs[0]);
+
+  FILE* fin = fopen("test2.decaf", "r");
+  std::string direct_tac = get_tac(fin, true);
+  rewind(fin);
+  REQUIRE(direct_tac == get_tac(fin, false));
+  fclose(fin);
+}
+
+TEST_CASE("prescan finds method boundaries") {
+  std::string src =
+      "class C { int a; /* static { */\n"
+      "  static void f() { { } }\n"
+      "  static int g(int x) { return x; }\n"
+      "}\n";
+  Prescan scan = prescan(src);
+  REQUIRE(scan.ok);
+  REQUIRE(scan.methods.size() == 2);
+  REQUIRE(src.substr(scan.methods[0].begin,
+                     scan.methods[0].end - scan.methods[0].begin) ==
+          "static void f() { { } }");
+  REQUIRE(scan.methods[1].line == 3);
+  REQUIRE(scan.methods[1].col == 3);
+  REQUIRE_FALSE(prescan("class C { static void f() { }").ok);
+  REQUIRE_FALSE(prescan("class C { static void f() { } int a; }").ok);
+}
+
+TEST_CASE("incremental reparse matches full parse") {
+  std::string src =
+      "class C {\n"
+      "  int g;\n"
+      "  static int f(int x) { return x + 1; }\n"
+      "  static void main() { g = f(2); writeln(g); }\n"
+      "}\n";
+  IParser parser(src, false, false);
+  parser.parse();
+  ProgramNode* program = static_cast<ProgramNode*>(parser.get_AST());
+  MethodNode* main_method = program->get_method_decls()->back();
+
+  // An edit inside f re-parses f only.
+  size_t offset = src.find("x + 1");
+  REQUIRE(parser.edit(offset, 5, "x * (x - 1)"));
+  REQUIRE(program->get_method_decls()->back() == main_method);
+
+  // An edit that adds a method is parsed from scratch.
+  REQUIRE_FALSE(parser.edit(parser.get_source().find("  static void"), 0,
+                            "  static void h() { }\n"));
+
+  std::string edited = parser.get_source();
+  HParser full(edited.data(), edited.size(), 1, 1, false, false);
+  full.parse();
+  REQUIRE(parser.get_AST()->str() == full.get_AST()->str());
+}
+
+TEST_CASE("handmade parser recovers from syntax errors") {
+  std::string src =
+      "class C {\n"
+      "  int a b;\n"
+      "  static void f() {\n"
+      "    a = 1\n"
+      "    a = (2 + ;\n"
+      "    if (a) { a = a +; } else { a--; }\n"
+      "  }\n"
+      "  static void main() {\n"
+      "    f();\n"
+      "    a = 3;\n"
+      "  }\n"
+      "}\n";
+  HParser parser(src.data(), src.size(), 1, 1, false, false);
+  std::ostringstream messages;
+  parser.set_output(messages);
+  REQUIRE(parser.parse() == 1);
+  REQUIRE(parser.error_count() == 4);
+  // The missing ';' is reported where the next statement starts.
+  REQUIRE(messages.str().find("(line 5, col 5): expected token ptSemicolon") !=
+          std::string::npos);
+
+  // Both methods are kept, with the statements that parsed.
+  ProgramNode* program = static_cast<ProgramNode*>(parser.get_AST());
+  REQUIRE(program != nullptr);
+  REQUIRE(program->get_method_decls()->size() == 2);
+  REQUIRE(program->get_method_decls()->back()->str() ==
+          "(METHOD void main (CALL f)(= (VAR a) (NUM 3)))");
+
+  // A ';' in the head of a for loop does not end the statement being skipped.
+  std::string loop =
+      "class C {\n"
+      "  static void f() {\n"
+      "    for (;;) { }\n"
+      "    f();\n"
+      "  }\n"
+      "}\n";
+  HParser loop_parser(loop.data(), loop.size(), 1, 1, false, false);
+  std::ostringstream loop_messages;
+  loop_parser.set_output(loop_messages);
+  loop_parser.parse();
+  REQUIRE(loop_parser.error_count() == 1);
+  REQUIRE(static_cast<ProgramNode*>(loop_parser.get_AST())
+              ->get_method_decls()
+              ->front()
+              ->str() == "(METHOD void f (CALL f))");
+
+  // The parallel parser reports a ';' missing after the last field as the
+  // sequential one does, against the "static" that follows.
+  std::string head = "class C {\n  int a\n  static void f() { }\n}\n";
+  HParser sequential(head.data(), head.size(), 1, 1, false, false);
+  std::ostringstream expected;
+  sequential.set_output(expected);
+  sequential.parse();
+  std::ostringstream parallel;
+  int errors = 0;
+  delete parse_prescanned(head, prescan(head), false, false, parallel, errors);
+  REQUIRE(errors == 1);
+  REQUIRE(parallel.str() == expected.str());
+}
+
+TEST_CASE("code generation reports every error") {
+  std::string src =
+      "class C {\n"
+      "  static void f() { break; x = 1; }\n"
+      "  static void g() { h(); }\n"
+      "}\n";
+  HParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  // Break outside a loop, undeclared x and h, and no main method.
+  REQUIRE(data.error_count == 4);
+}
+
+TEST_CASE("deeply nested code does not overflow the stack") {
+  const int Depth = 200000;
+  std::string expr;
+  for (int i = 0; i < Depth; ++i) {
+    expr += "1 + (";
+  }
+  expr += "1" + std::string(Depth, ')');
+  std::string block;
+  for (int i = 0; i < Depth; ++i) {
+    block += "{ ";
+  }
+  block += "a = 1;" + std::string(Depth, '}');
+  std::string src = "class C {\n  int a;\n  static void main() {\n    a = " +
+                    expr + ";\n    " + block + "\n  }\n}\n";
+
+  HParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 0);
+  REQUIRE(data.variable_no == Depth);
+}
+
+TEST_CASE("direct code generation scans deeply nested loops once") {
+  // Each loop asks whether its variable is assigned in its block, which for
+  // all but the outermost one, by the v0 = 1, takes the whole block.
+  const int Depth = 4000;
+  std::string vars = "v0";
+  std::string loops;
+  for (int i = 0; i < Depth; ++i) {
+    std::string var = "v" + std::to_string(i);
+    if (i > 0) {
+      vars += ", " + var;
+    }
+    loops += "for (" + var + " = 0; " + var + " < 2; " + var + "++) { ";
+  }
+  loops += "a[v1] = a[v0]; v0 = 1;" + std::string(Depth, '}');
+  std::string src =
+      "class C {\n  static void main() {\n    int a[2];\n    int " + vars +
+      ";\n    " + loops + "\n  }\n}\n";
+
+  HParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 0);
+  std::ostringstream expected;
+  tac.output(expected);
+  // Only a[v0] is checked: v1 is within the array in the loops over it.
+  std::string code = expected.str();
+  REQUIRE(code.find("BOUNDS") != std::string::npos);
+  REQUIRE(code.find("BOUNDS") == code.rfind("BOUNDS"));
+
+  FILE* fin = tmpfile();
+  fputs(src.c_str(), fin);
+  rewind(fin);
+  REQUIRE(get_tac(fin, true) == code);
+  fclose(fin);
+}
+
+TEST_CASE("streaming ast printer matches indented str") {
+  for (auto filename : {"test.decaf", "test2.decaf", "demo.decaf"}) {
+    FILE* fin = fopen(filename, "r");
+    BParser parser(fin, false, false);
+    parser.parse();
+    fclose(fin);
+
+    // How -a printed the tree before it was streamed.
+    std::string str = parser.get_AST()->str();
+    std::string expected;
+    int indent = 0;
+    for (char c : str) {
+      if (c == '(') {
+        expected += '\n' + std::string(indent, ' ');
+        indent += AstPrinter::IndentLevel;
+      } else if (c == ')') {
+        indent -= AstPrinter::IndentLevel;
+      }
+      expected += c;
+    }
+
+    std::ostringstream os;
+    {
+      AstPrinter printer(os, true);
+      printer << parser.get_AST();
+    }
+    REQUIRE(os.str() == expected);
+  }
+}
+
+TEST_CASE("flat ast converts back unchanged") {
+  for (auto filename : {"test.decaf", "test2.decaf", "demo.decaf"}) {
+    FILE* fin = fopen(filename, "r");
+    BParser parser(fin, false, false);
+    parser.parse();
+    fclose(fin);
+    auto program = static_cast<ProgramNode*>(parser.get_AST());
+
+    FlatAst flat;
+    flatten(program, flat);
+    REQUIRE(flat.check());
+    REQUIRE(unflatten(flat)->str() == program->str());
+  }
+}
+
+TEST_CASE("flat icg matches icg") {
+  for (auto filename : {"test2.decaf", "demo.decaf"}) {
+    FILE* fin = fopen(filename, "r");
+    BParser parser(fin, false, false);
+    parser.parse();
+    fclose(fin);
+
+    SymbolTable st;
+    Data data(st);
+    TAC tac;
+    parser.get_AST()->icg(data, tac);
+    std::ostringstream expected;
+    tac.output(expected);
+
+    FlatAst flat;
+    flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+    SymbolTable flat_st;
+    Data flat_data(flat_st);
+    TAC flat_tac;
+    flat_icg(flat, flat_data, flat_tac);
+    std::ostringstream os;
+    flat_tac.output(os);
+    REQUIRE(os.str() == expected.str());
+    REQUIRE(flat_data.error_count == data.error_count);
+  }
+
+  // The diagnostics are the same, down to their ids.
+  std::string src =
+      "class C {\n"
+      "  static void main() { break; continue; }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  FlatAst flat;
+  flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+  std::string messages[2];
+  for (int i = 0; i < 2; ++i) {
+    SymbolTable st;
+    Data data(st);
+    data.diagnostics.set_format(Diagnostics::Format::Located);
+    TAC tac;
+    if (i == 0) {
+      parser.get_AST()->icg(data, tac);
+    } else {
+      flat_icg(flat, data, tac);
+    }
+    std::ostringstream os;
+    data.diagnostics.flush(os);
+    messages[i] = os.str();
+  }
+  REQUIRE(messages[0].find("[continue-outside-loop]") != std::string::npos);
+  REQUIRE(messages[1] == messages[0]);
+}
+
+TEST_CASE("serialized ast loads back unchanged") {
+  for (auto filename : {"test.decaf", "test2.decaf", "demo.decaf"}) {
+    FILE* fin = fopen(filename, "r");
+    std::string src = read_source(fin);
+    fclose(fin);
+    BParser parser(src.data(), src.size(), 1, 1, false, false);
+    parser.parse();
+    FlatAst flat;
+    flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+
+    uint64_t hash = source_hash(src);
+    size_t n = src.size();
+    std::string bytes = serialize_ast(flat, hash, n);
+    FlatAst loaded;
+    REQUIRE(deserialize_ast(bytes.data(), bytes.size(), hash, n, loaded));
+    REQUIRE(unflatten(loaded)->str() == parser.get_AST()->str());
+
+    // Another source's entry, or a damaged one, is not used.
+    REQUIRE(!deserialize_ast(bytes.data(), bytes.size(), hash + 1, n, loaded));
+    REQUIRE(!deserialize_ast(bytes.data(), bytes.size(), hash, n + 1, loaded));
+    REQUIRE(!deserialize_ast(bytes.data(), bytes.size() - 4, hash, n, loaded));
+    bytes[sizeof(AstFileHeader)] = char(NodeKindCount);
+    REQUIRE(!deserialize_ast(bytes.data(), bytes.size(), hash, n, loaded));
+  }
+}
+
+TEST_CASE("ast cache is keyed by the source") {
+  char dir[] = "/tmp/decaf_cache_XXXXXX";
+  REQUIRE(mkdtemp(dir) != nullptr);
+  AstCache cache(dir);
+  std::string src = "class C {\n  static void main() { }\n}\n";
+  FlatAst flat;
+  REQUIRE(!cache.load(src, flat));
+
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+  REQUIRE(cache.store(src, flat));
+  FlatAst loaded;
+  REQUIRE(cache.load(src, loaded));
+  REQUIRE(unflatten(loaded)->str() == parser.get_AST()->str());
+  REQUIRE(!cache.load(src + " ", loaded));
+
+  remove(cache.path(source_hash(src)).c_str());
+  rmdir(dir);
+}
+
+TEST_CASE("node kinds support isa and cast") {
+  NumberExprNode one("1");
+  VariableExprNode a("a");
+  LtExprNode lt(&a, &one);
+  MethodCallExprStmNode call("f", new std::list<ExprNode*>{&lt});
+  const Node* node = &lt;
+  REQUIRE(node->kind() == NodeKind::Lt);
+  REQUIRE(isa<ExprNode>(node));
+  REQUIRE(isa<RelationalExprNode>(node));
+  REQUIRE(!isa<ArithmeticExprNode>(node));
+  REQUIRE(!isa<StmNode>(node));
+  REQUIRE(cast<LtExprNode>(node)->get_rhs() == &one);
+  REQUIRE(dyn_cast<NumberExprNode>(node) == nullptr);
+
+  const StmNode* stm = &call;
+  REQUIRE(isa<ExprNode>(stm));
+  REQUIRE(cast<MethodCallExprStmNode>(stm)->get_id() == "f");
+}
+
+// Names the fallback that each node reaches.
+class Classifier : public AstVisitor<Classifier, std::string> {
+ public:
+  std::string visit_number(const NumberExprNode*) { return "number"; }
+  std::string visit_relational(const RelationalExprNode*) {
+    return "relational";
+  }
+  std::string visit_expr(const ExprNode*) { return "expr"; }
+  std::string visit_stm(const StmNode*) { return "stm"; }
+  std::string visit_node(const Node*) { return "node"; }
+};
+
+TEST_CASE("visitor dispatches on the node kind") {
+  NumberExprNode one("1");
+  VariableExprNode a("a");
+  GteExprNode gte(&a, &one);
+  PlusExprNode plus(&a, &one);
+  MethodCallExprStmNode call("f", new std::list<ExprNode*>());
+  BreakStmNode brk;
+  ParameterNode param(ValueType::IntVal, &a);
+
+  Classifier classifier;
+  REQUIRE(classifier.visit(&one) == "number");
+  REQUIRE(classifier.visit(&gte) == "relational");
+  REQUIRE(classifier.visit(&plus) == "expr");
+  REQUIRE(classifier.visit(static_cast<StmNode*>(&call)) == "expr");
+  REQUIRE(classifier.visit(&brk) == "stm");
+  REQUIRE(classifier.visit(&param) == "node");
+  REQUIRE(classifier.visit(static_cast<const Node*>(&gte)) == "relational");
+}
+
+TEST_CASE("hash-consing shares identical expressions") {
+  std::string src =
+      "class C {\n"
+      "  static int g(int b) { return b * b; }\n"
+      "  static int f(int b, int mod) {\n"
+      "    return (b * b) % mod + g((b * b) % mod) + (b * b) % mod;\n"
+      "  }\n"
+      "  static void main() { f(2, 7); }\n"
+      "}\n";
+  for (bool handmade : {false, true}) {
+    Parser* plain =
+        handmade ? static_cast<Parser*>(
+                       new HParser(src.data(), src.size(), 1, 1, false, false))
+                 : static_cast<Parser*>(
+                       new BParser(src.data(), src.size(), 1, 1, false, false));
+    Parser* shared =
+        handmade ? static_cast<Parser*>(
+                       new HParser(src.data(), src.size(), 1, 1, false, false))
+                 : static_cast<Parser*>(
+                       new BParser(src.data(), src.size(), 1, 1, false, false));
+    shared->set_hash_consing(true);
+    REQUIRE(plain->parse() == 0);
+    REQUIRE(shared->parse() == 0);
+    REQUIRE(shared->get_AST()->str() == plain->get_AST()->str());
+    REQUIRE(shared->hash_cons_table()->hits() > 0);
+
+    // (+ (+ x (g x)) x), where x is (% (* b b) mod), is one x three times.
+    auto program = cast<ProgramNode>(shared->get_AST());
+    auto f = *std::next(program->get_method_decls()->begin());
+    auto ret = cast<ReturnStmNode>(f->get_stms()->front());
+    auto sum = cast<PlusExprNode>(ret->get_expr());
+    auto inner = cast<PlusExprNode>(sum->get_lhs());
+    auto call = cast<MethodCallExprStmNode>(inner->get_rhs());
+    REQUIRE(inner->get_lhs() == sum->get_rhs());
+    REQUIRE(call->get_args()->front() == sum->get_rhs());
+
+    // Methods do not share nodes: 'b' in g is not 'b' in f.
+    auto g = program->get_method_decls()->front();
+    auto g_ret = cast<ReturnStmNode>(g->get_stms()->front());
+    auto g_mult = cast<MultiplyExprNode>(g_ret->get_expr());
+    auto f_mult = cast<MultiplyExprNode>(
+        cast<ModulusExprNode>(sum->get_rhs())->get_lhs());
+    REQUIRE(g_mult->get_lhs() == g_mult->get_rhs());
+    REQUIRE(g_mult->get_lhs() != f_mult->get_lhs());
+
+    SymbolTable plain_st, shared_st;
+    Data plain_data(plain_st), shared_data(shared_st);
+    TAC plain_tac, shared_tac;
+    plain->get_AST()->icg(plain_data, plain_tac);
+    shared->get_AST()->icg(shared_data, shared_tac);
+    std::ostringstream expected, os;
+    plain_tac.output(expected);
+    shared_tac.output(os);
+    REQUIRE(os.str() == expected.str());
+    delete plain;
+    delete shared;
+  }
+}
+
+TEST_CASE("symbol table resolves names through scopes") {
+  SymbolTable st;
+  SymbolTable::Entry entry;
+  entry.entry_type = EntryType::Variable;
+  entry.value_type = ValueType::IntVal;
+  for (int i = 0; i < 200; ++i) {
+    entry.scope = (i % 2 == 0 ? "" : "f" + std::to_string(i % 7));
+    entry.name = "v" + std::to_string(i);
+    st.add(entry);
+  }
+  REQUIRE(st.size() == 200);
+  SymbolTable::Entry* v1 = st.lookup("f1", "v1");
+  REQUIRE(v1 != nullptr);
+  REQUIRE(v1->name == "v1");
+  REQUIRE(st.lookup("", "v1") == nullptr);
+  REQUIRE(st.lookup("f1", "v2") == nullptr);
+  REQUIRE(st.lookup("nowhere", "v1") == nullptr);
+  REQUIRE(st.resolve("f1", "v1") == v1);
+  REQUIRE(st.resolve("f1", "v2") == st.lookup("", "v2"));
+  REQUIRE(st.resolve("", "v1") == nullptr);
+  REQUIRE(st.resolve(st.id("f1"), st.id("v1")) == v1);
+
+  // Adding again overrides the entry in place.
+  entry.scope = "f1";
+  entry.name = "v1";
+  entry.value_type = ValueType::RealVal;
+  REQUIRE(st.add(entry) == v1);
+  REQUIRE(v1->value_type == ValueType::RealVal);
+  REQUIRE(st.size() == 200);
+
+  // Dumped in the order of "scope::name", so "f1" comes after "f10".
+  entry.scope = "f10";
+  st.add(entry);
+  std::list<SymbolTable::Entry> entries = st.entries();
+  REQUIRE(entries.size() == 201);
+  std::vector<std::string> keys;
+  for (const SymbolTable::Entry& e : entries) {
+    keys.push_back(e.scope + "::" + e.name);
+  }
+  REQUIRE(std::is_sorted(keys.begin(), keys.end()));
+}
+
+TEST_CASE("name resolution binds uses to their declarations") {
+  std::string src =
+      "class C {\n"
+      "  int x;\n"
+      "  real y;\n"
+      "  static int f(int x) {\n"
+      "    y = x + z;\n"
+      "    return f(x) + g();\n"
+      "  }\n"
+      "  static int g() { return 0; }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 3);  // z, g and main.
+
+  auto f = cast<ProgramNode>(parser.get_AST())->get_method_decls()->front();
+  auto assign = cast<AssignStmNode>(f->get_stms()->front());
+  auto sum = cast<PlusExprNode>(assign->get_expr());
+  REQUIRE(assign->get_var()->get_symbol(data) == st.lookup("", "y"));
+  REQUIRE(cast<VariableExprNode>(sum->get_lhs())->get_symbol(data) ==
+          st.lookup("f", "x"));
+  REQUIRE(cast<VariableExprNode>(sum->get_rhs())->get_symbol(data) == nullptr);
+
+  // g is declared after f, so it is not yet known there.
+  auto ret = cast<ReturnStmNode>(f->get_stms()->back());
+  auto calls = cast<PlusExprNode>(ret->get_expr());
+  auto call_f = cast<MethodCallExprStmNode>(calls->get_lhs());
+  REQUIRE(call_f->get_symbol(data) == st.lookup("", "f"));
+  REQUIRE(call_f->get_symbol(data)->signature == Signature{ValueType::IntVal});
+  REQUIRE(cast<MethodCallExprStmNode>(calls->get_rhs())->get_symbol(data) ==
+          nullptr);
+}
+
+TEST_CASE("typed code converts between int and real") {
+  std::string src =
+      "class C {\n"
+      "  static real h(real r) { return r * 2; }\n"
+      "  static int f(int i, real r) {\n"
+      "    r = i + h(i) - r;\n"
+      "    if (i < r) { i = r; i++; }\n"
+      "    if (r || !r) { i--; }\n"
+      "    return -r;\n"
+      "  }\n"
+      "  static void main() { f(1, 2); }\n"
+      "}\n";
+  std::string tacs[2];
+  for (int direct = 0; direct < 2; ++direct) {
+    FILE* fin = tmpfile();
+    fputs(src.c_str(), fin);
+    rewind(fin);
+    tacs[direct] = get_tac(fin, direct == 1, true);
+    fclose(fin);
+  }
+  REQUIRE(tacs[1] == tacs[0]);
+  for (auto instr : {"IADD", "ISUB", "FMULT", "FLT", "FUMINUS", "ITOF",
+                     "FTOI", "FNE"}) {
+    REQUIRE(tacs[0].find(instr) != std::string::npos);
+  }
+  // A real condition is tested against a real zero.
+  std::istringstream lines(tacs[0]);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream fields(line);
+    std::string field, lhs, rhs;
+    while (fields >> field && field != "FNE" && field != "FEQ") {
+    }
+    if (fields >> lhs >> rhs) {
+      REQUIRE(rhs != "0");
+    }
+  }
+
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  FlatAst flat;
+  flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  tac.set_typed(true);
+  flat_icg(flat, data, tac);
+  std::ostringstream os;
+  tac.output(os);
+  REQUIRE(os.str() == tacs[0]);
+
+  // Untyped code is as it has always been.
+  FILE* fin = fopen("test2.decaf", "r");
+  std::string typed_tac = get_tac(fin, false, true);
+  rewind(fin);
+  std::string tac_untyped = get_tac(fin, false);
+  fclose(fin);
+  REQUIRE(tac_untyped.find("ITOF") == std::string::npos);
+  REQUIRE(tac_untyped.find("IADD") == std::string::npos);
+  REQUIRE(typed_tac != tac_untyped);
+}
+
+TEST_CASE("diagnostics are buffered until flushed") {
+  std::string src =
+      "class C {\n"
+      "  static void main() {\n"
+      "    int i;\n"
+      "    i = 1.5;\n"
+      "    i = 1.5;\n"
+      "    x = 2;\n"
+      "  }\n"
+      "}\n";
+  FILE* fin = tmpfile();
+  fputs(src.c_str(), fin);
+  rewind(fin);
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  DParser parser(fin, data, tac, false, false);
+  REQUIRE(parser.parse() == 0);
+  fclose(fin);
+  REQUIRE(data.error_count == 1);
+  REQUIRE(data.diagnostics.size() == 3);
+  REQUIRE(data.diagnostics.count(Severity::Warning) == 2);
+
+  std::ostringstream os;
+  data.diagnostics.flush(os);
+  REQUIRE(os.str() ==
+          "WARNING: Type mismatch in assigning to variable 'i'.\n"
+          "WARNING: Type mismatch in assigning to variable 'i'.\n"
+          "ERROR: Undeclared identifier 'x'.\n");
+  REQUIRE(data.diagnostics.size() == 0);
+
+  Diagnostics diagnostics;
+  diagnostics.set_format(Diagnostics::Format::Located);
+  diagnostics.set_deduplicate(true);
+  diagnostics.set_limit(2);
+  for (int i = 0; i < 3; ++i) {
+    diagnostics.report(Severity::Warning, DiagId::AssignType, "w",
+                       SourceLocation(4, 12));
+  }
+  diagnostics.report(Severity::Warning, DiagId::AssignType, "w",
+                     SourceLocation(5, 12));
+  diagnostics.report(Severity::Error, DiagId::MissingMain, "e");
+  REQUIRE(diagnostics.count(Severity::Warning) == 4);
+  REQUIRE(diagnostics.count(Severity::Error) == 1);
+  std::ostringstream located;
+  diagnostics.flush(located);
+  REQUIRE(located.str() ==
+          "4:12: warning: w [assign-type]\n"
+          "5:12: warning: w [assign-type]\n"
+          "1 more diagnostics not shown.\n");
+
+  // Both parsers locate statements and declarations, and what is reported
+  // while generating their code is reported there.
+  std::string located_src =
+      "class C {\n"
+      "  int a;\n"
+      "  int a;\n"
+      "  static void main() {\n"
+      "    if (a) { break; }\n"
+      "  }\n"
+      "}\n";
+  for (int handmade = 0; handmade < 2; ++handmade) {
+    const char* bytes = located_src.data();
+    size_t size = located_src.size();
+    Parser* parser = nullptr;
+    if (handmade) {
+      parser = new HParser(bytes, size, 1, 1, false, false);
+    } else {
+      parser = new BParser(bytes, size, 1, 1, false, false);
+    }
+    REQUIRE(parser->parse() == 0);
+    SymbolTable st;
+    Data data(st);
+    data.diagnostics.set_format(Diagnostics::Format::Located);
+    TAC tac;
+    parser->get_AST()->icg(data, tac);
+    std::ostringstream os;
+    data.diagnostics.flush(os);
+    REQUIRE(os.str() ==
+            "3:3: error: Identifier 'a' already declared in scope. "
+            "[redeclared]\n"
+            "5:14: error: Break statement used outside a loop. "
+            "[break-outside-loop]\n");
+    delete parser;
+  }
+}
+
+TEST_CASE("parallel code generation is deterministic") {
+  std::string src =
+      "class C {\n"
+      "  int a;\n"
+      "  static int g(int x) { return g(x - 1) + a * 2.0; }\n"
+      "  static int f(int x) {\n"
+      "    if (x < 1) { return g(x); } else { return x; }\n"
+      "  }\n"
+      "  static void main() { a = f(3); }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  auto program = static_cast<ProgramNode*>(parser.get_AST());
+  std::string tacs[2];
+  std::string messages[2];
+  for (int i = 0; i < 2; ++i) {
+    SymbolTable st;
+    Data data(st);
+    TAC tac;
+    parallel_icg(program, data, tac, i == 0 ? 1 : 8);
+    REQUIRE(data.error_count == 0);
+    std::ostringstream os, diagnostics;
+    tac.output(os);
+    data.diagnostics.flush(diagnostics);
+    tacs[i] = os.str();
+    messages[i] = diagnostics.str();
+  }
+  REQUIRE(tacs[1] == tacs[0]);
+  REQUIRE(messages[1] == messages[0]);
+  REQUIRE(messages[0] ==
+          "WARNING: Mixing int and real types in operation MULT.\n");
+  REQUIRE(tacs[0].find("lab_f_rel_true_1") != std::string::npos);
+  // f ends with the label after its if, which goes to main.
+  REQUIRE(tacs[0].find("lab_f_if_end_0:    GOTO") != std::string::npos);
+  // Each method numbers its temporaries from 0.
+  REQUIRE(tacs[0].find("g:  FPARAM") != std::string::npos);
+  REQUIRE(tacs[0].find("t0  ") != tacs[0].rfind("t0  "));
+}
+
+TEST_CASE("parallel code generation rejects calls to later methods") {
+  std::string src =
+      "class C {\n"
+      "  static int f(int x) { return g(x) + f(x - 1); }\n"
+      "  static int g(int x) { return f(x); }\n"
+      "  static void main() { writeln(g(1)); }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  auto program = static_cast<ProgramNode*>(parser.get_AST());
+  std::string messages[2];
+  for (int i = 0; i < 2; ++i) {
+    SymbolTable st;
+    Data data(st);
+    TAC tac;
+    if (i == 0) {
+      program->icg(data, tac);
+    } else {
+      parallel_icg(program, data, tac, 8);
+    }
+    // g is called in f before it is declared.
+    REQUIRE(data.error_count == 1);
+    std::ostringstream diagnostics;
+    data.diagnostics.flush(diagnostics);
+    messages[i] = diagnostics.str();
+  }
+  REQUIRE(messages[1] == messages[0]);
+  REQUIRE(messages[0].find("'g' undeclared") != std::string::npos);
+}
+
+TEST_CASE("number literals are parsed into a constant pool") {
+  Constant constant;
+  REQUIRE(parse_literal("9223372036854775807", constant));
+  REQUIRE(constant.type == ValueType::IntVal);
+  REQUIRE(constant.int_value == INT64_MAX);
+  REQUIRE_FALSE(parse_literal("9223372036854775808", constant));
+  REQUIRE(parse_literal("0.1", constant));
+  REQUIRE(constant.type == ValueType::RealVal);
+  REQUIRE(constant.real_value == 0.1);
+  REQUIRE(parse_literal("12.5E-3", constant));
+  REQUIRE(constant.real_value == 12.5E-3);
+  REQUIRE(parse_literal("1.00000000000000000000001E300", constant));
+  REQUIRE(constant.real_value == 1E300);
+  REQUIRE_FALSE(parse_literal("1E400", constant));
+
+  std::string src =
+      "class C {\n"
+      "  static void main() {\n"
+      "    real r;\n"
+      "    r = 1.5 + 1.5 * 2;\n"
+      "    r = 99999999999999999999;\n"
+      "  }\n"
+      "}\n";
+  // The parsers report a literal out of range where they read it, and code
+  // generation takes it as it is.
+  for (int handmade = 0; handmade < 2; ++handmade) {
+    Parser* parser = nullptr;
+    if (handmade) {
+      parser = new HParser(src.data(), src.size(), 1, 1, false, false);
+    } else {
+      parser = new BParser(src.data(), src.size(), 1, 1, false, false);
+    }
+    std::ostringstream messages;
+    parser->set_output(messages);
+    REQUIRE(parser->parse() == 1);
+    REQUIRE(parser->error_count() == 1);
+    REQUIRE(messages.str() ==
+            "Error (line 5, col 9): Number '99999999999999999999' is out of "
+            "range.\n");
+    delete parser;
+  }
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  std::ostringstream messages;
+  parser.set_output(messages);
+  parser.parse();
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 0);
+  const ConstantPool& pool = tac.constants();
+  REQUIRE(pool.size() == 3);
+  REQUIRE(pool[pool.find("1.5")].real_value == 1.5);
+  REQUIRE(pool[pool.find("2")].int_value == 2);
+  REQUIRE_FALSE(pool[pool.find("99999999999999999999")].in_range);
+
+  FILE* fin = tmpfile();
+  fputs(src.c_str(), fin);
+  rewind(fin);
+  SymbolTable direct_st;
+  Data direct_data(direct_st);
+  TAC direct_tac;
+  DParser direct(fin, direct_data, direct_tac, false, false);
+  REQUIRE(direct.parse() == 0);
+  fclose(fin);
+  REQUIRE(direct_data.error_count == 1);
+  REQUIRE(direct_tac.constants().size() == 3);
+}
+
+TEST_CASE("constants are substituted into the code") {
+  std::string src =
+      "class C {\n"
+      "  static final int P = 1000000007;\n"
+      "  int a;\n"
+      "  static final real HALF = 0.5;\n"
+      "  static int f(int x) { return x % P; }\n"
+      "  static void main() { a = f(P - 1); writeln(HALF * a); }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  HParser handmade(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(handmade.parse() == 0);
+  REQUIRE(handmade.get_AST()->str() == parser.get_AST()->str());
+  REQUIRE(prescan(src).ok);
+  REQUIRE(prescan(src).methods.size() == 2);
+
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 0);
+  REQUIRE(st.lookup("", "P")->entry_type == EntryType::Constant);
+  std::ostringstream expected;
+  tac.output(expected);
+  REQUIRE(expected.str().find(" P\n") == std::string::npos);
+  REQUIRE(expected.str().find("1000000007") != std::string::npos);
+
+  FlatAst flat;
+  flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+  REQUIRE(flat.check());
+  REQUIRE(unflatten(flat)->str() == parser.get_AST()->str());
+  SymbolTable flat_st;
+  Data flat_data(flat_st);
+  TAC flat_tac;
+  flat_icg(flat, flat_data, flat_tac);
+  std::ostringstream os;
+  flat_tac.output(os);
+  REQUIRE(os.str() == expected.str());
+
+  FILE* fin = tmpfile();
+  fputs(src.c_str(), fin);
+  rewind(fin);
+  REQUIRE(get_tac(fin, true) == expected.str());
+  fclose(fin);
+
+  std::string bad =
+      "class C {\n"
+      "  static final int N = 2;\n"
+      "  static void main() { N = 3; N++; }\n"
+      "}\n";
+  BParser bad_parser(bad.data(), bad.size(), 1, 1, false, false);
+  REQUIRE(bad_parser.parse() == 0);
+  SymbolTable bad_st;
+  Data bad_data(bad_st);
+  TAC bad_tac;
+  bad_parser.get_AST()->icg(bad_data, bad_tac);
+  REQUIRE(bad_data.error_count == 2);
+}
+
+TEST_CASE("arrays are loaded and stored with bounds checks") {
+  std::string src =
+      "class C {\n"
+      "  static final int N = 8;\n"
+      "  real r[N];\n"
+      "  static void main() {\n"
+      "    int a[N];\n"
+      "    int i, j;\n"
+      "    for (i = 0; i < N; i++) { a[i] = i * 2; r[i] = a[i]; }\n"
+      "    j = 3;\n"
+      "    a[j] = a[7] + 1;\n"
+      "    writeln(r[a[j]]);\n"
+      "  }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  HParser handmade(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(handmade.parse() == 0);
+  REQUIRE(handmade.get_AST()->str() == parser.get_AST()->str());
+
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 0);
+  REQUIRE(st.lookup("main", "a")->array_size == 8);
+  std::ostringstream expected;
+  tac.output(expected);
+  // Only the a[j] and r[a[j]] outside the loop are checked: i is within both
+  // arrays in the loop, and 7 is checked at compile time.
+  std::string code = expected.str();
+  size_t checks = 0;
+  for (size_t at = code.find("BOUNDS"); at != std::string::npos;
+       at = code.find("BOUNDS", at + 1)) {
+    ++checks;
+  }
+  REQUIRE(checks == 3);
+
+  FlatAst flat;
+  flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+  REQUIRE(flat.check());
+  REQUIRE(unflatten(flat)->str() == parser.get_AST()->str());
+  SymbolTable flat_st;
+  Data flat_data(flat_st);
+  TAC flat_tac;
+  flat_icg(flat, flat_data, flat_tac);
+  std::ostringstream os;
+  flat_tac.output(os);
+  REQUIRE(os.str() == code);
+
+  FILE* fin = tmpfile();
+  fputs(src.c_str(), fin);
+  rewind(fin);
+  REQUIRE(get_tac(fin, true) == code);
+  fclose(fin);
+
+  std::string bad =
+      "class C {\n"
+      "  int a[4];\n"
+      "  int x;\n"
+      "  static void main() { a[4] = 1; x = a; x[0] = 2; }\n"
+      "}\n";
+  BParser bad_parser(bad.data(), bad.size(), 1, 1, false, false);
+  REQUIRE(bad_parser.parse() == 0);
+  SymbolTable bad_st;
+  Data bad_data(bad_st);
+  TAC bad_tac;
+  bad_parser.get_AST()->icg(bad_data, bad_tac);
+  REQUIRE(bad_data.error_count == 3);
+}
+
+TEST_CASE("bitwise operators bind as in C") {
+  std::string src =
+      "class C {\n"
+      "  static int f(int a, int b) { return a | b ^ a & b << 1 + ~b; }\n"
+      "  static void main() { writeln(f(6, 3) >> 1 & 1 == 1); }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  HParser handmade(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(handmade.parse() == 0);
+  std::string ast = parser.get_AST()->str();
+  REQUIRE(handmade.get_AST()->str() == ast);
+  std::string squeezed;
+  for (char c : ast) {
+    if (c != ' ' && c != '\n') {
+      squeezed += c;
+    }
+  }
+  REQUIRE(squeezed.find("(|(VARa)(^(VARb)(&(VARa)(<<(VARb)(+(NUM1)(~(VARb)"
+                        "))))))") != std::string::npos);
+  REQUIRE(squeezed.find("(&(>>(CALLf(NUM6)(NUM3))(NUM1))(==(NUM1)(NUM1)))") !=
+          std::string::npos);
+
+  SymbolTable st;
+  Data data(st);
+  TAC tac;
+  parser.get_AST()->icg(data, tac);
+  REQUIRE(data.error_count == 0);
+  REQUIRE(data.diagnostics.size() == 0);
+  std::ostringstream expected;
+  tac.output(expected);
+  REQUIRE(expected.str().find("SHR") != std::string::npos);
+  REQUIRE(expected.str().find("BITNOT") != std::string::npos);
+
+  FlatAst flat;
+  flatten(static_cast<ProgramNode*>(parser.get_AST()), flat);
+  REQUIRE(flat.check());
+  REQUIRE(unflatten(flat)->str() == ast);
+  SymbolTable flat_st;
+  Data flat_data(flat_st);
+  TAC flat_tac;
+  flat_icg(flat, flat_data, flat_tac);
+  std::ostringstream os;
+  flat_tac.output(os);
+  REQUIRE(os.str() == expected.str());
+
+  FILE* fin = tmpfile();
+  fputs(src.c_str(), fin);
+  rewind(fin);
+  REQUIRE(get_tac(fin, true) == expected.str());
+  fclose(fin);
+}
+
+TEST_CASE("tac operands are interned into compact quads") {
+  TAC tac;
+  tac.append(TAC::InstrType::VAR, "x");
+  std::string t12 = tac.tmp_variable_name(12);
+  tac.append(TAC::InstrType::ADD, "x", "1", t12);
+  tac.label_next_instr("lab_loop_0");
+  tac.append(TAC::InstrType::LT, t12, "x", "lab_loop_0");
+  REQUIRE(tac.program().size() == 3);
+  TAC::Quad add = tac.program()[1];
+  REQUIRE(TAC::operand_kind(add.param1) == TAC::OperandKind::Variable);
+  REQUIRE(TAC::operand_kind(add.param2) == TAC::OperandKind::Constant);
+  REQUIRE(TAC::operand_kind(add.result) == TAC::OperandKind::Temp);
+  REQUIRE(TAC::operand_index(add.result) == 12);
+  REQUIRE(tac.name(add.label).empty());
+  TAC::Quad lt = tac.program()[2];
+  REQUIRE(TAC::operand_kind(lt.label) == TAC::OperandKind::Label);
+  REQUIRE(lt.result == lt.label);
+  REQUIRE(tac.name(add.param1) == "x");
+  REQUIRE(tac.name(add.param2) == "1");
+  REQUIRE(tac.name(add.result) == "t12");
+
+  // Spliced code keeps its text though its names are numbered anew.
+  TAC other;
+  other.append(TAC::InstrType::ASSIGN, "2", "y");
+  other.append(TAC::InstrType::ADD, "y", "1", "x");
+  std::ostringstream expected;
+  tac.output(expected);
+  other.output(expected);
+  tac.splice(other);
+  REQUIRE(other.program().empty());
+  REQUIRE(tac.program().size() == 5);
+  REQUIRE(tac.program()[4].param1 == tac.program()[3].result);
+  REQUIRE(tac.program()[4].param2 == add.param2);
+  REQUIRE(tac.program()[4].result == add.param1);
+  std::ostringstream os;
+  tac.output(os);
+  REQUIRE(os.str() == expected.str());
+
+  // A variable spelled like a temporary is still a variable.
+  std::string src =
+      "class C {\n"
+      "  static void main() { int t1; t1 = 2 * t1; }\n"
+      "}\n";
+  BParser parser(src.data(), src.size(), 1, 1, false, false);
+  REQUIRE(parser.parse() == 0);
+  SymbolTable st;
+  Data data(st);
+  TAC code;
+  parser.get_AST()->icg(data, code);
+  REQUIRE(data.error_count == 0);
+  const TAC::Quad& assign = code.program()[code.program().size() - 2];
+  REQUIRE(assign.type == TAC::InstrType::ASSIGN);
+  REQUIRE(TAC::operand_kind(assign.param1) == TAC::OperandKind::Temp);
+  REQUIRE(TAC::operand_kind(assign.result) == TAC::OperandKind::Variable);
+  REQUIRE(code.name(assign.result) == "t1");
+}
+
+TEST_CASE("tac text is written in right-aligned columns") {
+  TAC tac;
+  tac.label_next_instr("main");
+  tac.append(TAC::InstrType::VAR, "t0");
+  tac.label_next_instr("lab_a_very_long_label_0");
+  tac.append(TAC::InstrType::ADD, "a_very_long_variable", "12.5", "t123");
+  std::string expected =
+      "            main:     VAR                                        "
+      "               t0\n"
+      "lab_a_very_long_label_0:     ADD  a_very_long_variable"
+      "               12.5               t123\n";
+  std::ostringstream os;
+  tac.output(os);
+  REQUIRE(os.str() == expected);
+
+  FILE* fout = tmpfile();
+  tac.output(fout);
+  rewind(fout);
+  std::string text;
+  for (int c = fgetc(fout); c != EOF; c = fgetc(fout)) {
+    text.push_back(static_cast<char>(c));
+  }
+  fclose(fout);
+  REQUIRE(text == expected);
+}
+
+TEST_CASE("code read from stdin goes alone to stdout") {
+  std::string src =
+      "class C {\n"
+      "  int a;\n"
+      "  static void main() { a = 2 * 1.5; writeln(a); }\n"
+      "}\n";
+  char filename[] = "/tmp/decafXXXXXX";
+  int fd = mkstemp(filename);
+  REQUIRE(fd != -1);
+  REQUIRE(write(fd, src.data(), src.size()) == ssize_t(src.size()));
+  close(fd);
+  FILE* fin = fopen(filename, "r");
+  std::string expected = get_tac(fin, false);
+  rewind(fin);
+  std::string typed = get_tac(fin, false, true);
+  fclose(fin);
+
+  // Whatever else is written, such as the warning about mixing int and
+  // real, the AST or the symbol table, goes to stderr.
+  for (auto option : {"x", "-s", "-a", "-d", "-p", "-t"}) {
+    std::string command = std::string(DECAFCOMP_PATH) + " " + option +
+                          " - < " + filename + " 2> /dev/null";
+    FILE* pipe = popen(command.c_str(), "r");
+    REQUIRE(pipe != nullptr);
+    std::string out;
+    char buffer[4096];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), pipe)) > 0;) {
+      out.append(buffer, n);
+    }
+    REQUIRE(pclose(pipe) == 0);
+    REQUIRE(out == (std::string(option) == "-t" ? typed : expected));
+  }
+  unlink(filename);
+}